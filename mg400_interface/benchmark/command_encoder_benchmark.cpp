@@ -0,0 +1,104 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Formatting cost of a MovJ command until it is handed to the transport:
+// the former snprintf() into a buffer turned into a std::string, against
+// CommandEncoder into a stack buffer handed over as a std::string_view.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include <mg400_interface/command_utils.hpp>
+#include <mg400_interface/commander/command_encoder.hpp>
+#include <mg400_interface/commander/motion_commander.hpp>
+
+using mg400_interface::CommandBuffer;
+using mg400_interface::CommandEncoder;
+using mg400_interface::m2mm;
+using mg400_interface::rad2degree;
+
+constexpr char MOV_J[] = "MovJ";
+using MovJCommand = CommandEncoder<MOV_J, double, double, double, double, double, double>;
+
+// Keeps the command from being optimized away, like a socket would
+class NullTcpInterface : public mg400_interface::MotionTcpInterfaceBase
+{
+public:
+  size_t bytes = 0;
+
+  void sendCommand(const std::string & cmd) override
+  {
+    this->bytes += cmd.size();
+    benchmark::DoNotOptimize(cmd.data());
+  }
+
+  void sendCommandView(const std::string_view cmd) override
+  {
+    this->bytes += cmd.size();
+    benchmark::DoNotOptimize(cmd.data());
+  }
+};
+
+static void BM_Snprintf(benchmark::State & state)
+{
+  NullTcpInterface tcp_if;
+  double x = 0.2;
+  for (auto _ : state) {
+    char buf[100];
+    snprintf(
+      buf, sizeof(buf),
+      "MovJ(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf)",
+      m2mm(x), m2mm(-0.1), m2mm(0.05),
+      rad2degree(1.2), rad2degree(0.0), rad2degree(0.0));
+    tcp_if.sendCommand(buf);
+    x += 1e-6;
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(tcp_if.bytes));
+}
+BENCHMARK(BM_Snprintf);
+
+static void BM_CommandEncoder(benchmark::State & state)
+{
+  NullTcpInterface tcp_if;
+  double x = 0.2;
+  for (auto _ : state) {
+    CommandBuffer buf;
+    tcp_if.sendCommandView(
+      MovJCommand::encode(
+        buf, m2mm(x), m2mm(-0.1), m2mm(0.05),
+        rad2degree(1.2), rad2degree(0.0), rad2degree(0.0)));
+    x += 1e-6;
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(tcp_if.bytes));
+}
+BENCHMARK(BM_CommandEncoder);
+
+// Through MotionCommander, as the plugins call it
+static void BM_MotionCommander(benchmark::State & state)
+{
+  NullTcpInterface tcp_if;
+  mg400_interface::MotionCommander commander(&tcp_if);
+  double x = 0.2;
+  for (auto _ : state) {
+    commander.movJ(x, -0.1, 0.05, 1.2);
+    x += 1e-6;
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(tcp_if.bytes));
+}
+BENCHMARK(BM_MotionCommander);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,189 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Command round trip time against a local controller emulator for each socket profile.
+// "single" waits for every reply before sending the next command,
+// "pair" sends two commands back to back. The emulator keeps Nagle's algorithm enabled
+// like a stock controller, so its second reply waits for our (delayed) ACK unless
+// TCP_QUICKACK is set.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <mg400_interface/tcp_interface/tcp_socket_handler.hpp>
+
+using mg400_interface::SocketProfile;
+using mg400_interface::TcpSocketHandler;
+
+// Replies "0,{},<command>;" to every command like the MG400 dashboard does.
+class ControllerEmulator
+{
+private:
+  int listen_fd_;
+  uint16_t port_;
+  std::atomic<bool> is_running_;
+  std::thread thread_;
+
+public:
+  ControllerEmulator()
+  : listen_fd_(::socket(AF_INET, SOCK_STREAM, 0)), port_(0), is_running_(true)
+  {
+    const int yes = 1;
+    ::setsockopt(this->listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(this->listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    ::listen(this->listen_fd_, 4);
+    socklen_t len = sizeof(addr);
+    ::getsockname(this->listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    this->port_ = ntohs(addr.sin_port);
+    this->thread_ = std::thread(&ControllerEmulator::run, this);
+  }
+
+  ~ControllerEmulator()
+  {
+    this->is_running_.store(false);
+    ::shutdown(this->listen_fd_, SHUT_RDWR);
+    ::close(this->listen_fd_);
+    this->thread_.join();
+  }
+
+  uint16_t port() const {return this->port_;}
+
+private:
+  void run()
+  {
+    while (this->is_running_.load()) {
+      const int fd = ::accept(this->listen_fd_, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      std::string pending;
+      char buf[256];
+      ssize_t len;
+      while ((len = ::recv(fd, buf, sizeof(buf), 0)) > 0) {
+        pending.append(buf, len);
+        size_t end;
+        while ((end = pending.find(')')) != std::string::npos) {
+          const std::string reply = "0,{}," + pending.substr(0, end + 1) + ";";
+          ::send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+          pending.erase(0, end + 1);
+        }
+      }
+      ::close(fd);
+    }
+  }
+};
+
+struct Result
+{
+  double mean;
+  double p50;
+  double p99;
+};
+
+static Result measure(
+  TcpSocketHandler & socket, const std::string & command,
+  const int commands_per_round, const int rounds)
+{
+  using namespace std::chrono_literals;  // NOLINT
+  const size_t reply_len = commands_per_round * (command.size() + 6);
+  std::vector<char> reply(reply_len);
+  std::vector<double> samples;
+  samples.reserve(rounds);
+
+  for (int i = 0; i < rounds; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int j = 0; j < commands_per_round; ++j) {
+      socket.send(command.data(), command.size());
+    }
+    if (!socket.recv(reply.data(), reply_len, 1s)) {
+      throw mg400_interface::TcpSocketException("Emulator not responded.");
+    }
+    samples.push_back(
+      std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.0;
+  for (const auto sample : samples) {
+    sum += sample;
+  }
+  return Result{
+    sum / samples.size(),
+    samples[samples.size() / 2],
+    samples[samples.size() * 99 / 100]};
+}
+
+int main(int argc, char ** argv)
+{
+  using namespace std::chrono_literals;  // NOLINT
+  const int rounds = argc > 1 ? std::stoi(argv[1]) : 200;
+  const std::string command = "MovJ(200.000,0.000,0.000,0.000)";
+
+  std::vector<std::pair<std::string, SocketProfile>> profiles;
+  profiles.emplace_back("default", SocketProfile());
+  SocketProfile profile;
+  profile.tcp_nodelay = true;
+  profiles.emplace_back("nodelay", profile);
+  profile.tcp_quickack = true;
+  profiles.emplace_back("nodelay+quickack", profile);
+  profile.tcp_quickack = false;
+  profile.busy_poll = 50;
+  profiles.emplace_back("nodelay+busy_poll", profile);
+  profile.busy_poll = 0;
+  profile.rcvbuf = 4096;
+  profile.sndbuf = 4096;
+  profiles.emplace_back("nodelay+small_buffers", profile);
+
+  ControllerEmulator emulator;
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  printf("%d rounds of \"%s\" [us]\n", rounds, command.c_str());
+  printf(
+    "%-22s %-6s %9s %9s %9s %9s\n", "profile", "mode", "mean", "p50", "p99", "vs default");
+
+  for (const int commands_per_round : {1, 2}) {
+    const char * mode = commands_per_round == 1 ? "single" : "pair";
+    double baseline = 0.0;
+    for (const auto & entry : profiles) {
+      TcpSocketHandler socket("127.0.0.1", emulator.port());
+      socket.setProfile(entry.second);
+      socket.connect(1s);
+
+      measure(socket, command, commands_per_round, rounds / 10);  // warm up
+      const auto result = measure(socket, command, commands_per_round, rounds);
+      if (baseline == 0.0) {
+        baseline = result.mean;
+      }
+      printf(
+        "%-22s %-6s %9.1f %9.1f %9.1f %+9.1f\n", entry.first.c_str(), mode,
+        result.mean, result.p50, result.p99, result.mean - baseline);
+      socket.disConnect();
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -25,11 +25,13 @@ int main(int argc, char ** argv)
 
   std::cout << "Connecting to: " << ip << std::endl;
 
+  auto reactor = std::make_shared<mg400_interface::IoReactor>();
   auto rt_tcp_if =
-    std::make_unique<mg400_interface::RealtimeFeedbackTcpInterface>(ip);
+    std::make_unique<mg400_interface::RealtimeFeedbackTcpInterface>(ip, reactor);
   auto db_tcp_if =
-    std::make_unique<mg400_interface::DashboardTcpInterface>(ip);
+    std::make_unique<mg400_interface::DashboardTcpInterface>(ip, reactor);
 
+  reactor->start();
   rt_tcp_if->init();
   db_tcp_if->init();
 
@@ -0,0 +1,126 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace mg400_interface
+{
+// Fixed buffer a command is encoded into, e.g. on the stack of the caller
+using CommandBuffer = std::array<char, 128>;
+
+// Optional parameter, written as "KEY=value" (e.g. CP=50)
+template<const char * KEY, typename T>
+struct NamedParam
+{
+  static constexpr std::string_view KEY_NAME = KEY;
+  T value;
+};
+
+template<typename T>
+struct IsNamedParam : std::false_type {};
+template<const char * KEY, typename T>
+struct IsNamedParam<NamedParam<KEY, T>> :  std::true_type {};
+
+// Encodes "Name(arg,...)" without allocating. Doubles are written as "%.3lf"
+// would, integers as "%d", std::array<int, N> as "{a,b,...}", std::string_view
+// as is and NamedParam as "KEY=value". The name and the parameter types are
+// fixed at compile time, so the number and kind of arguments are checked by
+// the compiler.
+//
+//   inline constexpr char SYNC[] = "Sync";
+//   CommandBuffer buf;
+//   CommandEncoder<SYNC>::encode(buf);  // "Sync()"
+template<const char * NAME, typename ... Params>
+class CommandEncoder
+{
+public:
+  static constexpr std::string_view COMMAND_NAME = NAME;
+
+  // Throws std::runtime_error if the buffer is too small
+  static std::string_view encode(CommandBuffer & buf, const Params ... params)
+  {
+    char * const first = buf.data();
+    char * const last = buf.data() + buf.size();
+    char * cursor = writeText(first, last, COMMAND_NAME);
+    cursor = writeText(cursor, last, "(");
+    [[maybe_unused]] bool is_first = true;
+    ((cursor = writeParam(cursor, last, params, is_first)), ...);
+    cursor = writeText(cursor, last, ")");
+    return std::string_view(first, static_cast<size_t>(cursor - first));
+  }
+
+private:
+  template<typename T>
+  static char * writeParam(char * cursor, char * const last, const T & value, bool & is_first)
+  {
+    if (!is_first) {
+      cursor = writeText(cursor, last, ",");
+    }
+    is_first = false;
+    return writeValue(cursor, last, value);
+  }
+
+  template<typename T>
+  static char * writeValue(char * cursor, char * const last, const T & value)
+  {
+    if constexpr (std::is_floating_point_v<T>) {
+      return check(std::to_chars(cursor, last, value, std::chars_format::fixed, 3));
+    } else if constexpr (std::is_integral_v<T>) {
+      // uint8_t message fields are numbers, not characters
+      return check(std::to_chars(cursor, last, static_cast<int64_t>(value)));
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+      return writeText(cursor, last, value);
+    } else if constexpr (IsNamedParam<T>::value) {
+      cursor = writeText(cursor, last, T::KEY_NAME);
+      cursor = writeText(cursor, last, "=");
+      return writeValue(cursor, last, value.value);
+    } else {
+      // std::array
+      cursor = writeText(cursor, last, "{");
+      for (size_t i = 0; i < value.size(); ++i) {
+        if (i > 0) {
+          cursor = writeText(cursor, last, ",");
+        }
+        cursor = writeValue(cursor, last, value[i]);
+      }
+      return writeText(cursor, last, "}");
+    }
+  }
+
+  static char * writeText(char * cursor, char * const last, const std::string_view text)
+  {
+    if (static_cast<size_t>(last - cursor) < text.size()) {
+      throw std::runtime_error("Command exceeds buffer: " + std::string(COMMAND_NAME));
+    }
+    std::memcpy(cursor, text.data(), text.size());
+    return cursor + text.size();
+  }
+
+  static char * check(const std::to_chars_result result)
+  {
+    if (result.ec != std::errc()) {
+      throw std::runtime_error("Command exceeds buffer: " + std::string(COMMAND_NAME));
+    }
+    return result.ptr;
+  }
+};
+}  // namespace mg400_interface
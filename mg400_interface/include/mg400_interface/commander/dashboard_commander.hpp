@@ -15,6 +15,8 @@
 #pragma once
 
 #include <array>
+#include <functional>
+#include <future>
 #include <vector>
 #include <string>
 #include <memory>
@@ -29,9 +31,13 @@
 #include <mg400_msgs/msg/user.hpp>
 #include <rclcpp/rclcpp.hpp>
 
+#include "mg400_interface/commander/dashboard_pipeline.hpp"
+#include "mg400_interface/commander/latency_stats.hpp"
 #include "mg400_interface/commander/response_parser.hpp"
+#include "mg400_interface/commander/settings_cache.hpp"
 #include "mg400_interface/command_utils.hpp"
 #include "mg400_interface/tcp_interface/dashboard_tcp_interface.hpp"
+#include "mg400_interface/tcp_interface/realtime_feedback_tcp_interface.hpp"
 
 namespace mg400_interface
 {
@@ -42,6 +48,21 @@ class DashboardCommander
 {
 public:
   using SharedPtr = std::shared_ptr<DashboardCommander>;
+  // Receives a ready future: get() returns the result or throws what the
+  // blocking overload would have thrown. Runs on the dashboard I/O thread,
+  // or on the calling thread when answered locally (settings cache, feedback).
+  template<typename T>
+  using Callback = std::function<void (std::future<T>)>;
+  using FeedbackSource = std::function<RealtimeFeedbackTcpInterface::Snapshot()>;
+
+  // Outcome of one command of a batch
+  struct BatchResult
+  {
+    bool ok;  // answered with error id 0
+    std::string response;  // raw, empty if none came
+    std::string error;  // why it is not ok
+  };
+  using BatchCallback = std::function<void (std::vector<BatchResult>)>;
 
 private:
   using ArchIndex = mg400_msgs::msg::Arch;
@@ -53,8 +74,18 @@ private:
   using ToolDOIndex = mg400_msgs::msg::ToolDOIndex;
   using User = mg400_msgs::msg::User;
 
+  template<typename T>
+  using Parser = std::function<T(const std::string &)>;
+
   DashboardTcpInterfaceBase * tcp_if_;
-  rclcpp::Clock::SharedPtr clock_;
+  std::function<uint64_t()> count_mode_changes_;
+  FeedbackSource feedback_source_;
+  std::chrono::nanoseconds feedback_max_age_;
+  // Declared before the pipeline: its callbacks may still store settings
+  // and record latencies
+  SettingsCache::UniquePtr settings_;
+  LatencyStats::UniquePtr latency_;
+  DashboardPipeline::UniquePtr pipeline_;
   const std::chrono::nanoseconds TIMEOUT;
 
 public:
@@ -64,25 +95,38 @@ public:
     const std::chrono::nanoseconds = 5s);
 
   // DOBOT MG400 Official Command ---------------------------------------------
+  // Every command also has an overload taking a Callback, which returns at once.
   void enableRobot() const;
+  void enableRobot(const Callback<void> &) const;
 
+  // Sent ahead of every queued command, like emergencyStop()
   void disableRobot() const;
+  void disableRobot(const Callback<void> &) const;
 
   void clearError() const;
+  void clearError(const Callback<void> &) const;
 
   void resetRobot() const;
+  void resetRobot(const Callback<void> &) const;
 
   void speedFactor(const int) const;
+  void speedFactor(const int, const Callback<void> &) const;
 
   void user(const User &) const;
   void user(const User::_user_type &) const;
+  void user(const User &, const Callback<void> &) const;
+  void user(const User::_user_type &, const Callback<void> &) const;
 
   void tool(const Tool &) const;
   void tool(const Tool::_tool_type &) const;
+  void tool(const Tool &, const Callback<void> &) const;
+  void tool(const Tool::_tool_type &, const Callback<void> &) const;
 
   uint64_t robotMode() const;
+  void robotMode(const Callback<uint64_t> &) const;
 
   void payload(const double, const double) const;
+  void payload(const double, const double, const Callback<void> &) const;
 
   void DO(
     const DOIndex &,
@@ -90,6 +134,12 @@ public:
   void DO(
     const DOIndex::_index_type &,
     const DOStatus::_status_type &) const;
+  void DO(
+    const DOIndex &,
+    const DOStatus &, const Callback<void> &) const;
+  void DO(
+    const DOIndex::_index_type &,
+    const DOStatus::_status_type &, const Callback<void> &) const;
 
   void toolDOExecute(
     const ToolDOIndex &,
@@ -97,63 +147,182 @@ public:
   void toolDOExecute(
     const ToolDOIndex::_index_type &,
     const DOStatus::_status_type &) const;
+  void toolDOExecute(
+    const ToolDOIndex &,
+    const DOStatus &, const Callback<void> &) const;
+  void toolDOExecute(
+    const ToolDOIndex::_index_type &,
+    const DOStatus::_status_type &, const Callback<void> &) const;
 
   void accJ(const int);
+  void accJ(const int, const Callback<void> &);
 
   void accL(const int);
+  void accL(const int, const Callback<void> &);
 
   void speedJ(const int);
+  void speedJ(const int, const Callback<void> &);
 
   void speedL(const int);
+  void speedL(const int, const Callback<void> &);
 
   void arch(const ArchIndex &);
   void arch(const ArchIndex::_index_type &);
+  void arch(const ArchIndex &, const Callback<void> &);
+  void arch(const ArchIndex::_index_type &, const Callback<void> &);
 
   void cp(const int);
-/*
-  void runScript(const std::string &);
+  void cp(const int, const Callback<void> &);
+
+  // Returns once the controller accepted the script, not when it finished.
+  // The robot mode is RUNNING while it runs and PAUSE while paused.
+  void runScript(const std::string &) const;
+  void runScript(const std::string &, const Callback<void> &) const;
+
+  void stopScript() const;
+  void stopScript(const Callback<void> &) const;
 
-  void stopScript();
+  void pauseScript() const;
+  void pauseScript(const Callback<void> &) const;
 
-  void pauseScript();
+  void continueScript() const;
+  void continueScript(const Callback<void> &) const;
 
-  void continueScript();
-*/
   void setCollisionLevel(const CollisionLevel &);
   void setCollisionLevel(const CollisionLevel::_level_type &);
+  void setCollisionLevel(const CollisionLevel &, const Callback<void> &);
+  void setCollisionLevel(const CollisionLevel::_level_type &, const Callback<void> &);
 
   std::vector<double> getAngle();
+  void getAngle(const Callback<std::vector<double>> &);
 
   std::vector<double> getPose();
+  void getPose(const Callback<std::vector<double>> &);
 
+  // Sent ahead of every queued command
   void emergencyStop();
-/*
-  int modbusCreate(const std::string &, const int, const int, const int);
+  void emergencyStop(const Callback<void> &);
 
-  bool modbusClose(const std::string &);
+  // Returns the index of the new Modbus master, used by every other Modbus call
+  int modbusCreate(const std::string &, const int, const int, const bool = false) const;
+  void modbusCreate(
+    const std::string &, const int, const int, const bool,
+    const Callback<int> &) const;
 
-  std::vector<int> getInBits(const int, const int, const int);
+  void modbusClose(const int) const;
+  void modbusClose(const int, const Callback<void> &) const;
 
-  std::vector<int> getInRegs(const int, const int, const int, const std::string & = "U16");
+  std::vector<int> getInBits(const int, const int, const int) const;
+  void getInBits(const int, const int, const int, const Callback<std::vector<int>> &) const;
 
-  std::vector<int> getCoils(const int, const int, const int);
+  std::vector<int> getInRegs(
+    const int, const int, const int, const std::string & = "U16") const;
+  void getInRegs(
+    const int, const int, const int, const std::string &,
+    const Callback<std::vector<int>> &) const;
 
-  int setCoils(const int, const int, const int, const std::string &);
+  std::vector<int> getCoils(const int, const int, const int) const;
+  void getCoils(const int, const int, const int, const Callback<std::vector<int>> &) const;
 
-  std::vector<int> getHoldRegs(const int, const int, const int, const std::string & = "U16");
+  void setCoils(const int, const int, const std::vector<int> &) const;
+  void setCoils(
+    const int, const int, const std::vector<int> &, const Callback<void> &) const;
+
+  std::vector<int> getHoldRegs(
+    const int, const int, const int, const std::string & = "U16") const;
+  void getHoldRegs(
+    const int, const int, const int, const std::string &,
+    const Callback<std::vector<int>> &) const;
+
+  void setHoldRegs(
+    const int, const int, const std::vector<int> &, const std::string & = "U16") const;
+  void setHoldRegs(
+    const int, const int, const std::vector<int> &, const std::string &,
+    const Callback<void> &) const;
 
-  int setHoldRegs(const int, const int, const int, const std::string &, const std::string &);
-*/
   std::array<std::vector<int>, 6> getErrorId() const;
+  void getErrorId(const Callback<std::array<std::vector<int>, 6>> &) const;
 
   int DI(const DIIndex &) const;
   int DI(const DIIndex::_index_type &) const;
+  void DI(const DIIndex &, const Callback<int> &) const;
+  void DI(const DIIndex::_index_type &, const Callback<int> &) const;
 
   // --------------------------------------------------------------------------
 
+  // Pipelining: submit several commands first, then wait for each response.
+  // N commands cost about one round trip instead of N.
+  DashboardPipeline::Request::SharedPtr submit(
+    const std::string &,
+    const DashboardPipeline::Priority = DashboardPipeline::Priority::NORMAL) const;
+  // Raw response of a submitted command. Throws std::runtime_error on timeout.
+  std::string wait(const DashboardPipeline::Request::SharedPtr &) const;
+  // Dispatch latency of emergencyStop() and disableRobot()
+  DashboardPipeline::DispatchStats getUrgentDispatchStats() const;
+
+  // Settings cache ------------------------------------------------------------
+  // SpeedFactor, User, Tool, PayLoad, AccJ, AccL, SpeedJ, SpeedL, Arch, CP and
+  // SetCollisionLevel are not sent again while the same value is in effect.
+  // The cache is dropped on reconnection, ClearError, ResetRobot and whenever
+  // the count of controller mode changes moves. Set the counter before use.
+  void setModeChangeCounter(const std::function<uint64_t()> &);
+  void invalidateSettings() const;
+  SettingsCache::Stats getSettingsCacheStats() const;
+
+  // Batch -------------------------------------------------------------------
+  // Raw commands such as "SpeedFactor(50)" are written in a single write, in
+  // order, and every response is waited for. The settings cache is kept up to
+  // date but never skips a command of a batch.
+  std::vector<BatchResult> sendBatch(const std::vector<std::string> &) const;
+  // The callback receives every result at once, on the dashboard I/O thread
+  void sendBatch(const std::vector<std::string> &, const BatchCallback &) const;
+
+  // Latency -----------------------------------------------------------------
+  // Round trip of every command sent on its own, from submission to response,
+  // per function name. Timed out commands are only counted.
+  std::vector<std::pair<std::string, LatencyHistogram::Summary>> getLatencyStats() const;
+
+  // Feedback queries --------------------------------------------------------
+  // getPose(), getAngle(), robotMode() and DI() are answered from realtime
+  // feedback received within max_age, falling back to the dashboard when it is
+  // older or missing. Set the source before use.
+  void setFeedbackSource(const FeedbackSource &, const std::chrono::nanoseconds max_age);
+
 private:
   static const rclcpp::Logger getLogger();
-  std::string sendAndWaitResponse(const std::string &) const;
-  void evaluateResponse(const std::string &) const;
+  std::string sendAndWaitResponse(
+    const std::string &,
+    const DashboardPipeline::Priority = DashboardPipeline::Priority::NORMAL) const;
+  template<typename T>
+  void sendAsync(
+    const std::string &, const Parser<T> &, const Callback<T> &,
+    const DashboardPipeline::Priority = DashboardPipeline::Priority::NORMAL) const;
+
+  uint64_t getSettingsEpoch() const;
+  void sendSetting(const std::string &) const;
+  void sendSetting(const std::string &, const Callback<void> &) const;
+  std::vector<uint64_t> prepareBatch(const std::vector<std::string> &) const;
+  static bool isSetting(const std::string &);
+  static BatchResult takeBatchResult(const std::string &, std::exception_ptr);
+  bool takeFreshFeedback(RealtimeFeedbackTcpInterface::Snapshot &) const;
+  template<typename T>
+  static void answer(const Callback<T> &, T);
+
+  void recordLatency(
+    LatencyHistogram &, const DashboardPipeline::SteadyClock::time_point &,
+    const std::string &, const bool is_failed) const;
+
+  static void evaluateResponse(const std::string &);
+  static uint64_t takeRobotMode(const std::string &);
+  static int takeInt(const std::string &);
+  static std::vector<int> takeIntArray(const std::string &);
+  static std::string joinValues(const std::vector<int> &);
+  // snprintf into a string sized to fit, for commands carrying caller strings
+  static std::string formatCommand(const char *, ...) __attribute__((format(printf, 1, 2)));
+  static std::vector<double> takeAngle(const std::string &);
+  static std::vector<double> takePose(const std::string &);
+  static std::array<std::vector<int>, 6> takeErrorId(const std::string &);
+  static std::vector<double> poseFromFeedback(const RealtimeFeedbackTcpInterface::Snapshot &);
+  static std::vector<double> angleFromFeedback(const RealtimeFeedbackTcpInterface::Snapshot &);
 };
 }  // namespace mg400_interface
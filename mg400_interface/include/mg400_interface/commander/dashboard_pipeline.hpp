@@ -0,0 +1,156 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include "mg400_interface/mpsc_queue.hpp"
+#include "mg400_interface/tcp_interface/dashboard_tcp_interface.hpp"
+
+namespace mg400_interface
+{
+// Keeps any number of dashboard commands in flight on one connection.
+//
+// The controller answers in the order commands were sent, so responses are
+// matched to the oldest pending request after checking the echoed function name.
+// Whichever waiting caller finds nobody receiving reads the next response
+// and completes the request it belongs to, which may be another caller's.
+// Once a request is submitted with a callback, a dedicated I/O thread takes over
+// receiving and runs the callbacks, so nobody has to wait.
+// A request timed out keeps its place so that its late response is dropped.
+// Everything in flight fails once receiving fails or the connection is renewed.
+//
+// Any number of threads may submit. Requests go through a lock-free queue and
+// whichever submitter finds nobody sending writes them to the socket in order.
+// Urgent requests (e.g. EmergencyStop) have a lane of their own and are written
+// before anything still queued, at most one write behind the one in progress.
+class DashboardPipeline
+{
+public:
+  using UniquePtr = std::unique_ptr<DashboardPipeline>;
+  using SteadyClock = std::chrono::steady_clock;
+
+  enum class Priority {NORMAL, URGENT};
+
+  // Time from submit() to the command being written, for urgent requests
+  struct DispatchStats
+  {
+    size_t count;
+    SteadyClock::duration last;
+    SteadyClock::duration max;
+  };
+
+  class Request
+  {
+  public:
+    using SharedPtr = std::shared_ptr<Request>;
+    // Called once with the raw response, or with the error wait() would throw
+    using Callback = std::function<void (const std::string &, std::exception_ptr)>;
+
+    const std::string command;
+    const std::string function;  // e.g. "SpeedFactor" for "SpeedFactor(50)"
+
+    explicit Request(const std::string &);
+
+  private:
+    friend class DashboardPipeline;
+    enum class State {PENDING, DONE, FAILED};
+    State state_;
+    Priority priority_;
+    SteadyClock::time_point submitted_at_;
+    std::string response_;
+    std::exception_ptr error_;
+    Callback callback_;
+    SteadyClock::time_point deadline_;
+    std::atomic<bool> is_notified_;
+    bool is_abandoned_;  // timed out: nobody takes the response any more
+  };
+
+private:
+  DashboardTcpInterfaceBase * tcp_if_;
+  // Requests written to the socket in one go
+  using Batch = std::vector<Request::SharedPtr>;
+
+  MpscQueue<Batch> submitted_;
+  MpscQueue<Batch> urgent_;
+  std::atomic<bool> is_sending_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request::SharedPtr> in_flight_;
+  // Of the tcp interface when in_flight_ was last filled
+  uint64_t connections_;
+  DispatchStats urgent_stats_;
+  bool is_receiving_;
+  bool is_stopping_;
+  std::thread io_thread_;
+
+public:
+  DashboardPipeline() = delete;
+  explicit DashboardPipeline(DashboardTcpInterfaceBase *);
+  ~DashboardPipeline();
+
+  static rclcpp::Logger getLogger();
+
+  // Sends the command without waiting for its response.
+  // A failure to send is reported by wait().
+  Request::SharedPtr submit(const std::string &, const Priority = Priority::NORMAL);
+  // The callback runs on the I/O thread, or on a submitting thread if sending fails.
+  // It is called with a timeout error if no response comes before the deadline.
+  void submit(
+    const std::string &, const Request::Callback &, const SteadyClock::time_point &,
+    const Priority = Priority::NORMAL);
+  // Written to the socket in a single write, in this order.
+  // Each request is matched and waited for like a single one.
+  std::vector<Request::SharedPtr> submitBatch(const std::vector<std::string> &);
+  // Called once per command with its index in the batch
+  using BatchCallback = std::function<void (size_t, const std::string &, std::exception_ptr)>;
+  void submitBatch(
+    const std::vector<std::string> &, const BatchCallback &, const SteadyClock::time_point &);
+  // Returns the raw response of the request.
+  // Throws std::runtime_error if it does not come before the deadline.
+  std::string wait(const Request::SharedPtr &, const SteadyClock::time_point &);
+  size_t countInFlight();
+  DispatchStats getUrgentDispatchStats();
+
+  // Name of the function called by a command or echoed in a response
+  static std::string takeFunctionName(const std::string &);
+
+private:
+  void startIoThread();
+  void enqueue(Batch);
+  void flush();
+  bool popNext(Batch &);
+  void send(const Batch &);
+  void failStale(std::vector<Request::SharedPtr> &);
+  void recordDispatch(const Request::SharedPtr &);
+  void run();
+  void complete(const std::string &, std::vector<Request::SharedPtr> &);
+  void fail(const std::exception_ptr &, std::vector<Request::SharedPtr> &);
+  void expire(const SteadyClock::time_point &, std::vector<Request::SharedPtr> &);
+  static void notify(const std::vector<Request::SharedPtr> &);
+};
+}  // namespace mg400_interface
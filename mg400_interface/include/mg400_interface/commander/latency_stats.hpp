@@ -0,0 +1,109 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mg400_interface
+{
+// Log-linear latency histogram in microseconds, as in HdrHistogram: every
+// power of two is split into 8 linear buckets, so a value is known within 12.5%.
+// Recording is lock-free and wait-free.
+class LatencyHistogram
+{
+public:
+  static constexpr int SUB_BUCKET_BITS = 3;
+  static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  // Up to 2^32 us, about 71 minutes. Longer is counted in the last bucket.
+  static constexpr size_t BUCKETS = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  struct Summary
+  {
+    uint64_t count;
+    uint64_t timeouts;
+    uint64_t errors;  // transport errors and non zero error IDs
+    double mean_us;
+    uint64_t p50_us;
+    uint64_t p90_us;
+    uint64_t p99_us;
+    uint64_t max_us;
+    // Upper bound and count of every non empty bucket
+    std::vector<std::pair<uint64_t, uint64_t>> buckets;
+  };
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> counts_;
+  std::atomic<uint64_t> sum_us_;
+  std::atomic<uint64_t> max_us_;
+  std::atomic<uint64_t> timeouts_;
+  std::atomic<uint64_t> errors_;
+
+public:
+  LatencyHistogram();
+
+  void record(const std::chrono::nanoseconds);
+  void recordTimeout();
+  void recordError();
+
+  // Not a consistent snapshot while recording goes on, but close enough
+  Summary summarize() const;
+
+  static size_t toIndex(const uint64_t us);
+  // Largest value counted in the bucket
+  static uint64_t toUpperBound(const size_t index);
+};
+
+// One histogram per dashboard function name (e.g. "EnableRobot").
+// Lookup and insertion are lock-free; the number of names is bounded.
+class LatencyStats
+{
+public:
+  using UniquePtr = std::unique_ptr<LatencyStats>;
+  static constexpr size_t CAPACITY = 128;
+  // Taken by every name that does not fit
+  static constexpr char OTHERS[] = "(others)";
+
+private:
+  struct Entry
+  {
+    const std::string function;
+    LatencyHistogram histogram;
+
+    explicit Entry(const std::string & name)
+    : function(name) {}
+  };
+
+  std::array<std::atomic<Entry *>, CAPACITY> slots_;
+  Entry others_;
+
+public:
+  LatencyStats();
+  ~LatencyStats();
+  LatencyStats(const LatencyStats &) = delete;
+  LatencyStats & operator=(const LatencyStats &) = delete;
+
+  LatencyHistogram & get(const std::string & function);
+
+  // Sorted by function name. Functions never recorded are left out.
+  std::vector<std::pair<std::string, LatencyHistogram::Summary>> summarize() const;
+};
+}  // namespace mg400_interface
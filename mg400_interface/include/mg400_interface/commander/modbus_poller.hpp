@@ -0,0 +1,137 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include "mg400_interface/commander/dashboard_commander.hpp"
+
+namespace mg400_interface
+{
+// Polls Modbus registers of a device attached to the controller and reports
+// only the values that changed since the previous poll.
+//
+// Registered ranges of the same table are merged into as few reads as the
+// per read limits allow, and every read of a poll goes out in a single write.
+class ModbusPoller
+{
+public:
+  using UniquePtr = std::unique_ptr<ModbusPoller>;
+
+  enum class Table
+  {
+    COIL = 0,
+    DISCRETE_INPUT = 1,
+    INPUT_REGISTER = 2,
+    HOLDING_REGISTER = 3,
+  };
+
+  struct Range
+  {
+    Table table;
+    int addr;
+    int count;
+  };
+
+  // Changed values of one table, in ascending address order
+  struct Change
+  {
+    Table table;
+    std::vector<int> addresses;
+    std::vector<int> values;
+  };
+  using ChangeCallback = std::function<void (std::vector<Change>)>;
+
+  struct Limits
+  {
+    // Unregistered addresses read to join two ranges into one read
+    int max_gap;
+    // Largest count of a single GetCoils() / GetInBits() call
+    int max_bits;
+    // Largest count of a single GetInRegs() / GetHoldRegs() call
+    int max_registers;
+  };
+
+  struct Stats
+  {
+    uint64_t polls;
+    uint64_t reads;  // Get* commands sent
+    uint64_t failures;  // reads not answered with values
+    uint64_t skipped;  // asynchronous polls dropped while one was in flight
+  };
+
+private:
+  struct Plan
+  {
+    std::vector<Range> reads;
+    std::vector<std::string> commands;
+    std::array<std::set<int>, 4> registered;
+  };
+
+  DashboardCommander * commander_;
+  const Limits LIMITS;
+
+  std::mutex mutex_;
+  std::vector<Range> ranges_;
+  std::shared_ptr<const Plan> plan_;
+  int index_;
+  bool is_open_;
+  std::array<std::unordered_map<int, int>, 4> last_values_;
+  Stats stats_;
+  std::atomic<bool> is_polling_;
+
+public:
+  ModbusPoller() = delete;
+  explicit ModbusPoller(DashboardCommander *, const Limits & = {0, 16, 4});
+  ~ModbusPoller();
+
+  // Ranges may be added before or after open()
+  void addRange(const Table, const int addr, const int count);
+
+  // Throws std::runtime_error if the controller refused the connection
+  void open(const std::string & ip, const int port, const int slave_id, const bool is_rtu = false);
+  void close();
+  bool isOpen();
+
+  // Blocks until every read is answered. Throws std::runtime_error if not opened.
+  std::vector<Change> poll();
+  // Returns false without polling if the previous poll is still in flight.
+  // The callback runs on the dashboard I/O thread.
+  bool poll(const ChangeCallback &);
+
+  Stats getStats();
+
+  // Sorted reads covering every range, merged per table within the limits
+  static std::vector<Range> plan(std::vector<Range>, const Limits &);
+  static std::string toCommand(const int index, const Range &);
+
+private:
+  static const rclcpp::Logger getLogger();
+  std::shared_ptr<const Plan> takePlan();
+  std::vector<Change> update(
+    const Plan &, const std::vector<DashboardCommander::BatchResult> &);
+};
+}  // namespace mg400_interface
@@ -64,6 +64,15 @@ public:
     const si_rad, const si_rad, const si_rad,
     const si_rad, const si_rad, const si_rad);
 
+  // Blends into the next motion with the continuous path ratio [0, 100]
+  // instead of stopping at the goal
+  void movJCP(
+    const si_m, const si_m, const si_m,
+    const si_rad, const int);
+  void movLCP(
+    const si_m, const si_m, const si_m,
+    const si_rad, const int);
+
   void movLIO(
     const si_m, const si_m, const si_m,
     const si_rad, const si_rad, const si_rad,
@@ -123,6 +132,10 @@ public:
     const si_rad, const si_rad, const si_rad,
     const si_rad, const si_rad, const si_rad);
 
+  // Servo targets: streamed at a fixed rate, each one replacing the last
+  void servoJ(const si_rad, const si_rad, const si_rad, const si_rad);
+  void servoP(const si_m, const si_m, const si_m, const si_rad);
+
 
   // End DOBOT MG400 Official Command -----------------------------------------
 };
@@ -0,0 +1,126 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <mg400_msgs/msg/robot_mode.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include "mg400_interface/commander/latency_stats.hpp"
+#include "mg400_interface/tcp_interface/realtime_feedback_tcp_interface.hpp"
+
+namespace mg400_interface
+{
+using namespace std::chrono_literals;  // NOLINT
+
+// Hands the arm over from one goal to the next. The goal acquiring it
+// preempts the previous owner: its motion is stopped on the controller,
+// and the new owner waits until the feedback shows the arm standing still
+// before sending its own. Every acquisition gets a new owner ID, so that a
+// goal finished long ago is never taken for the current one.
+class MotionPreemptor
+{
+public:
+  using SharedPtr = std::shared_ptr<MotionPreemptor>;
+  // Never zero
+  using Owner = uint64_t;
+  // Called with true once the controller accepted the stop, false if not
+  using StopCallback = std::function<void (const bool)>;
+  // Stops the motion and drops the queue of the controller (e.g. ResetRobot()).
+  // Must not block: `done` may be called from any thread.
+  using StopFunction = std::function<void (const StopCallback & done)>;
+  using FeedbackSource = std::function<RealtimeFeedbackTcpInterface::Snapshot()>;
+
+  struct Config
+  {
+    // Feedback must show the arm stopped within this
+    std::chrono::nanoseconds stop_timeout;
+    // Polling period of the feedback while waiting
+    std::chrono::nanoseconds poll_period;
+  };
+
+private:
+  using RobotMode = mg400_msgs::msg::RobotMode;
+
+  StopFunction stop_function_;
+  FeedbackSource feedback_source_;
+  const Config CONFIG;
+
+  struct StopRequest
+  {
+    uint64_t seq;
+    bool is_pending;  // not confirmed by the feedback yet
+    bool is_failed;
+    // RCL_SYSTEM_TIME, as the feedback. Zero until known.
+    int64_t request_ns;
+    int64_t accept_ns;
+  };
+
+  std::mutex mutex_;
+  Owner owner_;  // zero once released
+  Owner last_owner_;
+
+  // Also locked by the callback of the stop function, which never takes mutex_
+  std::mutex stop_mutex_;
+  StopRequest stop_;
+
+  // From the stop request to the first feedback packet not RUNNING
+  LatencyHistogram stop_latency_;
+
+public:
+  MotionPreemptor() = delete;
+  MotionPreemptor(
+    const StopFunction &, const FeedbackSource &, const Config & = {1s, 1ms});
+
+  // Makes a new goal the owner of the arm and returns its ID at once.
+  // Stops the motion of the previous owner if any.
+  Owner acquire();
+  void release(const Owner);
+  bool isOwner(const Owner);
+
+  // Runs `send` only if the goal still owns the arm. A newer goal acquiring
+  // it meanwhile waits, so that its stop request follows the send.
+  bool sendIfOwner(const Owner, const std::function<void ()> & send);
+
+  // True while a goal owns the arm
+  bool isOwned();
+  // Runs `send` only if no goal owns the arm, e.g. for servo commands.
+  // A goal acquiring it meanwhile waits for the send to finish.
+  bool sendIfUnowned(const std::function<void ()> & send);
+
+  // Stops the motion of the goal if it owns the arm, e.g. once canceled.
+  // Returns false if it does not.
+  bool requestStop(const Owner);
+
+  // Blocks until the feedback confirms the pending stop, if any.
+  // Returns false on timeout or once the goal lost the arm meanwhile.
+  bool waitForStop(const Owner);
+
+  LatencyHistogram::Summary getStopLatency() const;
+
+private:
+  static const rclcpp::Logger getLogger();
+  // Call with mutex_ locked
+  bool isOwnerLocked(const Owner) const;
+  void sendStop();
+  void onStopDone(const uint64_t seq, const bool is_accepted);
+};
+}  // namespace mg400_interface
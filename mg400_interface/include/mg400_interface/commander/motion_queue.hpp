@@ -0,0 +1,166 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include <mg400_msgs/msg/robot_mode.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include "mg400_interface/command_utils.hpp"
+#include "mg400_interface/commander/motion_commander.hpp"
+#include "mg400_interface/tcp_interface/realtime_data.hpp"
+
+namespace mg400_interface
+{
+using namespace std::chrono_literals;  // NOLINT
+
+// Numbers the moves written to the motion port and follows them through the
+// planner state of the realtime feedback. The controller runs its queue in
+// order, so the oldest move not done yet is the one executing: it starts when
+// the planned velocity (qd_target) leaves zero and is done once the planned
+// position (q_target or tool_vector_target) reached its goal. A move blended
+// into the next one (CP) is done once the planner entered its blend zone.
+//
+// At most `depth` moves are left with the controller at once; push() blocks
+// until one of them is done.
+class MotionQueue
+{
+public:
+  using SharedPtr = std::shared_ptr<MotionQueue>;
+
+  enum class Type
+  {
+    MOV_J,
+    MOV_L,
+    JOINT_MOV_J,
+  };
+
+  struct Move
+  {
+    Type type;
+    // x, y, z [m] and r [rad], or j1 to j4 [rad] for JOINT_MOV_J
+    std::array<double, 4> goal;
+    // Continuous path ratio [0, 100] of MOV_J and MOV_L.
+    // Negative leaves the setting of the controller.
+    int cp = -1;
+    // Distance to the goal [m] at which a blended MOV_J or MOV_L counts as
+    // passed while more moves follow. Zero waits until the goal is reached.
+    double blend_zone = 0.0;
+  };
+
+  enum class State
+  {
+    SENT,  // with the controller, not started yet
+    RUNNING,
+    DONE,
+    FAILED,  // robot error, feedback lost, cleared, or never reached
+  };
+
+  struct Record
+  {
+    uint64_t id;
+    State state;
+    // Feedback stamps (RCL_SYSTEM_TIME). Zero until known.
+    int64_t sent_ns;
+    int64_t start_ns;
+    int64_t end_ns;
+  };
+
+  struct Config
+  {
+    size_t depth;
+    // Planned position closer than this to the goal has reached it
+    double position_tolerance_mm;
+    double angle_tolerance_deg;
+    // Planned joint velocities below this are standing still
+    double velocity_tolerance_deg;
+    // Planner standing still in ENABLE without reaching the oldest move
+    std::chrono::nanoseconds stall_timeout;
+  };
+
+private:
+  using RobotMode = mg400_msgs::msg::RobotMode;
+  static constexpr size_t HISTORY = 64;
+
+  struct Entry
+  {
+    Record record;
+    Type type;
+    // mm and degree, as the feedback
+    std::array<double, 4> goal;
+    double blend_zone_mm;
+  };
+
+  MotionCommander commander_;
+  Config config_;
+
+  // Keeps sends in the order of their IDs
+  std::mutex send_mutex_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Entry> in_flight_;
+  std::deque<Record> history_;
+  uint64_t next_id_;
+  int64_t last_stamp_ns_;
+  int64_t idle_since_ns_;
+
+public:
+  MotionQueue() = delete;
+  explicit MotionQueue(
+    MotionTcpInterfaceBase *, const Config & = {4, 0.1, 0.1, 0.01, 2s});
+
+  void setDepth(const size_t);
+
+  // Returns 0 without sending if `depth` moves are in flight
+  uint64_t tryPush(const Move &);
+  // Throws std::runtime_error if no move was done within the timeout
+  uint64_t push(const Move &, const std::chrono::nanoseconds);
+
+  // Feeds one feedback packet; nullptr once the feedback is lost
+  void update(const RealTimeData *, const int64_t stamp_ns);
+  // Fails every move in flight. Call once the controller dropped its queue
+  // (ClearError(), ResetRobot(), ...).
+  void clear();
+
+  // False if the ID is unknown or too old
+  bool getRecord(const uint64_t, Record &);
+  // Waits for the move to be done or failed.
+  // Returns false on timeout, or if the ID is unknown.
+  bool wait(const uint64_t, const std::chrono::nanoseconds, Record &);
+  size_t countInFlight();
+
+  static Move movJ(const si_m, const si_m, const si_m, const si_rad);
+  static Move movL(const si_m, const si_m, const si_m, const si_rad);
+  static Move jointMovJ(const si_rad, const si_rad, const si_rad, const si_rad);
+  static const char * toString(const State);
+
+private:
+  static const rclcpp::Logger getLogger();
+  uint64_t send(std::unique_lock<std::mutex> &, const Move &);
+  // Moves the oldest in flight to the history
+  void finish(const State, const int64_t stamp_ns);
+  void archive(const Record &);
+  bool isReached(const Entry &, const RealTimeData &) const;
+  bool isInBlendZone(const Entry &, const RealTimeData &) const;
+  bool findRecord(const uint64_t, Record &) const;
+};
+}  // namespace mg400_interface
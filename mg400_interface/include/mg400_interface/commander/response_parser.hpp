@@ -39,5 +39,6 @@ public:
   static std::vector<double> takePoseArray(const std::string &);
   static std::vector<double> takeAngleArray(const std::string &);
   static int takeInt(const std::string &);
+  static std::vector<int> takeIntArray(const std::string &);
 };
 }  // namespace mg400_interface
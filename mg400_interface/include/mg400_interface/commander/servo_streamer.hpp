@@ -0,0 +1,147 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include "mg400_interface/command_utils.hpp"
+#include "mg400_interface/commander/latency_stats.hpp"
+#include "mg400_interface/commander/motion_commander.hpp"
+#include "mg400_interface/seqlock.hpp"
+#include "mg400_interface/tcp_interface/realtime_feedback_tcp_interface.hpp"
+
+namespace mg400_interface
+{
+// Sends ServoJ / ServoP from a dedicated thread woken up at absolute
+// deadlines, tracking the latest setpoint. Every command moves at most one
+// rate limited step from the previous one, starting from the feedback.
+// A setpoint older than the timeout stops the stream: the arm then halts at
+// the last command, at most one step away. A command the socket refuses ends
+// the thread (see isRunning()). A send guard refusing a command pauses the
+// stream, which restarts from the feedback once commands are let through.
+class ServoStreamer
+{
+public:
+  using UniquePtr = std::unique_ptr<ServoStreamer>;
+  using FeedbackSource = std::function<RealtimeFeedbackTcpInterface::Snapshot()>;
+  // Runs `send` if allowed, e.g. MotionPreemptor::sendIfUnowned. Returns false if not.
+  using SendGuard = std::function<bool (const std::function<void ()> & send)>;
+
+  enum class Mode
+  {
+    JOINT,  // ServoJ
+    POSE,  // ServoP
+  };
+
+  struct Config
+  {
+    std::chrono::nanoseconds period;
+    // Watchdog: setpoints older than this stop the stream
+    std::chrono::nanoseconds setpoint_timeout;
+    si_rad max_joint_velocity;  // per second
+    si_m max_linear_velocity;  // per second
+    si_rad max_angular_velocity;  // per second, r of ServoP
+    // SCHED_FIFO priority of the sender thread. 0 keeps the default policy.
+    int priority;
+  };
+
+  struct Stats
+  {
+    uint64_t ticks;
+    uint64_t sent;
+    uint64_t overruns;  // periods skipped because the thread woke up too late
+    uint64_t watchdog_stops;
+    uint64_t limited;  // commands clamped by the rate limit
+    // Wake-up lateness against the deadline
+    LatencyHistogram::Summary jitter;
+  };
+
+private:
+  struct Setpoint
+  {
+    bool valid;
+    Mode mode;
+    std::array<double, 4> values;  // SI
+    int64_t stamp_ns;  // steady clock
+  };
+
+  MotionCommander::SharedPtr commander_;
+  FeedbackSource feedback_source_;
+  Config config_;
+  SendGuard send_guard_;
+
+  // Writers are serialized so that the sender thread reads without locking
+  std::mutex setpoint_mutex_;
+  Seqlock<Setpoint> setpoint_;
+
+  std::atomic<bool> is_running_;
+  std::thread thread_;
+
+  // Sender thread only
+  bool is_streaming_;
+  bool is_paused_;  // by the send guard
+  Mode mode_;
+  std::array<double, 4> command_;
+
+  std::atomic<uint64_t> ticks_;
+  std::atomic<uint64_t> sent_;
+  std::atomic<uint64_t> overruns_;
+  std::atomic<uint64_t> watchdog_stops_;
+  std::atomic<uint64_t> limited_;
+  LatencyHistogram jitter_;
+
+public:
+  ServoStreamer() = delete;
+  ServoStreamer(
+    const MotionCommander::SharedPtr &, const FeedbackSource &,
+    const Config & = {std::chrono::milliseconds(20), std::chrono::milliseconds(100),
+      1.0, 0.2, 1.0, 0});
+  ~ServoStreamer();
+  ServoStreamer(const ServoStreamer &) = delete;
+  ServoStreamer & operator=(const ServoStreamer &) = delete;
+
+  // Call before start()
+  void setSendGuard(const SendGuard &);
+  void start();
+  void stop();
+  bool isRunning() const;
+
+  void setJointSetpoint(const si_rad, const si_rad, const si_rad, const si_rad);
+  void setPoseSetpoint(const si_m, const si_m, const si_m, const si_rad);
+
+  Stats getStats() const;
+
+  // Moves `from` towards `to` by at most one step. Returns true if clamped.
+  static bool limit(
+    const Mode, const std::array<double, 4> & to, const double max_step,
+    const double max_angular_step, std::array<double, 4> & from);
+
+private:
+  static const rclcpp::Logger getLogger();
+  void setSetpoint(const Mode, const std::array<double, 4> &);
+  void run();
+  // Returns false once the stream can not go on
+  bool tick(const int64_t now_ns);
+};
+}  // namespace mg400_interface
@@ -0,0 +1,76 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mg400_interface
+{
+// Remembers the last accepted command of every setting function
+// (e.g. "SpeedFactor(50)" for SpeedFactor) so that sending it again can be skipped.
+//
+// A miss hands out a ticket and the command is only stored with it once the
+// controller accepted it. invalidate() and epoch changes void every ticket handed
+// out before, so a response racing with an invalidation is never cached.
+class SettingsCache
+{
+public:
+  using UniquePtr = std::unique_ptr<SettingsCache>;
+
+  struct Stats
+  {
+    uint64_t hits;  // each one is a dashboard round trip saved
+    uint64_t misses;
+    uint64_t invalidations;
+  };
+
+private:
+  struct Entry
+  {
+    std::string command;
+    uint64_t ticket;
+    bool is_valid;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  uint64_t epoch_;
+  uint64_t next_ticket_;
+  Stats stats_;
+
+public:
+  SettingsCache();
+
+  // Returns true if the command is already in effect.
+  // Otherwise returns false and a ticket to store() it with.
+  // The cache is cleared first if the epoch changed since the last call.
+  bool lookup(const std::string &, const uint64_t epoch, uint64_t & ticket);
+  // Like a miss: for a command that is sent anyway
+  uint64_t reserve(const std::string &, const uint64_t epoch);
+  void store(const std::string &, const uint64_t ticket);
+  void invalidate();
+  Stats getStats();
+
+private:
+  // Expects the lock to be held
+  Entry & find(const std::string &, const uint64_t epoch);
+  uint64_t reserve(Entry &, const std::string &);
+  void clear();
+};
+}  // namespace mg400_interface
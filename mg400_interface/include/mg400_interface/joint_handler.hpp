@@ -58,6 +58,9 @@ private:
 public:
   static JointState::UniquePtr getJointState(const std::array<double, 4> &, const std::string &);
 
+  static JointState::UniquePtr getJointState(
+    const std::array<double, 4> &, const std::string &, const rclcpp::Time &);
+
   static JointState::UniquePtr getJointState(
     const double &, const double &, const double &, const double &, const std::string &);
 
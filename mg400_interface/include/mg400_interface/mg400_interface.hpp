@@ -14,15 +14,19 @@
 
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <memory>
 
+#include "mg400_interface/tcp_interface/io_reactor.hpp"
 #include "mg400_interface/tcp_interface/dashboard_tcp_interface.hpp"
 #include "mg400_interface/tcp_interface/motion_tcp_interface.hpp"
 #include "mg400_interface/tcp_interface/realtime_feedback_tcp_interface.hpp"
 
 #include "mg400_interface/commander/dashboard_commander.hpp"
 #include "mg400_interface/commander/motion_commander.hpp"
+#include "mg400_interface/commander/motion_preemptor.hpp"
+#include "mg400_interface/commander/motion_queue.hpp"
 
 #include "mg400_interface/joint_handler.hpp"
 #include "mg400_interface/error_msg_generator.hpp"
@@ -38,27 +42,59 @@ public:
   using UniquePtr = std::unique_ptr<MG400Interface>;
   using SharedPtr = std::shared_ptr<MG400Interface>;
 
+  // TCP ports of the controller
+  struct Ports
+  {
+    uint16_t dashboard = DashboardTcpInterface::DEFAULT_PORT;
+    uint16_t motion = MotionTcpInterface::DEFAULT_PORT;
+    uint16_t feedback = RealtimeFeedbackTcpInterface::DEFAULT_PORT;
+  };
+
+  // Created by configure() and kept across reconnections
   DashboardCommander::SharedPtr dashboard_commander;
   MotionCommander::SharedPtr motion_commander;
+  // Kept across reconnections: moves in flight fail when the feedback is lost
+  MotionQueue::SharedPtr motion_queue;
+  // Shared by the motion actions: a newer goal stops the running one
+  MotionPreemptor::SharedPtr motion_preemptor;
   RealtimeFeedbackTcpInterface::SharedPtr realtime_tcp_interface;
 
   std::unique_ptr<ErrorMsgGenerator> error_msg_generator;
 
 private:
   const std::string IP;
+  const Ports PORTS;
+  const std::chrono::seconds CONNECT_TIMEOUT = std::chrono::seconds(2);
+  const std::chrono::seconds READY_TIMEOUT = std::chrono::seconds(12);
 
+  IoReactor::SharedPtr io_reactor_;
   DashboardTcpInterface::UniquePtr dashboard_tcp_if_;
   MotionTcpInterface::UniquePtr motion_tcp_if_;
 
+  std::chrono::nanoseconds time_to_ready_;
+
 public:
   MG400Interface() = delete;
   explicit MG400Interface(const std::string &);
+  MG400Interface(const std::string &, const Ports &);
 
   bool configure(const std::string & = "");
+  // Call after configure(). Applied on the next (re)connection.
+  void setSocketProfiles(
+    const SocketProfile & dashboard, const SocketProfile & motion,
+    const SocketProfile & feedback);
+
+  // getPose(), getAngle(), robotMode() and DI() of the dashboard commander are
+  // answered from feedback no older than this. Zero always asks the dashboard.
+  // Call after configure(), before activate().
+  void setFeedbackMaxAge(const std::chrono::nanoseconds);
 
   bool activate();
   bool deactivate();
   bool ok();
+  // Time from activate() until every socket was connected and
+  // the first valid feedback packet arrived
+  std::chrono::nanoseconds getTimeToReady() const;
 
 private:
   static const rclcpp::Logger getLogger() noexcept;
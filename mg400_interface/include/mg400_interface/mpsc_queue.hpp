@@ -0,0 +1,93 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace mg400_interface
+{
+// Unbounded lock-free queue for any number of producer threads and one consumer
+// at a time. push() never blocks; pop() may briefly miss an element whose push()
+// has not finished yet, but empty() already reports it.
+template<typename T>
+class MpscQueue
+{
+private:
+  struct Node
+  {
+    std::atomic<Node *> next;
+    T value;
+
+    Node()
+    : next(nullptr), value() {}
+    explicit Node(T && v)
+    : next(nullptr), value(std::move(v)) {}
+  };
+
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<Node *> head_;  // last pushed
+  alignas(CACHE_LINE_SIZE) std::atomic<Node *> tail_;  // consumed, its next is the front
+
+public:
+  MpscQueue()
+  {
+    Node * const stub = new Node();
+    this->head_.store(stub);
+    this->tail_.store(stub);
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue & operator=(const MpscQueue &) = delete;
+
+  ~MpscQueue()
+  {
+    T value;
+    while (this->pop(value)) {
+    }
+    delete this->tail_.load();
+  }
+
+  // Any thread
+  void push(T value)
+  {
+    Node * const node = new Node(std::move(value));
+    Node * const prev = this->head_.exchange(node);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Consumer only
+  bool pop(T & value)
+  {
+    Node * const tail = this->tail_.load(std::memory_order_relaxed);
+    Node * const next = tail->next.load(std::memory_order_acquire);
+    if (!next) {
+      return false;
+    }
+    value = std::move(next->value);
+    next->value = T();
+    this->tail_.store(next, std::memory_order_relaxed);
+    delete tail;
+    return true;
+  }
+
+  // Any thread
+  bool empty() const
+  {
+    return this->head_.load() == this->tail_.load();
+  }
+};
+}  // namespace mg400_interface
@@ -0,0 +1,76 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include <mg400_msgs/msg/robot_mode.hpp>
+
+namespace mg400_interface
+{
+using namespace std::chrono_literals;  // NOLINT
+
+// Follows a script started with RunScript() through the robot mode of the
+// realtime feedback: RUNNING while it runs, PAUSE while paused and ENABLE
+// once it is over. Not thread safe.
+class ScriptTracker
+{
+public:
+  using UniquePtr = std::unique_ptr<ScriptTracker>;
+
+  enum class State
+  {
+    STARTING,  // accepted, not seen running yet
+    RUNNING,
+    PAUSED,
+    FINISHED,
+    STOPPED,  // over after stop() was requested
+    FAILED,  // robot error, disabled, or never started
+  };
+
+  struct Progress
+  {
+    State state;
+    std::chrono::nanoseconds running;
+    std::chrono::nanoseconds paused;
+    uint32_t pauses;
+  };
+
+private:
+  using RobotMode = mg400_msgs::msg::RobotMode;
+
+  const std::chrono::nanoseconds START_TIMEOUT;
+  Progress progress_;
+  int64_t last_stamp_ns_;
+  int64_t started_ns_;
+  bool is_stopping_;
+
+public:
+  explicit ScriptTracker(const std::chrono::nanoseconds start_timeout = 2s);
+
+  // Call with the feedback stamp at which RunScript() was sent
+  void start(const int64_t stamp_ns);
+  // Call when StopScript() was sent: the script ending is then not a success
+  void stop();
+  // Feeds the robot mode of one feedback packet. Returns true if the state changed.
+  bool update(const uint64_t robot_mode, const int64_t stamp_ns);
+
+  Progress getProgress() const;
+  bool isDone() const;
+  static const char * toString(const State);
+};
+}  // namespace mg400_interface
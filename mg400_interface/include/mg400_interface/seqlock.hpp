@@ -0,0 +1,77 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace mg400_interface
+{
+// Publishes a value from exactly one writer thread to any number of readers.
+// The writer never waits; readers retry while a write overlaps their copy.
+template<typename T>
+class Seqlock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> seq_;  // odd while a write is in progress
+  T value_;
+
+public:
+  Seqlock()
+  : seq_(0), value_{} {}
+
+  explicit Seqlock(const T & value)
+  : seq_(0), value_(value) {}
+
+  // Writer only
+  void store(const T & value)
+  {
+    const uint64_t seq = this->seq_.load(std::memory_order_relaxed);
+    this->seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&this->value_, &value, sizeof(T));
+    this->seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  T load() const
+  {
+    return this->read([](const T & value) {return value;});
+  }
+
+  // Calls f on a consistent value and returns its result.
+  // f may be called more than once and must only copy out of the value.
+  template<typename F>
+  auto read(F && f) const
+  {
+    while (true) {
+      const uint64_t before = this->seq_.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      auto result = f(this->value_);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (this->seq_.load(std::memory_order_relaxed) == before) {
+        return result;
+      }
+    }
+  }
+};
+}  // namespace mg400_interface
@@ -0,0 +1,81 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace mg400_interface
+{
+// Bounded lock-free ring for exactly one producer thread and one consumer thread.
+// Slots are written and read in place to avoid copying large elements.
+template<typename T, size_t N>
+class SpscRing
+{
+  static_assert(N > 1 && (N & (N - 1)) == 0, "N must be a power of two");
+
+private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;  // next slot to write
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;  // next slot to read
+  alignas(CACHE_LINE_SIZE) std::array<T, N> slots_;
+
+public:
+  SpscRing()
+  : head_(0), tail_(0) {}
+
+  // Producer: returns nullptr when the ring is full.
+  T * beginPush()
+  {
+    const size_t head = this->head_.load(std::memory_order_relaxed);
+    if (head - this->tail_.load(std::memory_order_acquire) == N) {
+      return nullptr;
+    }
+    return &this->slots_[head & (N - 1)];
+  }
+
+  // Producer: publishes the slot returned by beginPush().
+  void endPush()
+  {
+    this->head_.store(this->head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Consumer: returns nullptr when the ring is empty.
+  const T * front() const
+  {
+    const size_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &this->slots_[tail & (N - 1)];
+  }
+
+  // Consumer: releases the slot returned by front().
+  void pop()
+  {
+    this->tail_.store(this->tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  bool empty() const
+  {
+    return this->tail_.load(std::memory_order_acquire) ==
+           this->head_.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() {return N;}
+};
+}  // namespace mg400_interface
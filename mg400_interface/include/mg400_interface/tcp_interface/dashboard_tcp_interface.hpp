@@ -16,11 +16,16 @@
 
 #include <cstdlib>
 
+#include <atomic>
+#include <condition_variable>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include <rclcpp/rclcpp.hpp>
 
+#include "mg400_interface/tcp_interface/io_reactor.hpp"
+#include "mg400_interface/tcp_interface/response_framer.hpp"
 #include "mg400_interface/tcp_interface/tcp_socket_handler.hpp"
 
 namespace mg400_interface
@@ -31,35 +36,60 @@ class DashboardTcpInterfaceBase
 public:
   DashboardTcpInterfaceBase() {}
   virtual void sendCommand(const std::string &) = 0;
+  // Writes the commands back to back, in order
+  virtual void sendCommands(const std::vector<std::string> & cmds)
+  {
+    for (const auto & cmd : cmds) {
+      this->sendCommand(cmd);
+    }
+  }
   virtual std::string recvResponse() = 0;
+  // Grows on every (re)connection, when the controller may have lost its settings
+  virtual uint64_t countConnections() {return 0;}
 };
 
-class DashboardTcpInterface : public DashboardTcpInterfaceBase
+class DashboardTcpInterface
+  : public DashboardTcpInterfaceBase, private IoReactor::Handler
 {
 public:
   using UniquePtr = std::unique_ptr<DashboardTcpInterface>;
+  static constexpr uint16_t DEFAULT_PORT = 29999;
 
 private:
-  const uint16_t PORT_ = 29999;
+  const uint16_t PORT_;
+  const std::chrono::milliseconds RECV_TIMEOUT_ = 500ms;
 
-  std::atomic<bool> is_running_;
   std::mutex mutex_;
-  std::unique_ptr<std::thread> thread_;
+  std::condition_variable cv_;
+  ResponseFramer framer_;
+  bool is_closed_;
+  std::atomic<uint64_t> connection_count_;
+  IoReactor::SharedPtr reactor_;
   std::shared_ptr<TcpSocketHandler> tcp_socket_;
 
 public:
   DashboardTcpInterface() = delete;
-  explicit DashboardTcpInterface(const std::string &);
+  DashboardTcpInterface(
+    const std::string &, const IoReactor::SharedPtr &, const uint16_t = DEFAULT_PORT);
   ~DashboardTcpInterface();
   void init() noexcept;
 
   static rclcpp::Logger getLogger();
   bool isConnected();
+  void setSocketProfile(const SocketProfile &);
   void sendCommand(const std::string &) override;
+  void sendCommands(const std::vector<std::string> &) override;
   std::string recvResponse(void) override;
+  uint64_t countConnections() override;
   void disConnect();
 
 private:
-  void checkConnection();
+  // Responses are received on the reactor thread and handed over to
+  // recvResponse(), which disConnect() wakes up immediately.
+  std::shared_ptr<TcpSocketHandler> getSocket() override;
+  uint32_t getEvents() const override;
+  void onConnected() override;
+  void onReadable() override;
+  void onDisconnected() override;
 };
 }  // namespace mg400_interface
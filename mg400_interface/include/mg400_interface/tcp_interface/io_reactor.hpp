@@ -0,0 +1,134 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include "mg400_interface/tcp_interface/tcp_socket_handler.hpp"
+
+namespace mg400_interface
+{
+// Single epoll loop that owns the file descriptors of every registered
+// TcpSocketHandler, dispatches readiness events and drives reconnection.
+class IoReactor
+{
+public:
+  using SharedPtr = std::shared_ptr<IoReactor>;
+  using SteadyClock = std::chrono::steady_clock;
+
+  // Callbacks are invoked from the reactor thread only.
+  // They must not call IoReactor::add() or IoReactor::remove().
+  class Handler
+  {
+  public:
+    virtual ~Handler() {}
+    virtual std::shared_ptr<TcpSocketHandler> getSocket() = 0;
+    // epoll events of interest besides hang up / error (e.g. EPOLLIN)
+    virtual uint32_t getEvents() const {return 0;}
+    virtual void onConnected() {}
+    virtual void onDisconnected() {}
+    virtual void onReadable() {}
+    virtual void onTimer(const SteadyClock::time_point &) {}
+  };
+
+  struct Statistics
+  {
+    uint64_t loop_count;
+    uint64_t event_count;
+    std::chrono::nanoseconds last_dispatch_time;
+    std::chrono::nanoseconds max_dispatch_time;
+    std::chrono::nanoseconds total_dispatch_time;
+  };
+
+private:
+  struct Entry
+  {
+    Handler * handler;
+    std::shared_ptr<TcpSocketHandler> socket;
+    int registered_fd;
+    bool is_connected;
+    SteadyClock::time_point next_connect_time;
+    SteadyClock::time_point connect_deadline;
+  };
+
+  static constexpr int MAX_EVENTS = 8;
+  const std::chrono::milliseconds TIMER_PERIOD = std::chrono::milliseconds(100);
+  const std::chrono::milliseconds CONNECT_TIMEOUT = std::chrono::milliseconds(1000);
+  const std::chrono::milliseconds RECONNECT_INTERVAL = std::chrono::milliseconds(100);
+
+  int epoll_fd_;
+  int wakeup_fd_;
+  std::atomic<bool> is_running_;
+  std::mutex mutex_;
+  std::vector<Entry> entries_;
+  std::unique_ptr<std::thread> thread_;
+
+  std::mutex state_mutex_;
+  std::condition_variable state_cv_;
+
+  std::atomic<uint64_t> loop_count_;
+  std::atomic<uint64_t> event_count_;
+  std::atomic<int64_t> last_dispatch_ns_;
+  std::atomic<int64_t> max_dispatch_ns_;
+  std::atomic<int64_t> total_dispatch_ns_;
+
+public:
+  IoReactor();
+  ~IoReactor();
+
+  static rclcpp::Logger getLogger();
+
+  void start();
+  void stop();
+  bool isRunning() const;
+
+  void add(Handler *);
+  void remove(Handler *);
+
+  Statistics getStatistics() const;
+
+  // Wake up threads blocked in waitUntil().
+  // Called on connection changes and by handlers when their state changes.
+  void notify();
+
+  template<typename PredicateT>
+  bool waitUntil(PredicateT predicate, const SteadyClock::time_point & deadline)
+  {
+    std::unique_lock<std::mutex> lock(this->state_mutex_);
+    return this->state_cv_.wait_until(lock, deadline, predicate);
+  }
+
+private:
+  void run();
+  void wakeup();
+  Entry * findEntry(const Handler *);
+  void dispatch(Entry &, const uint32_t);
+  void connect(Entry &, const SteadyClock::time_point &);
+  void finishConnect(Entry &);
+  void close(Entry &);
+  SteadyClock::time_point getNextWakeup(const SteadyClock::time_point &) const;
+  void updateStatistics(const std::chrono::nanoseconds &, const int);
+};
+}  // namespace mg400_interface
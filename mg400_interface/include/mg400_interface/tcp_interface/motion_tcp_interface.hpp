@@ -17,12 +17,14 @@
 #include <cstdlib>
 
 #include <string>
+#include <string_view>
 #include <memory>
 
 #include <rclcpp/rclcpp.hpp>
 
 #include "mg400_interface/joint_handler.hpp"
 
+#include "mg400_interface/tcp_interface/io_reactor.hpp"
 #include "mg400_interface/tcp_interface/realtime_data.hpp"
 #include "mg400_interface/tcp_interface/tcp_socket_handler.hpp"
 
@@ -33,33 +35,44 @@ class MotionTcpInterfaceBase
 public:
   MotionTcpInterfaceBase() {}
   virtual void sendCommand(const std::string &) = 0;
+  // Sends without building a std::string where the transport allows it
+  virtual void sendCommandView(const std::string_view cmd)
+  {
+    this->sendCommand(std::string(cmd));
+  }
 };
 
-class MotionTcpInterface : public MotionTcpInterfaceBase
+class MotionTcpInterface
+  : public MotionTcpInterfaceBase, private IoReactor::Handler
 {
 public:
   using UniquePtr = std::unique_ptr<MotionTcpInterface>;
+  static constexpr uint16_t DEFAULT_PORT = 30003;
 
 private:
-  const uint16_t PORT_ = 30003;
+  const uint16_t PORT_;
 
   std::mutex mutex_;
-  std::atomic<bool> is_running_;
-  std::unique_ptr<std::thread> thread_;
+  IoReactor::SharedPtr reactor_;
   std::shared_ptr<TcpSocketHandler> tcp_socket_;
 
 public:
   MotionTcpInterface() = delete;
-  explicit MotionTcpInterface(const std::string &);
+  MotionTcpInterface(
+    const std::string &, const IoReactor::SharedPtr &, const uint16_t = DEFAULT_PORT);
   ~MotionTcpInterface();
   void init() noexcept;
 
   static rclcpp::Logger getLogger();
   bool isConnected();
+  void setSocketProfile(const SocketProfile &);
   void sendCommand(const std::string &) override;
+  void sendCommandView(const std::string_view) override;
   void disConnect();
 
 private:
-  void checkConnection();
+  std::shared_ptr<TcpSocketHandler> getSocket() override;
+  uint32_t getEvents() const override;
+  void onReadable() override;
 };
 }  // namespace mg400_interface
@@ -0,0 +1,112 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "mg400_interface/tcp_interface/realtime_data.hpp"
+
+namespace mg400_interface
+{
+// Fixed set of recycled RealTimeData slots so the feedback path never allocates.
+// A slot is reused once every Handle pinning it is gone.
+// One slot at a time may be published as the latest packet and pinned without locking.
+class RealTimeDataPool
+{
+public:
+  static constexpr size_t SIZE = 8;
+
+private:
+  struct alignas(64) Slot
+  {
+    RealTimeData data;
+    std::atomic<uint32_t> ref_count{0};
+  };
+
+  std::array<Slot, SIZE> slots_;
+  std::atomic<Slot *> latest_;
+
+public:
+  // Reference counted like std::shared_ptr, without any allocation.
+  // Must not outlive the pool.
+  class Handle
+  {
+  private:
+    Slot * slot_;
+
+    friend class RealTimeDataPool;
+    explicit Handle(Slot * slot)
+    : slot_(slot) {}
+
+  public:
+    Handle()
+    : slot_(nullptr) {}
+    Handle(std::nullptr_t)  // NOLINT: implicit like std::shared_ptr
+    : slot_(nullptr) {}
+    Handle(const Handle & other)
+    : slot_(other.slot_)
+    {
+      if (this->slot_) {
+        this->slot_->ref_count.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    Handle(Handle && other) noexcept
+    : slot_(other.slot_)
+    {
+      other.slot_ = nullptr;
+    }
+    ~Handle() {this->reset();}
+
+    Handle & operator=(Handle other) noexcept
+    {
+      this->swap(other);
+      return *this;
+    }
+
+    void swap(Handle & other) noexcept {std::swap(this->slot_, other.slot_);}
+
+    void reset()
+    {
+      if (this->slot_) {
+        // Pairs with the acquire in RealTimeDataPool::acquire()
+        this->slot_->ref_count.fetch_sub(1, std::memory_order_release);
+        this->slot_ = nullptr;
+      }
+    }
+
+    RealTimeData * get() const {return this->slot_ ? &this->slot_->data : nullptr;}
+    RealTimeData * operator->() const {return &this->slot_->data;}
+    RealTimeData & operator*() const {return this->slot_->data;}
+    explicit operator bool() const {return this->slot_ != nullptr;}
+    bool operator==(std::nullptr_t) const {return this->slot_ == nullptr;}
+    bool operator!=(std::nullptr_t) const {return this->slot_ != nullptr;}
+  };
+
+  RealTimeDataPool();
+  RealTimeDataPool(const RealTimeDataPool &) = delete;
+  RealTimeDataPool & operator=(const RealTimeDataPool &) = delete;
+
+  // Returns an empty handle when every slot is pinned
+  Handle acquire();
+  // Replaces the latest packet. Only the thread filling the slots may call it.
+  void publish(Handle);
+  // Pins the latest packet, or returns an empty handle if none is published
+  Handle latest();
+  size_t countFree() const;
+};
+}  // namespace mg400_interface
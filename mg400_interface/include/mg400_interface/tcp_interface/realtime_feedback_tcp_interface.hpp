@@ -15,6 +15,8 @@
 #pragma once
 
 
+#include <atomic>
+#include <functional>
 #include <string>
 #include <memory>
 
@@ -22,50 +24,100 @@
 #include <rclcpp/rclcpp.hpp>
 
 #include "mg400_interface/joint_handler.hpp"
+#include "mg400_interface/seqlock.hpp"
+#include "mg400_interface/tcp_interface/io_reactor.hpp"
 #include "mg400_interface/tcp_interface/realtime_data.hpp"
+#include "mg400_interface/tcp_interface/realtime_data_pool.hpp"
 #include "mg400_interface/tcp_interface/tcp_socket_handler.hpp"
 
 
 namespace mg400_interface
 {
 
-class RealtimeFeedbackTcpInterface
+class RealtimeFeedbackTcpInterface : private IoReactor::Handler
 {
 public:
   using SharedPtr = std::shared_ptr<RealtimeFeedbackTcpInterface>;
+  static constexpr uint16_t DEFAULT_PORT = 30004;
   const std::string frame_id_prefix;
 
+  // State derived from one feedback packet, published as a whole
+  struct Snapshot
+  {
+    bool active;
+    uint64_t robot_mode;
+    uint64_t digital_inputs;
+    std::array<double, 4> joints;
+    double q_actual[6];  // degree, as sent
+    double tool_vector[6];
+    int64_t stamp_ns;  // kernel receive time (RCL_SYSTEM_TIME)
+  };
+  // Called with nullptr once the feedback is lost
+  using PacketListener = std::function<void (const RealTimeData *, const int64_t stamp_ns)>;
+
 private:
   using Pose = geometry_msgs::msg::Pose;
-  const uint16_t PORT_ = 30004;
-  double tool_vector_[6];
-  std::mutex mutex_current_joints_;
-  std::mutex mutex_rt_data_;
-  std::array<double, 4> current_joints_;
-  std::shared_ptr<RealTimeData> rt_data_;
-  std::atomic<bool> is_running_;
-  std::unique_ptr<std::thread> thread_;
+  const uint16_t PORT_;
+  const std::chrono::seconds RECV_TIMEOUT_ = std::chrono::seconds(1);
+  // Declared first so it outlives every handle below
+  RealTimeDataPool pool_;
+  // Written by the reactor thread only, read without locking
+  Seqlock<Snapshot> snapshot_;
+  std::atomic<uint64_t> mode_changes_;
+  std::atomic<uint64_t> dropped_packets_;
+  IoReactor::SharedPtr reactor_;
   std::shared_ptr<TcpSocketHandler> tcp_socket_;
+  PacketListener packet_listener_;
+
+  // Accessed from the reactor thread only
+  RealTimeDataPool::Handle recv_data_;
+  uint32_t recv_size_;
+  timespec recv_stamp_;
+  bool is_active_;
+  uint64_t controller_mode_;
+  IoReactor::SteadyClock::time_point last_recv_time_;
+  // Throttles the warnings of the reactor thread
+  rclcpp::Clock log_clock_;
 
 public:
   RealtimeFeedbackTcpInterface() = delete;
-  explicit RealtimeFeedbackTcpInterface(
-    const std::string &, const std::string & = "");
+  RealtimeFeedbackTcpInterface(
+    const std::string &, const IoReactor::SharedPtr &, const std::string & = "",
+    const uint16_t = DEFAULT_PORT);
   ~RealtimeFeedbackTcpInterface();
   void init() noexcept;
+  // Call before init(). Runs on the reactor thread for every packet: keep it short.
+  void setPacketListener(const PacketListener &);
   void getToolVectorActual(double* );
   static rclcpp::Logger getLogger();
   bool isConnected();
+  void setSocketProfile(const SocketProfile &);
   bool isActive();
 
   void getCurrentJointStates(std::array<double, 4> &);
+  // With the kernel receive time of the packet they were taken from
+  void getCurrentJointStates(std::array<double, 4> &, rclcpp::Time &);
   void getCurrentEndPose(Pose &);
-  std::shared_ptr<RealTimeData> getRealtimeData();
+  Snapshot getSnapshot() const;
+  // The returned handle pins its slot: drop it once done reading
+  RealTimeDataPool::Handle getRealtimeData();
   bool getRobotMode(uint64_t &);
   bool isRobotMode(const uint64_t &);
+  // Number of robot mode changes seen, not counting motions starting and stopping
+  // (ENABLE, RUNNING, PAUSE and JOG count as one mode)
+  uint64_t countModeChanges() const;
+  // Number of packets dropped for lack of a free slot
+  uint64_t countDroppedPackets() const;
   void disConnect();
 
 private:
-  void recvData();
+  std::shared_ptr<TcpSocketHandler> getSocket() override;
+  uint32_t getEvents() const override;
+  void onConnected() override;
+  void onDisconnected() override;
+  void onReadable() override;
+  void onTimer(const IoReactor::SteadyClock::time_point &) override;
+  void updateData(RealTimeDataPool::Handle, const int64_t stamp_ns = 0);
+  static uint64_t toControllerMode(const uint64_t);
 };
 }  // namespace mg400_interface
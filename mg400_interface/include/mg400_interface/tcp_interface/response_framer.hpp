@@ -0,0 +1,56 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace mg400_interface
+{
+// Splits a byte stream into frames ending with a terminator
+// (';' for dashboard responses such as "0,{},EnableRobot();").
+//
+// Bytes are received straight into a fixed buffer whose storage is recycled:
+// consumed space is reclaimed by rewinding when empty, or by moving the pending
+// partial frame to the front when the end is reached, so every frame is contiguous.
+class ResponseFramer
+{
+private:
+  std::vector<char> buf_;
+  const char terminator_;
+  size_t begin_;  // first unconsumed byte
+  size_t end_;  // one past the last received byte
+  size_t scan_;  // no terminator in [begin_, scan_)
+
+public:
+  explicit ResponseFramer(const size_t capacity = 4096, const char terminator = ';');
+
+  // Free space to receive into. Zero means a frame is longer than the capacity.
+  // Invalidates frames returned by next().
+  char * prepare(size_t & writable);
+  void commit(const size_t);
+
+  bool hasFrame();
+  // The next complete frame including its terminator.
+  // Stays valid until the next call to prepare() or clear().
+  bool next(std::string_view &);
+
+  // Drops received bytes, including a partial frame
+  void clear();
+  size_t size() const;
+  size_t capacity() const;
+};
+}  // namespace mg400_interface
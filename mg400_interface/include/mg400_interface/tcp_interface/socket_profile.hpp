@@ -0,0 +1,41 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+namespace mg400_interface
+{
+// Socket options applied to a TcpSocketHandler each time it connects.
+// Zero / false keeps the kernel default.
+struct SocketProfile
+{
+  // Disable Nagle's algorithm so small commands leave immediately
+  bool tcp_nodelay = false;
+  // Acknowledge immediately instead of delaying ACKs (re-armed after every read)
+  bool tcp_quickack = false;
+  int rcvbuf = 0;  // [bytes]
+  int sndbuf = 0;  // [bytes]
+  int priority = 0;  // SO_PRIORITY, 0 to 6 without CAP_NET_ADMIN
+  int busy_poll = 0;  // [us]
+  bool keepalive = false;
+  int keepalive_idle = 0;  // [s]
+  int keepalive_interval = 0;  // [s]
+  int keepalive_count = 0;
+  int user_timeout = 0;  // TCP_USER_TIMEOUT [ms]
+
+  std::string toString() const;
+};
+}  // namespace mg400_interface
@@ -14,16 +14,26 @@
 
 #pragma once
 
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/select.h>
 #include <cerrno>
+#include <ctime>
+#include <mutex>
 #include <utility>
 #include <string>
+#include <vector>
 #include <rclcpp/rclcpp.hpp>
 
+#include "mg400_interface/tcp_interface/socket_profile.hpp"
+#include "mg400_interface/tcp_interface/wire_tap.hpp"
+
 namespace mg400_interface
 {
 
@@ -37,13 +47,22 @@ public:
   {}
 };
 
+// Any thread may send while the reactor thread receives, connects and closes.
+// Closing shuts the connection down at once, but the fd is only closed once
+// no call uses it any more, so its number is never reused under a sender.
 class TcpSocketHandler
 {
 private:
+  mutable std::mutex fd_mutex_;
   int fd_;
+  // Calls using an fd, and fds shut down while in use
+  int users_;
+  std::vector<int> closing_fds_;
   uint16_t port_;
   std::string ip_;
   std::atomic<bool> is_connected_;
+  SocketProfile profile_;
+  bool rx_timestamps_;
 
 public:
   TcpSocketHandler(std::string, uint16_t);
@@ -51,11 +70,40 @@ public:
   ~TcpSocketHandler();
 
   void close();
+  // Takes effect from the next connection
+  void setProfile(const SocketProfile &);
+  const SocketProfile & getProfile() const;
+  // Have the kernel stamp received data (SO_TIMESTAMPNS). Takes effect from the next connection
+  void setRxTimestamps(const bool);
   void connect(const std::chrono::nanoseconds &);
+  // Non-blocking connect in two steps: returns true when already connected,
+  // otherwise call finishConnect() once the fd becomes writable.
+  bool startConnect(const std::chrono::nanoseconds &);
+  void finishConnect();
   void disConnect();
   bool isConnected() const;
+  bool isConnecting() const;
+  int getFd() const;
   void send(const void *, uint32_t);
+  // Gathers every buffer into a single system call where the socket allows.
+  // The iovec array is consumed.
+  void sendv(iovec *, size_t);
   bool recv(void *, uint32_t, const std::chrono::nanoseconds &);
+  uint32_t tryRecv(void *, uint32_t);
+  // Also returns the CLOCK_REALTIME arrival time of the data read last.
+  // Falls back to the read time when the kernel supplied no timestamp.
+  uint32_t tryRecv(void *, uint32_t, timespec &);
   std::string toString();
+
+private:
+  // Throws if not connected. Pair with releaseFd().
+  int acquireFd();
+  void releaseFd();
+  // Disconnects only if fd is still the current one
+  void dropFd(const int);
+  // Requires fd_mutex_
+  void shutdownFd();
+  void applyProfile(const int);
+  bool setOption(const int, const int, const int, const int, const char *);
 };
 }  // namespace mg400_interface
@@ -0,0 +1,118 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace mg400_interface
+{
+// Opt-in capture of every frame sent to or received from the MG400.
+// Each producing thread copies frames into its own lock-free SPSC ring and
+// a background thread appends them to a binary file.
+// While disabled, record() costs a single relaxed atomic load.
+class WireTap
+{
+public:
+  enum class Direction : uint8_t
+  {
+    SEND = 0,
+    RECV = 1
+  };
+
+#pragma pack(push, 1)
+  struct FileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+  };
+
+  struct RecordHeader
+  {
+    int64_t stamp_ns;  // CLOCK_REALTIME
+    uint16_t port;
+    uint8_t direction;
+    uint8_t reserved;
+    uint32_t len;
+  };
+#pragma pack(pop)
+
+  static constexpr char MAGIC[8] = "MG4WTAP";
+  static constexpr uint32_t VERSION = 1;
+  // Longer frames are split into several records
+  static constexpr uint32_t MAX_PAYLOAD = 1440;
+
+private:
+  static std::atomic<bool> is_enabled_;
+
+public:
+  WireTap() = delete;
+
+  static rclcpp::Logger getLogger();
+
+  // Start capturing into the given file. Returns false if it cannot be opened.
+  static bool start(const std::string &);
+  static void stop();
+
+  static bool isEnabled() noexcept
+  {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  static void record(
+    const Direction direction, const uint16_t port,
+    const void * buf, const uint32_t len) noexcept
+  {
+    if (isEnabled()) {
+      push(direction, port, buf, len);
+    }
+  }
+
+  // Frames lost because a ring was full since start()
+  static uint64_t getDroppedCount();
+
+private:
+  static void push(const Direction, const uint16_t, const void *, const uint32_t) noexcept;
+};
+
+class WireTapReader
+{
+public:
+  struct Record
+  {
+    std::chrono::nanoseconds stamp;
+    uint16_t port;
+    WireTap::Direction direction;
+    std::string payload;
+  };
+
+private:
+  FILE * fp_;
+
+public:
+  WireTapReader() = delete;
+  explicit WireTapReader(const std::string &);
+  ~WireTapReader();
+
+  // Returns false at the end of the file
+  bool next(Record &);
+};
+}  // namespace mg400_interface
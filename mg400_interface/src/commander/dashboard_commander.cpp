@@ -14,6 +14,12 @@
 
 #include "mg400_interface/commander/dashboard_commander.hpp"
 
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
 namespace mg400_interface
 {
 using namespace std::chrono_literals;  // NOLINT
@@ -22,7 +28,10 @@ DashboardCommander::DashboardCommander(
   DashboardTcpInterfaceBase * tcp_if,
   const std::chrono::nanoseconds timeout)
 : tcp_if_(tcp_if),
-  clock_(std::make_shared<rclcpp::Clock>(RCL_STEADY_TIME)),
+  feedback_max_age_(0),
+  settings_(std::make_unique<SettingsCache>()),
+  latency_(std::make_unique<LatencyStats>()),
+  pipeline_(std::make_unique<DashboardPipeline>(tcp_if)),
   TIMEOUT(timeout)
 {
 }
@@ -34,29 +43,64 @@ void DashboardCommander::enableRobot() const
     this->sendAndWaitResponse("EnableRobot()"));
 }
 
+void DashboardCommander::enableRobot(const Callback<void> & callback) const
+{
+  this->sendAsync<void>("EnableRobot()", evaluateResponse, callback);
+}
+
 void DashboardCommander::disableRobot() const
 {
   this->evaluateResponse(
-    this->sendAndWaitResponse("DisableRobot()"));
+    this->sendAndWaitResponse("DisableRobot()", DashboardPipeline::Priority::URGENT));
+}
+
+void DashboardCommander::disableRobot(const Callback<void> & callback) const
+{
+  this->sendAsync<void>(
+    "DisableRobot()", evaluateResponse, callback, DashboardPipeline::Priority::URGENT);
 }
 
 void DashboardCommander::clearError() const
 {
+  // Settings may be restored by the controller
+  this->settings_->invalidate();
   this->evaluateResponse(
     this->sendAndWaitResponse("ClearError()"));
 }
 
+void DashboardCommander::clearError(const Callback<void> & callback) const
+{
+  this->settings_->invalidate();
+  this->sendAsync<void>("ClearError()", evaluateResponse, callback);
+}
+
 void DashboardCommander::resetRobot() const
 {
+  // Settings may be restored by the controller
+  this->settings_->invalidate();
   this->evaluateResponse(
     this->sendAndWaitResponse("ResetRobot()"));
 }
 
+void DashboardCommander::resetRobot(const Callback<void> & callback) const
+{
+  this->settings_->invalidate();
+  this->sendAsync<void>("ResetRobot()", evaluateResponse, callback);
+}
+
 void DashboardCommander::speedFactor(const int ratio) const
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "SpeedFactor(%d)", ratio);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::speedFactor(
+  const int ratio, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "SpeedFactor(%d)", ratio);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::user(const User & user) const
@@ -64,44 +108,90 @@ void DashboardCommander::user(const User & user) const
   this->user(user.user);
 }
 
+void DashboardCommander::user(
+  const User & user, const Callback<void> & callback) const
+{
+  this->user(user.user, callback);
+}
+
 void DashboardCommander::user(const User::_user_type & index) const
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "User(%u)", index);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::user(
+  const User::_user_type & index, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "User(%u)", index);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::tool(const Tool & tool) const
 {
-  return this->tool(tool.tool);
+  this->tool(tool.tool);
+}
+
+void DashboardCommander::tool(
+  const Tool & tool, const Callback<void> & callback) const
+{
+  this->tool(tool.tool, callback);
 }
 
 void DashboardCommander::tool(const Tool::_tool_type & index) const
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "Tool(%u)", index);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::tool(
+  const Tool::_tool_type & index, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "Tool(%u)", index);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 uint64_t DashboardCommander::robotMode() const
 {
-  static DashboardResponse response;
-  ResponseParser::parseResponse(
-    this->sendAndWaitResponse("RobotMode()"), response);
-  if (!response.result) {
-    throw std::runtime_error("Dobot not return 0");
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (this->takeFreshFeedback(feedback)) {
+    return feedback.robot_mode;
+  }
+  return this->takeRobotMode(this->sendAndWaitResponse("RobotMode()"));
+}
+
+void DashboardCommander::robotMode(const Callback<uint64_t> & callback) const
+{
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (this->takeFreshFeedback(feedback)) {
+    answer(callback, feedback.robot_mode);
+    return;
   }
-  return static_cast<uint64_t>(ResponseParser::takeInt(response.ret_val));
+  this->sendAsync<uint64_t>("RobotMode()", takeRobotMode, callback);
 }
 
 void DashboardCommander::payload(
   const double weight,
   const double inertia) const
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(
     buf, sizeof(buf), "PayLoad(%.3lf,%.3lf)", weight, inertia);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::payload(
+  const double weight,
+  const double inertia, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(
+    buf, sizeof(buf), "PayLoad(%.3lf,%.3lf)", weight, inertia);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::DO(
@@ -110,251 +200,439 @@ void DashboardCommander::DO(
   this->DO(do_index.index, do_status.status);
 }
 
+void DashboardCommander::DO(
+  const DOIndex & do_index, const DOStatus & do_status, const Callback<void> & callback) const
+{
+  this->DO(do_index.index, do_status.status, callback);
+}
+
 void DashboardCommander::DO(
   const DOIndex::_index_type & do_index,
   const DOStatus::_status_type & do_status) const
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "DO(%u,%u)", do_index, do_status);
   this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
 }
 
+void DashboardCommander::DO(
+  const DOIndex::_index_type & do_index,
+  const DOStatus::_status_type & do_status, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "DO(%u,%u)", do_index, do_status);
+  this->sendAsync<void>(std::string(buf, cx), evaluateResponse, callback);
+}
+
 void DashboardCommander::toolDOExecute(
   const ToolDOIndex & tool_do_index, const DOStatus & do_status) const
 {
   this->toolDOExecute(tool_do_index.index, do_status.status);
 }
 
+void DashboardCommander::toolDOExecute(
+  const ToolDOIndex & tool_do_index, const DOStatus & do_status,
+  const Callback<void> & callback) const
+{
+  this->toolDOExecute(tool_do_index.index, do_status.status, callback);
+}
+
 void DashboardCommander::toolDOExecute(
   const ToolDOIndex::_index_type & tool_do_index,
   const DOStatus::_status_type & do_status) const
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(
     buf, sizeof(buf), "ToolDOExecute(%u,%u)",
     tool_do_index, do_status);
   this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
 }
 
+void DashboardCommander::toolDOExecute(
+  const ToolDOIndex::_index_type & tool_do_index,
+  const DOStatus::_status_type & do_status, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(
+    buf, sizeof(buf), "ToolDOExecute(%u,%u)",
+    tool_do_index, do_status);
+  this->sendAsync<void>(std::string(buf, cx), evaluateResponse, callback);
+}
+
 void DashboardCommander::accJ(const int R)
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "AccJ(%d)", R);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::accJ(
+  const int R, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "AccJ(%d)", R);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::accL(const int R)
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "AccL(%d)", R);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::accL(
+  const int R, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "AccL(%d)", R);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::speedJ(const int R)
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "SpeedJ(%d)", R);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::speedJ(
+  const int R, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "SpeedJ(%d)", R);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::speedL(const int R)
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "SpeedL(%d)", R);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::speedL(
+  const int R, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "SpeedL(%d)", R);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::arch(const ArchIndex & index)
 {
-  return this->arch(index.index);
+  this->arch(index.index);
+}
+
+void DashboardCommander::arch(
+  const ArchIndex & index, const Callback<void> & callback)
+{
+  this->arch(index.index, callback);
 }
 
 void DashboardCommander::arch(const ArchIndex::_index_type & arch_index)
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "Arch(%u)", arch_index);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::arch(
+  const ArchIndex::_index_type & arch_index, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "Arch(%u)", arch_index);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 void DashboardCommander::cp(const int R)
 {
-  static char buf[128];
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "CP(%d)", R);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::cp(
+  const int R, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "CP(%d)", R);
+  this->sendSetting(std::string(buf, cx), callback);
 }
-/*
-bool DashboardCommander::runScript(const std::string & name)
+
+void DashboardCommander::runScript(const std::string & name) const
+{
+  // Names come from action goals: no fixed buffer
+  this->evaluateResponse(
+    this->sendAndWaitResponse(this->formatCommand("RunScript(%s)", name.c_str())));
+}
+
+void DashboardCommander::runScript(
+  const std::string & name, const Callback<void> & callback) const
 {
-  char buf[100];
-  snprintf(buf, sizeof(buf), "RunScript(%s)", name.c_str());
-  return this->sendCommand(buf);
+  this->sendAsync<void>(
+    this->formatCommand("RunScript(%s)", name.c_str()), evaluateResponse, callback);
 }
 
-bool DashboardCommander::stopScript()
+void DashboardCommander::stopScript() const
 {
-  return this->sendCommand("StopScript()");
+  this->evaluateResponse(this->sendAndWaitResponse("StopScript()"));
 }
 
-bool DashboardCommander::pauseScript()
+void DashboardCommander::stopScript(const Callback<void> & callback) const
 {
-  return this->sendCommand("PauseScript()");
+  this->sendAsync<void>("StopScript()", evaluateResponse, callback);
 }
 
-bool DashboardCommander::continueScript()
+void DashboardCommander::pauseScript() const
 {
-  return this->sendCommand("ContinueScript()");
+  this->evaluateResponse(this->sendAndWaitResponse("PauseScript()"));
 }
-*/
+
+void DashboardCommander::pauseScript(const Callback<void> & callback) const
+{
+  this->sendAsync<void>("PauseScript()", evaluateResponse, callback);
+}
+
+void DashboardCommander::continueScript() const
+{
+  this->evaluateResponse(this->sendAndWaitResponse("ContinueScript()"));
+}
+
+void DashboardCommander::continueScript(const Callback<void> & callback) const
+{
+  this->sendAsync<void>("ContinueScript()", evaluateResponse, callback);
+}
+
 void DashboardCommander::setCollisionLevel(const CollisionLevel & level)
 {
   this->setCollisionLevel(level.level);
 }
 
 void DashboardCommander::setCollisionLevel(
-  const CollisionLevel::_level_type & level)
+  const CollisionLevel & level, const Callback<void> & callback)
 {
-  static char buf[128];
+  this->setCollisionLevel(level.level, callback);
+}
+
+void DashboardCommander::setCollisionLevel(const CollisionLevel::_level_type & level)
+{
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "SetCollisionLevel(%u)", level);
-  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+  this->sendSetting(std::string(buf, cx));
+}
+
+void DashboardCommander::setCollisionLevel(
+  const CollisionLevel::_level_type & level, const Callback<void> & callback)
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "SetCollisionLevel(%u)", level);
+  this->sendSetting(std::string(buf, cx), callback);
 }
 
 std::vector<double> DashboardCommander::getAngle()
 {
-  static DashboardResponse response;
-  ResponseParser::parseResponse(
-    this->sendAndWaitResponse("GetAngle()"), response);
-  if (!response.result) {
-    throw std::runtime_error("Dobot not return 0");
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (this->takeFreshFeedback(feedback)) {
+    return angleFromFeedback(feedback);
   }
-  return ResponseParser::takeAngleArray(response.ret_val);
+  return this->takeAngle(this->sendAndWaitResponse("GetAngle()"));
+}
+
+void DashboardCommander::getAngle(const Callback<std::vector<double>> & callback)
+{
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (this->takeFreshFeedback(feedback)) {
+    answer(callback, angleFromFeedback(feedback));
+    return;
+  }
+  this->sendAsync<std::vector<double>>("GetAngle()", takeAngle, callback);
 }
 
 std::vector<double> DashboardCommander::getPose()
 {
-  static DashboardResponse response;
-  ResponseParser::parseResponse(
-    this->sendAndWaitResponse("GetPose()"), response);
-  if (!response.result) {
-    throw std::runtime_error("Dobot not return 0");
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (this->takeFreshFeedback(feedback)) {
+    return poseFromFeedback(feedback);
   }
-  return ResponseParser::takePoseArray(response.ret_val);
+  return this->takePose(this->sendAndWaitResponse("GetPose()"));
+}
+
+void DashboardCommander::getPose(const Callback<std::vector<double>> & callback)
+{
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (this->takeFreshFeedback(feedback)) {
+    answer(callback, poseFromFeedback(feedback));
+    return;
+  }
+  this->sendAsync<std::vector<double>>("GetPose()", takePose, callback);
 }
 
 void DashboardCommander::emergencyStop()
 {
-  this->evaluateResponse(this->sendAndWaitResponse("EmergencyStop()"));
+  this->evaluateResponse(
+    this->sendAndWaitResponse("EmergencyStop()", DashboardPipeline::Priority::URGENT));
+}
+
+void DashboardCommander::emergencyStop(const Callback<void> & callback)
+{
+  this->sendAsync<void>(
+    "EmergencyStop()", evaluateResponse, callback, DashboardPipeline::Priority::URGENT);
 }
-/*
+
 int DashboardCommander::modbusCreate(
   const std::string & ip, const int port,
-  const int slave_id, const int isRTU)
-{
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "ModbusCreate(%s,%d,%d,%d)",
-    ip.c_str(), port, slave_id, isRTU);
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  int ret = ResponseParser::parseOneValue(res);
-  return ret;
+  const int slave_id, const bool is_rtu) const
+{
+  const std::string cmd = this->formatCommand(
+    "ModbusCreate(%s,%d,%d,%d)", ip.c_str(), port, slave_id, is_rtu ? 1 : 0);
+  return this->takeInt(this->sendAndWaitResponse(cmd));
 }
 
-bool DashboardCommander::modbusClose(const std::string & index)
+void DashboardCommander::modbusCreate(
+  const std::string & ip, const int port,
+  const int slave_id, const bool is_rtu, const Callback<int> & callback) const
 {
-  char buf[100];
-  snprintf(buf, sizeof(buf), "ModbusClose(%s)", index.c_str());
-  return sendCommand(buf);
+  const std::string cmd = this->formatCommand(
+    "ModbusCreate(%s,%d,%d,%d)", ip.c_str(), port, slave_id, is_rtu ? 1 : 0);
+  this->sendAsync<int>(cmd, takeInt, callback);
+}
+
+void DashboardCommander::modbusClose(const int index) const
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "ModbusClose(%d)", index);
+  this->evaluateResponse(this->sendAndWaitResponse(std::string(buf, cx)));
+}
+
+void DashboardCommander::modbusClose(
+  const int index, const Callback<void> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "ModbusClose(%d)", index);
+  this->sendAsync<void>(std::string(buf, cx), evaluateResponse, callback);
 }
 
 std::vector<int> DashboardCommander::getInBits(
-  const int index, const int addr, const int count)
+  const int index, const int addr, const int count) const
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "GetInBits(%d,%d,%d)",
-    index, addr, count);
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  return ResponseParser::parseArray(res, count);
+  char buf[128];
+  const int cx = snprintf(
+    buf, sizeof(buf), "GetInBits(%d,%d,%d)", index, addr, count);
+  return this->takeIntArray(this->sendAndWaitResponse(std::string(buf, cx)));
+}
+
+void DashboardCommander::getInBits(
+  const int index, const int addr, const int count,
+  const Callback<std::vector<int>> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(
+    buf, sizeof(buf), "GetInBits(%d,%d,%d)", index, addr, count);
+  this->sendAsync<std::vector<int>>(std::string(buf, cx), takeIntArray, callback);
 }
 
 std::vector<int> DashboardCommander::getInRegs(
   const int index, const int addr,
-  const int count, const std::string & valType)
-{
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "GetInRegs(%d,%d,%d,{%s})",
-    index, addr, count, valType.c_str());
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  std::vector<int> ret = ResponseParser::parseArray(res, count);
-  return ret;
+  const int count, const std::string & val_type) const
+{
+  const std::string cmd = this->formatCommand(
+    "GetInRegs(%d,%d,%d,%s)", index, addr, count, val_type.c_str());
+  return this->takeIntArray(this->sendAndWaitResponse(cmd));
+}
+
+void DashboardCommander::getInRegs(
+  const int index, const int addr, const int count,
+  const std::string & val_type, const Callback<std::vector<int>> & callback) const
+{
+  const std::string cmd = this->formatCommand(
+    "GetInRegs(%d,%d,%d,%s)", index, addr, count, val_type.c_str());
+  this->sendAsync<std::vector<int>>(cmd, takeIntArray, callback);
 }
 
 std::vector<int> DashboardCommander::getCoils(
-  const int index, const int addr, const int count)
-{
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "GetCoils(%d,%d,%d)",
-    index, addr, count);
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  std::vector<int> ret = ResponseParser::parseArray(res, count);
-  return ret;
+  const int index, const int addr, const int count) const
+{
+  char buf[128];
+  const int cx = snprintf(
+    buf, sizeof(buf), "GetCoils(%d,%d,%d)", index, addr, count);
+  return this->takeIntArray(this->sendAndWaitResponse(std::string(buf, cx)));
 }
 
-int DashboardCommander::setCoils(
-  const int index, const int addr,
-  const int count, const std::string & valTab)
-{
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "SetCoils(%d,%d,%d,{%s})",
-    index, addr, count, valTab.c_str());
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  int ret = ResponseParser::parseOnlyErrorID(res);
-  return ret;
+void DashboardCommander::getCoils(
+  const int index, const int addr, const int count,
+  const Callback<std::vector<int>> & callback) const
+{
+  char buf[128];
+  const int cx = snprintf(
+    buf, sizeof(buf), "GetCoils(%d,%d,%d)", index, addr, count);
+  this->sendAsync<std::vector<int>>(std::string(buf, cx), takeIntArray, callback);
+}
+
+void DashboardCommander::setCoils(
+  const int index, const int addr, const std::vector<int> & values) const
+{
+  const std::string cmd = this->formatCommand(
+    "SetCoils(%d,%d,%zu,%s)", index, addr, values.size(), this->joinValues(values).c_str());
+  this->evaluateResponse(this->sendAndWaitResponse(cmd));
+}
+
+void DashboardCommander::setCoils(
+  const int index, const int addr, const std::vector<int> & values,
+  const Callback<void> & callback) const
+{
+  const std::string cmd = this->formatCommand(
+    "SetCoils(%d,%d,%zu,%s)", index, addr, values.size(), this->joinValues(values).c_str());
+  this->sendAsync<void>(cmd, evaluateResponse, callback);
 }
 
 std::vector<int> DashboardCommander::getHoldRegs(
   const int index, const int addr,
-  const int count, const std::string & valType)
+  const int count, const std::string & val_type) const
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "GetHoldRegs(%d,%d,%d,%s)",
-    index, addr, count, valType.c_str());
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  return ResponseParser::parseArray(res, count);
+  const std::string cmd = this->formatCommand(
+    "GetHoldRegs(%d,%d,%d,%s)", index, addr, count, val_type.c_str());
+  return this->takeIntArray(this->sendAndWaitResponse(cmd));
 }
 
-int DashboardCommander::setHoldRegs(
+void DashboardCommander::getHoldRegs(
+  const int index, const int addr, const int count,
+  const std::string & val_type, const Callback<std::vector<int>> & callback) const
+{
+  const std::string cmd = this->formatCommand(
+    "GetHoldRegs(%d,%d,%d,%s)", index, addr, count, val_type.c_str());
+  this->sendAsync<std::vector<int>>(cmd, takeIntArray, callback);
+}
+
+void DashboardCommander::setHoldRegs(
   const int index, const int addr,
-  const int count, const std::string & valTab, const std::string & valType)
+  const std::vector<int> & values, const std::string & val_type) const
+{
+  const std::string cmd = this->formatCommand(
+    "SetHoldRegs(%d,%d,%zu,%s,%s)", index, addr, values.size(),
+    this->joinValues(values).c_str(), val_type.c_str());
+  this->evaluateResponse(this->sendAndWaitResponse(cmd));
+}
+
+void DashboardCommander::setHoldRegs(
+  const int index, const int addr, const std::vector<int> & values,
+  const std::string & val_type, const Callback<void> & callback) const
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf), "SetHoldRegs(%d,%d,%d,{%s},%s)",
-    index, addr, count, valTab.c_str(), valType.c_str());
-  this->tcp_if_->sendCommand(buf);
-  std::string res = this->tcp_if_->recvResponse();
-  return ResponseParser::parseOnlyErrorID(res);
+  const std::string cmd = this->formatCommand(
+    "SetHoldRegs(%d,%d,%zu,%s,%s)", index, addr, values.size(),
+    this->joinValues(values).c_str(), val_type.c_str());
+  this->sendAsync<void>(cmd, evaluateResponse, callback);
 }
-*/
 
 std::array<std::vector<int>, 6> DashboardCommander::getErrorId() const
 {
-  static DashboardResponse response;
-  ResponseParser::parseResponse(
-    this->sendAndWaitResponse("GetErrorID()"), response);
-  if (!response.result) {
-    throw std::runtime_error("Dobot Not return 0");
-  }
-  return ResponseParser::takeErrorMessage(response.ret_val);
+  return this->takeErrorId(this->sendAndWaitResponse("GetErrorID()"));
+}
+
+void DashboardCommander::getErrorId(
+  const Callback<std::array<std::vector<int>, 6>> & callback) const
+{
+  this->sendAsync<std::array<std::vector<int>, 6>>("GetErrorID()", takeErrorId, callback);
 }
 
 int DashboardCommander::DI(const DIIndex & do_index) const
@@ -364,15 +642,32 @@ int DashboardCommander::DI(const DIIndex & do_index) const
 
 int DashboardCommander::DI(const DIIndex::_index_type & di_index) const
 {
-  static DashboardResponse response;
-  static char buf[128];
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (di_index >= 1 && di_index <= 64 && this->takeFreshFeedback(feedback)) {
+    // Bit 0 is D1
+    return static_cast<int>((feedback.digital_inputs >> (di_index - 1)) & 1);
+  }
+  char buf[128];
   const int cx = snprintf(buf, sizeof(buf), "DI(%u)", di_index);
-  ResponseParser::parseResponse(
-    this->sendAndWaitResponse(std::string(buf, cx)), response);
-  if (!response.result) {
-    throw std::runtime_error("Dobot Not return 0");
+  return this->takeInt(this->sendAndWaitResponse(std::string(buf, cx)));
+}
+
+void DashboardCommander::DI(const DIIndex & do_index, const Callback<int> & callback) const
+{
+  this->DI(do_index.index, callback);
+}
+
+void DashboardCommander::DI(
+  const DIIndex::_index_type & di_index, const Callback<int> & callback) const
+{
+  RealtimeFeedbackTcpInterface::Snapshot feedback;
+  if (di_index >= 1 && di_index <= 64 && this->takeFreshFeedback(feedback)) {
+    answer(callback, static_cast<int>((feedback.digital_inputs >> (di_index - 1)) & 1));
+    return;
   }
-  return ResponseParser::takeInt(response.ret_val);
+  char buf[128];
+  const int cx = snprintf(buf, sizeof(buf), "DI(%u)", di_index);
+  this->sendAsync<int>(std::string(buf, cx), takeInt, callback);
 }
 // End DOBOT MG400 Official Command -----------------------------------------
 
@@ -381,29 +676,419 @@ const rclcpp::Logger DashboardCommander::getLogger()
   return rclcpp::get_logger("DashboardCommander");
 }
 
+DashboardPipeline::Request::SharedPtr DashboardCommander::submit(
+  const std::string & command, const DashboardPipeline::Priority priority) const
+{
+  return this->pipeline_->submit(command, priority);
+}
+
+std::string DashboardCommander::wait(
+  const DashboardPipeline::Request::SharedPtr & request) const
+{
+  return this->pipeline_->wait(
+    request, DashboardPipeline::SteadyClock::now() +
+    std::chrono::duration_cast<DashboardPipeline::SteadyClock::duration>(this->TIMEOUT));
+}
+
+DashboardPipeline::DispatchStats DashboardCommander::getUrgentDispatchStats() const
+{
+  return this->pipeline_->getUrgentDispatchStats();
+}
+
+void DashboardCommander::setModeChangeCounter(const std::function<uint64_t()> & counter)
+{
+  this->count_mode_changes_ = counter;
+}
+
+void DashboardCommander::invalidateSettings() const
+{
+  this->settings_->invalidate();
+}
+
+SettingsCache::Stats DashboardCommander::getSettingsCacheStats() const
+{
+  return this->settings_->getStats();
+}
+
+std::vector<DashboardCommander::BatchResult> DashboardCommander::sendBatch(
+  const std::vector<std::string> & commands) const
+{
+  const auto tickets = this->prepareBatch(commands);
+  const auto requests = this->pipeline_->submitBatch(commands);
+  const auto deadline = DashboardPipeline::SteadyClock::now() +
+    std::chrono::duration_cast<DashboardPipeline::SteadyClock::duration>(this->TIMEOUT);
+
+  std::vector<BatchResult> results;
+  results.reserve(requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    std::string response;
+    std::exception_ptr error;
+    try {
+      response = this->pipeline_->wait(requests[i], deadline);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    results.push_back(takeBatchResult(response, error));
+    if (results.back().ok && tickets[i]) {
+      this->settings_->store(commands[i], tickets[i]);
+    }
+  }
+  return results;
+}
+
+void DashboardCommander::sendBatch(
+  const std::vector<std::string> & commands, const BatchCallback & callback) const
+{
+  if (commands.empty()) {
+    callback({});
+    return;
+  }
+
+  struct Progress
+  {
+    std::mutex mutex;
+    std::vector<BatchResult> results;
+    size_t remaining;
+  };
+  auto progress = std::make_shared<Progress>();
+  progress->results.resize(commands.size());
+  progress->remaining = commands.size();
+
+  const auto tickets = this->prepareBatch(commands);
+  // The pipeline runs callbacks on its own thread and is destroyed before the cache
+  SettingsCache * const settings = this->settings_.get();
+  this->pipeline_->submitBatch(
+    commands,
+    [progress, settings, commands, tickets, callback](
+      size_t index, const std::string & response, std::exception_ptr error) {
+      auto result = takeBatchResult(response, error);
+      if (result.ok && tickets[index]) {
+        settings->store(commands[index], tickets[index]);
+      }
+      {
+        std::lock_guard<std::mutex> lock(progress->mutex);
+        progress->results[index] = std::move(result);
+        if (--progress->remaining > 0) {
+          return;
+        }
+      }
+      callback(std::move(progress->results));
+    },
+    DashboardPipeline::SteadyClock::now() +
+    std::chrono::duration_cast<DashboardPipeline::SteadyClock::duration>(this->TIMEOUT));
+}
+
+std::vector<std::pair<std::string, LatencyHistogram::Summary>>
+DashboardCommander::getLatencyStats() const
+{
+  return this->latency_->summarize();
+}
+
+void DashboardCommander::setFeedbackSource(
+  const FeedbackSource & source, const std::chrono::nanoseconds max_age)
+{
+  this->feedback_source_ = source;
+  this->feedback_max_age_ = max_age;
+}
+
 std::string DashboardCommander::sendAndWaitResponse(
-  const std::string & command) const
+  const std::string & command, const DashboardPipeline::Priority priority) const
+{
+  const auto start = DashboardPipeline::SteadyClock::now();
+  const auto request = this->submit(command, priority);
+  auto & histogram = this->latency_->get(request->function);
+  std::string response;
+  try {
+    response = this->wait(request);
+  } catch (...) {
+    this->recordLatency(histogram, start, response, true);
+    throw;
+  }
+  this->recordLatency(histogram, start, response, false);
+  return response;
+}
+
+template<typename T>
+void DashboardCommander::sendAsync(
+  const std::string & command, const Parser<T> & parse, const Callback<T> & callback,
+  const DashboardPipeline::Priority priority) const
+{
+  const auto start = DashboardPipeline::SteadyClock::now();
+  // Entries live as long as the commander, which outlives the pipeline
+  auto * const histogram = &this->latency_->get(DashboardPipeline::takeFunctionName(command));
+  this->pipeline_->submit(
+    command,
+    [this, start, histogram, parse, callback](
+      const std::string & response, std::exception_ptr error) {
+      this->recordLatency(*histogram, start, response, error != nullptr);
+      std::promise<T> promise;
+      try {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+        if constexpr (std::is_void_v<T>) {
+          parse(response);
+          promise.set_value();
+        } else {
+          promise.set_value(parse(response));
+        }
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+      callback(promise.get_future());
+    },
+    DashboardPipeline::SteadyClock::now() +
+    std::chrono::duration_cast<DashboardPipeline::SteadyClock::duration>(this->TIMEOUT),
+    priority);
+}
+
+void DashboardCommander::recordLatency(
+  LatencyHistogram & histogram, const DashboardPipeline::SteadyClock::time_point & start,
+  const std::string & response, const bool is_failed) const
+{
+  const auto elapsed = DashboardPipeline::SteadyClock::now() - start;
+  if (is_failed) {
+    // The pipeline gives up on a response once the timeout passed
+    if (elapsed >= this->TIMEOUT) {
+      histogram.recordTimeout();
+    } else {
+      histogram.recordError();
+    }
+    return;
+  }
+  histogram.record(elapsed);
+  if (response.compare(0, 2, "0,") != 0) {
+    histogram.recordError();
+  }
+}
+
+uint64_t DashboardCommander::getSettingsEpoch() const
+{
+  // Both counts only grow, so their sum changes whenever either does
+  uint64_t epoch = this->tcp_if_->countConnections();
+  if (this->count_mode_changes_) {
+    epoch += this->count_mode_changes_();
+  }
+  return epoch;
+}
+
+void DashboardCommander::sendSetting(const std::string & command) const
+{
+  uint64_t ticket = 0;
+  if (this->settings_->lookup(command, this->getSettingsEpoch(), ticket)) {
+    return;
+  }
+  this->evaluateResponse(this->sendAndWaitResponse(command));
+  this->settings_->store(command, ticket);
+}
+
+void DashboardCommander::sendSetting(
+  const std::string & command, const Callback<void> & callback) const
+{
+  uint64_t ticket = 0;
+  if (this->settings_->lookup(command, this->getSettingsEpoch(), ticket)) {
+    std::promise<void> promise;
+    promise.set_value();
+    callback(promise.get_future());
+    return;
+  }
+  // The pipeline runs callbacks on its own thread and is destroyed before the cache
+  SettingsCache * const settings = this->settings_.get();
+  this->sendAsync<void>(
+    command,
+    [settings, command, ticket](const std::string & response) {
+      evaluateResponse(response);
+      settings->store(command, ticket);
+    },
+    callback);
+}
+
+std::vector<uint64_t> DashboardCommander::prepareBatch(
+  const std::vector<std::string> & commands) const
+{
+  // Zero: not a setting
+  std::vector<uint64_t> tickets(commands.size(), 0);
+  const uint64_t epoch = this->getSettingsEpoch();
+  for (size_t i = 0; i < commands.size(); ++i) {
+    const auto function = DashboardPipeline::takeFunctionName(commands[i]);
+    if (function == "ClearError" || function == "ResetRobot") {
+      this->settings_->invalidate();
+    } else if (isSetting(function)) {
+      tickets[i] = this->settings_->reserve(commands[i], epoch);
+    }
+  }
+  return tickets;
+}
+
+bool DashboardCommander::isSetting(const std::string & function)
+{
+  static const std::array<const char *, 11> SETTINGS = {
+    "SpeedFactor", "User", "Tool", "PayLoad", "AccJ", "AccL", "SpeedJ", "SpeedL",
+    "Arch", "CP", "SetCollisionLevel"};
+  for (const auto setting : SETTINGS) {
+    if (function == setting) {
+      return true;
+    }
+  }
+  return false;
+}
+
+DashboardCommander::BatchResult DashboardCommander::takeBatchResult(
+  const std::string & response, std::exception_ptr error)
+{
+  BatchResult result = {false, response, ""};
+  try {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    evaluateResponse(response);
+    result.ok = true;
+  } catch (const std::exception & ex) {
+    result.error = ex.what();
+  } catch (...) {
+    result.error = "Interface Error";
+  }
+  return result;
+}
+
+bool DashboardCommander::takeFreshFeedback(
+  RealtimeFeedbackTcpInterface::Snapshot & snapshot) const
+{
+  if (!this->feedback_source_) {
+    return false;
+  }
+  snapshot = this->feedback_source_();
+  if (!snapshot.active) {
+    return false;
+  }
+  // Stamped with the kernel receive time on the system clock
+  const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch());
+  return now - std::chrono::nanoseconds(snapshot.stamp_ns) <= this->feedback_max_age_;
+}
+
+template<typename T>
+void DashboardCommander::answer(const Callback<T> & callback, T value)
+{
+  std::promise<T> promise;
+  promise.set_value(std::move(value));
+  callback(promise.get_future());
+}
+
+void DashboardCommander::evaluateResponse(const std::string & packet)
+{
+  DashboardResponse response;
+  ResponseParser::parseResponse(packet, response);
+  if (!response.result) {
+    throw std::runtime_error("Dobot Not return 0");
+  }
+}
+
+uint64_t DashboardCommander::takeRobotMode(const std::string & packet)
+{
+  return static_cast<uint64_t>(takeInt(packet));
+}
+
+int DashboardCommander::takeInt(const std::string & packet)
+{
+  DashboardResponse response;
+  ResponseParser::parseResponse(packet, response);
+  if (!response.result) {
+    throw std::runtime_error("Dobot Not return 0");
+  }
+  return ResponseParser::takeInt(response.ret_val);
+}
+
+std::vector<int> DashboardCommander::takeIntArray(const std::string & packet)
 {
-  this->tcp_if_->sendCommand(command);
+  DashboardResponse response;
+  ResponseParser::parseResponse(packet, response);
+  if (!response.result) {
+    throw std::runtime_error("Dobot Not return 0");
+  }
+  return ResponseParser::takeIntArray(response.ret_val);
+}
 
-  const auto start = this->clock_->now();
-  const auto timeout = rclcpp::Duration(this->TIMEOUT);
-  while (this->clock_->now() - start < timeout) {
-    const std::string res = this->tcp_if_->recvResponse();
-    if (res.find(command) != std::string::npos) {
-      // Could find response candidates
-      return res;
+std::string DashboardCommander::joinValues(const std::vector<int> & values)
+{
+  std::string ret = "{";
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i > 0) {
+      ret += ",";
     }
+    ret += std::to_string(values[i]);
   }
-  throw std::runtime_error("Robot not responded.");
+  return ret + "}";
 }
 
-void DashboardCommander::evaluateResponse(const std::string & packet) const
+std::string DashboardCommander::formatCommand(const char * format, ...)
 {
-  static DashboardResponse response;
+  va_list args;
+  va_start(args, format);
+  va_list args_copy;
+  va_copy(args_copy, args);
+  const int len = vsnprintf(nullptr, 0, format, args_copy);
+  va_end(args_copy);
+  if (len < 0) {
+    va_end(args);
+    throw std::runtime_error(std::string("Failed to format ") + format);
+  }
+  std::string ret(static_cast<size_t>(len), '\0');
+  // Writes the terminating null into the storage std::string keeps for it
+  vsnprintf(ret.data(), ret.size() + 1, format, args);
+  va_end(args);
+  return ret;
+}
+
+std::vector<double> DashboardCommander::takeAngle(const std::string & packet)
+{
+  DashboardResponse response;
+  ResponseParser::parseResponse(packet, response);
+  if (!response.result) {
+    throw std::runtime_error("Dobot not return 0");
+  }
+  return ResponseParser::takeAngleArray(response.ret_val);
+}
+
+std::vector<double> DashboardCommander::takePose(const std::string & packet)
+{
+  DashboardResponse response;
+  ResponseParser::parseResponse(packet, response);
+  if (!response.result) {
+    throw std::runtime_error("Dobot not return 0");
+  }
+  return ResponseParser::takePoseArray(response.ret_val);
+}
+
+std::array<std::vector<int>, 6> DashboardCommander::takeErrorId(const std::string & packet)
+{
+  DashboardResponse response;
   ResponseParser::parseResponse(packet, response);
   if (!response.result) {
     throw std::runtime_error("Dobot Not return 0");
   }
+  return ResponseParser::takeErrorMessage(response.ret_val);
+}
+
+std::vector<double> DashboardCommander::poseFromFeedback(
+  const RealtimeFeedbackTcpInterface::Snapshot & feedback)
+{
+  // Same units as ResponseParser::takePoseArray()
+  std::vector<double> ret(6);
+  for (size_t i = 0; i < ret.size(); ++i) {
+    ret[i] = feedback.tool_vector[i] * TO_M;
+  }
+  return ret;
+}
+
+std::vector<double> DashboardCommander::angleFromFeedback(
+  const RealtimeFeedbackTcpInterface::Snapshot & feedback)
+{
+  // Same units as ResponseParser::takeAngleArray()
+  std::vector<double> ret(6);
+  for (size_t i = 0; i < ret.size(); ++i) {
+    ret[i] = feedback.q_actual[i] * TO_RADIAN;
+  }
+  return ret;
 }
 }  // namespace mg400_interface
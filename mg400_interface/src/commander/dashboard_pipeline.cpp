@@ -0,0 +1,428 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/dashboard_pipeline.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "mg400_interface/commander/response_parser.hpp"
+
+namespace mg400_interface
+{
+DashboardPipeline::Request::Request(const std::string & cmd)
+: command(cmd),
+  function(DashboardPipeline::takeFunctionName(cmd)),
+  state_(State::PENDING),
+  priority_(Priority::NORMAL),
+  is_notified_(false),
+  is_abandoned_(false)
+{
+}
+
+DashboardPipeline::DashboardPipeline(DashboardTcpInterfaceBase * tcp_if)
+: tcp_if_(tcp_if),
+  is_sending_(false),
+  connections_(tcp_if->countConnections()),
+  urgent_stats_{0, SteadyClock::duration::zero(), SteadyClock::duration::zero()},
+  is_receiving_(false),
+  is_stopping_(false)
+{
+}
+
+DashboardPipeline::~DashboardPipeline()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->is_stopping_ = true;
+  }
+  this->cv_.notify_all();
+  if (this->io_thread_.joinable()) {
+    this->io_thread_.join();
+  }
+}
+
+rclcpp::Logger DashboardPipeline::getLogger()
+{
+  return rclcpp::get_logger("DashboardPipeline");
+}
+
+DashboardPipeline::Request::SharedPtr DashboardPipeline::submit(
+  const std::string & command, const Priority priority)
+{
+  auto request = std::make_shared<Request>(command);
+  request->priority_ = priority;
+  this->enqueue({request});
+  return request;
+}
+
+void DashboardPipeline::submit(
+  const std::string & command, const Request::Callback & callback,
+  const SteadyClock::time_point & deadline, const Priority priority)
+{
+  auto request = std::make_shared<Request>(command);
+  request->callback_ = callback;
+  request->deadline_ = deadline;
+  request->priority_ = priority;
+
+  this->startIoThread();
+  this->enqueue({request});
+}
+
+std::vector<DashboardPipeline::Request::SharedPtr> DashboardPipeline::submitBatch(
+  const std::vector<std::string> & commands)
+{
+  Batch batch;
+  batch.reserve(commands.size());
+  for (const auto & command : commands) {
+    batch.push_back(std::make_shared<Request>(command));
+  }
+  this->enqueue(batch);
+  return batch;
+}
+
+void DashboardPipeline::submitBatch(
+  const std::vector<std::string> & commands, const BatchCallback & callback,
+  const SteadyClock::time_point & deadline)
+{
+  Batch batch;
+  batch.reserve(commands.size());
+  for (size_t i = 0; i < commands.size(); ++i) {
+    auto request = std::make_shared<Request>(commands[i]);
+    request->callback_ =
+      [callback, i](const std::string & response, std::exception_ptr error) {
+        callback(i, response, error);
+      };
+    request->deadline_ = deadline;
+    batch.push_back(request);
+  }
+
+  this->startIoThread();
+  this->enqueue(batch);
+}
+
+std::string DashboardPipeline::wait(
+  const Request::SharedPtr & request, const SteadyClock::time_point & deadline)
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (request->state_ == Request::State::PENDING) {
+    if (!this->is_receiving_ && !this->io_thread_.joinable()) {
+      // Receive on behalf of every waiting caller
+      this->is_receiving_ = true;
+      lock.unlock();
+      std::string response;
+      std::exception_ptr error;
+      try {
+        response = this->tcp_if_->recvResponse();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      this->is_receiving_ = false;
+      std::vector<Request::SharedPtr> finished;
+      if (error) {
+        // Nothing in flight will be answered on this connection, this request included
+        this->fail(error, finished);
+      } else if (!response.empty()) {
+        this->complete(response, finished);
+      }
+      this->cv_.notify_all();
+      if (!finished.empty()) {
+        // Requests with a callback submitted before the I/O thread started
+        lock.unlock();
+        this->notify(finished);
+        lock.lock();
+      }
+    } else {
+      this->cv_.wait_until(lock, deadline);
+    }
+
+    if (request->state_ == Request::State::PENDING && SteadyClock::now() >= deadline) {
+      // Stays queued: its late response must not be taken for the next one
+      request->is_abandoned_ = true;
+      throw std::runtime_error("Robot not responded.");
+    }
+  }
+
+  if (request->state_ == Request::State::FAILED) {
+    std::rethrow_exception(request->error_);
+  }
+  return request->response_;
+}
+
+size_t DashboardPipeline::countInFlight()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->in_flight_.size();
+}
+
+std::string DashboardPipeline::takeFunctionName(const std::string & call)
+{
+  return call.substr(0, call.find('('));
+}
+
+DashboardPipeline::DispatchStats DashboardPipeline::getUrgentDispatchStats()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->urgent_stats_;
+}
+
+void DashboardPipeline::startIoThread()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (!this->io_thread_.joinable()) {
+    this->io_thread_ = std::thread(&DashboardPipeline::run, this);
+  }
+}
+
+void DashboardPipeline::enqueue(Batch batch)
+{
+  if (batch.empty()) {
+    return;
+  }
+  const auto now = SteadyClock::now();
+  for (auto & request : batch) {
+    request->submitted_at_ = now;
+  }
+  if (batch.front()->priority_ == Priority::URGENT) {
+    this->urgent_.push(std::move(batch));
+  } else {
+    this->submitted_.push(std::move(batch));
+  }
+  this->flush();
+}
+
+void DashboardPipeline::flush()
+{
+  while (!this->urgent_.empty() || !this->submitted_.empty()) {
+    if (this->is_sending_.exchange(true)) {
+      // The current sender also takes what was pushed before this check
+      return;
+    }
+    Batch batch;
+    while (this->popNext(batch)) {
+      this->send(batch);
+    }
+    this->is_sending_.store(false);
+  }
+}
+
+bool DashboardPipeline::popNext(Batch & batch)
+{
+  // Checked again before every write so an urgent request never waits for the backlog
+  return this->urgent_.pop(batch) || this->submitted_.pop(batch);
+}
+
+void DashboardPipeline::send(const Batch & batch)
+{
+  // Queued before sending: the response may come back right away
+  std::vector<Request::SharedPtr> stale;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->failStale(stale);
+    this->in_flight_.insert(this->in_flight_.end(), batch.begin(), batch.end());
+  }
+  this->cv_.notify_all();
+  this->notify(stale);
+
+  try {
+    if (batch.size() == 1) {
+      this->tcp_if_->sendCommand(batch.front()->command);
+    } else {
+      std::vector<std::string> commands;
+      commands.reserve(batch.size());
+      for (const auto & request : batch) {
+        commands.push_back(request->command);
+      }
+      this->tcp_if_->sendCommands(commands);
+    }
+    for (const auto & request : batch) {
+      if (request->priority_ == Priority::URGENT) {
+        this->recordDispatch(request);
+      }
+    }
+    return;
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (const auto & request : batch) {
+      for (auto it = this->in_flight_.begin(); it != this->in_flight_.end(); ++it) {
+        if (*it == request) {
+          this->in_flight_.erase(it);
+          break;
+        }
+      }
+      request->state_ = Request::State::FAILED;
+      request->error_ = std::current_exception();
+    }
+  }
+  this->cv_.notify_all();
+  this->notify(batch);
+}
+
+void DashboardPipeline::failStale(std::vector<Request::SharedPtr> & finished)
+{
+  const uint64_t connections = this->tcp_if_->countConnections();
+  if (connections == this->connections_) {
+    return;
+  }
+  this->connections_ = connections;
+  if (!this->in_flight_.empty()) {
+    // Sent on the previous connection: never answered on this one
+    RCLCPP_WARN(
+      this->getLogger(), "Reconnected: %zu requests in flight failed", this->in_flight_.size());
+    this->fail(
+      std::make_exception_ptr(std::runtime_error("Connection lost before the response.")),
+      finished);
+  }
+}
+
+void DashboardPipeline::recordDispatch(const Request::SharedPtr & request)
+{
+  const auto latency = SteadyClock::now() - request->submitted_at_;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    ++this->urgent_stats_.count;
+    this->urgent_stats_.last = latency;
+    this->urgent_stats_.max = std::max(this->urgent_stats_.max, latency);
+  }
+  RCLCPP_INFO(
+    this->getLogger(), "%s dispatched in %.3f ms", request->function.c_str(),
+    std::chrono::duration<double, std::milli>(latency).count());
+}
+
+void DashboardPipeline::run()
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (!this->is_stopping_) {
+    // A waiter may still be receiving inline from before the thread started
+    if (this->in_flight_.empty() || this->is_receiving_) {
+      this->cv_.wait(lock);
+      continue;
+    }
+
+    this->is_receiving_ = true;
+    lock.unlock();
+    std::string response;
+    std::exception_ptr error;
+    try {
+      response = this->tcp_if_->recvResponse();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    this->is_receiving_ = false;
+
+    std::vector<Request::SharedPtr> finished;
+    if (error) {
+      // Nothing in flight will be answered on this connection
+      this->fail(error, finished);
+    } else if (!response.empty()) {
+      this->complete(response, finished);
+    }
+    this->expire(SteadyClock::now(), finished);
+    this->cv_.notify_all();
+
+    // Callbacks may submit again
+    lock.unlock();
+    this->notify(finished);
+    lock.lock();
+  }
+}
+
+void DashboardPipeline::complete(
+  const std::string & response, std::vector<Request::SharedPtr> & finished)
+{
+  DashboardResponse parsed;
+  bool is_valid = false;
+  try {
+    is_valid = ResponseParser::parseResponse(response, parsed);
+  } catch (const std::logic_error &) {
+    // Non numeric or out of range error ID
+  }
+  if (!is_valid) {
+    RCLCPP_WARN(this->getLogger(), "Malformed response: %s", response.c_str());
+    return;
+  }
+  const std::string function = this->takeFunctionName(parsed.func_name);
+
+  auto it = this->in_flight_.begin();
+  while (it != this->in_flight_.end() && (*it)->function != function) {
+    ++it;
+  }
+  if (it == this->in_flight_.end()) {
+    RCLCPP_WARN(this->getLogger(), "Unexpected response: %s", response.c_str());
+    return;
+  }
+
+  // Responses come in order: anything sent earlier will never be answered
+  while (this->in_flight_.front() != *it) {
+    auto & lost = this->in_flight_.front();
+    RCLCPP_WARN(this->getLogger(), "No response to %s", lost->command.c_str());
+    lost->state_ = Request::State::FAILED;
+    lost->error_ = std::make_exception_ptr(
+      std::runtime_error("Response to " + lost->command + " lost."));
+    finished.push_back(lost);
+    this->in_flight_.pop_front();
+  }
+  if (this->in_flight_.front()->is_abandoned_) {
+    RCLCPP_WARN(
+      this->getLogger(), "Late response to %s dropped",
+      this->in_flight_.front()->command.c_str());
+  }
+  this->in_flight_.front()->response_ = response;
+  this->in_flight_.front()->state_ = Request::State::DONE;
+  finished.push_back(this->in_flight_.front());
+  this->in_flight_.pop_front();
+}
+
+void DashboardPipeline::fail(
+  const std::exception_ptr & error, std::vector<Request::SharedPtr> & finished)
+{
+  for (auto & request : this->in_flight_) {
+    request->state_ = Request::State::FAILED;
+    request->error_ = error;
+    finished.push_back(request);
+  }
+  this->in_flight_.clear();
+}
+
+void DashboardPipeline::expire(
+  const SteadyClock::time_point & now, std::vector<Request::SharedPtr> & finished)
+{
+  for (auto & request : this->in_flight_) {
+    if (request->callback_ && !request->is_notified_.load() && now >= request->deadline_) {
+      // Stays queued like a synchronous request that timed out
+      request->is_abandoned_ = true;
+      request->error_ = std::make_exception_ptr(std::runtime_error("Robot not responded."));
+      finished.push_back(request);
+    }
+  }
+}
+
+void DashboardPipeline::notify(const std::vector<Request::SharedPtr> & finished)
+{
+  for (const auto & request : finished) {
+    if (!request->callback_ || request->is_notified_.exchange(true)) {
+      continue;
+    }
+    try {
+      request->callback_(request->response_, request->error_);
+    } catch (const std::exception & ex) {
+      RCLCPP_ERROR(
+        getLogger(), "Callback for %s threw: %s", request->command.c_str(), ex.what());
+    }
+  }
+}
+}  // namespace mg400_interface
@@ -0,0 +1,183 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/latency_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace mg400_interface
+{
+LatencyHistogram::LatencyHistogram()
+: sum_us_(0),
+  max_us_(0),
+  timeouts_(0),
+  errors_(0)
+{
+  for (auto & count : this->counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::record(const std::chrono::nanoseconds latency)
+{
+  const uint64_t us = static_cast<uint64_t>(
+    std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+  this->counts_[this->toIndex(us)].fetch_add(1, std::memory_order_relaxed);
+  this->sum_us_.fetch_add(us, std::memory_order_relaxed);
+  uint64_t max_us = this->max_us_.load(std::memory_order_relaxed);
+  while (us > max_us &&
+    !this->max_us_.compare_exchange_weak(max_us, us, std::memory_order_relaxed))
+  {
+  }
+}
+
+void LatencyHistogram::recordTimeout()
+{
+  this->timeouts_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::recordError()
+{
+  this->errors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize() const
+{
+  Summary summary = {};
+  summary.timeouts = this->timeouts_.load(std::memory_order_relaxed);
+  summary.errors = this->errors_.load(std::memory_order_relaxed);
+  summary.max_us = this->max_us_.load(std::memory_order_relaxed);
+  const uint64_t sum_us = this->sum_us_.load(std::memory_order_relaxed);
+
+  // Counted from the buckets so that percentiles add up
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    const uint64_t count = this->counts_[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      summary.buckets.emplace_back(this->toUpperBound(i), count);
+      summary.count += count;
+    }
+  }
+  if (summary.count == 0) {
+    return summary;
+  }
+  summary.mean_us = static_cast<double>(sum_us) / static_cast<double>(summary.count);
+
+  const auto percentile = [&summary](const double ratio) {
+      // Nearest rank
+      const auto rank =
+        static_cast<uint64_t>(std::ceil(ratio * static_cast<double>(summary.count)));
+      uint64_t seen = 0;
+      for (const auto & bucket : summary.buckets) {
+        seen += bucket.second;
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+          return std::min(bucket.first, summary.max_us);
+        }
+      }
+      return summary.max_us;
+    };
+  summary.p50_us = percentile(0.50);
+  summary.p90_us = percentile(0.90);
+  summary.p99_us = percentile(0.99);
+  return summary;
+}
+
+size_t LatencyHistogram::toIndex(const uint64_t us)
+{
+  if (us < SUB_BUCKETS) {
+    return static_cast<size_t>(us);
+  }
+  const int magnitude = 63 - __builtin_clzll(us);
+  const int shift = magnitude - SUB_BUCKET_BITS;
+  const size_t index = static_cast<size_t>(shift + 1) * SUB_BUCKETS +
+    static_cast<size_t>((us >> shift) - SUB_BUCKETS);
+  return std::min(index, BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::toUpperBound(const size_t index)
+{
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+  const int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+  const uint64_t sub_bucket = index % SUB_BUCKETS + SUB_BUCKETS;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+LatencyStats::LatencyStats()
+: others_(OTHERS)
+{
+  for (auto & slot : this->slots_) {
+    slot.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+LatencyStats::~LatencyStats()
+{
+  for (auto & slot : this->slots_) {
+    delete slot.load(std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram & LatencyStats::get(const std::string & function)
+{
+  // Open addressing: entries are only ever added, never moved or removed
+  const size_t hash = std::hash<std::string>()(function);
+  Entry * created = nullptr;
+  for (size_t i = 0; i < CAPACITY; ++i) {
+    auto & slot = this->slots_[(hash + i) % CAPACITY];
+    Entry * entry = slot.load(std::memory_order_acquire);
+    if (entry == nullptr) {
+      if (created == nullptr) {
+        created = new Entry(function);
+      }
+      if (slot.compare_exchange_strong(
+          entry, created, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        return created->histogram;
+      }
+      // Taken meanwhile: entry now holds the winner
+    }
+    if (entry->function == function) {
+      delete created;
+      return entry->histogram;
+    }
+  }
+  delete created;
+  return this->others_.histogram;
+}
+
+std::vector<std::pair<std::string, LatencyHistogram::Summary>> LatencyStats::summarize() const
+{
+  std::vector<std::pair<std::string, LatencyHistogram::Summary>> ret;
+  const auto add = [&ret](const Entry & entry) {
+      auto summary = entry.histogram.summarize();
+      if (summary.count > 0 || summary.timeouts > 0 || summary.errors > 0) {
+        ret.emplace_back(entry.function, std::move(summary));
+      }
+    };
+  for (const auto & slot : this->slots_) {
+    const Entry * entry = slot.load(std::memory_order_acquire);
+    if (entry != nullptr) {
+      add(*entry);
+    }
+  }
+  add(this->others_);
+  std::sort(
+    ret.begin(), ret.end(),
+    [](const auto & lhs, const auto & rhs) {return lhs.first < rhs.first;});
+  return ret;
+}
+}  // namespace mg400_interface
@@ -0,0 +1,288 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/modbus_poller.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace mg400_interface
+{
+ModbusPoller::ModbusPoller(DashboardCommander * commander, const Limits & limits)
+: commander_(commander),
+  LIMITS(limits),
+  index_(0),
+  is_open_(false),
+  stats_{0, 0, 0, 0},
+  is_polling_(false)
+{
+  if (this->LIMITS.max_gap < 0 || this->LIMITS.max_bits < 1 || this->LIMITS.max_registers < 1) {
+    throw std::runtime_error("Invalid Modbus read limits.");
+  }
+}
+
+ModbusPoller::~ModbusPoller()
+{
+  // The pending callback still refers to this poller; it fires at the latest on timeout
+  while (this->is_polling_.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  try {
+    this->close();
+  } catch (const std::exception & ex) {
+    RCLCPP_WARN(this->getLogger(), "Failed to close Modbus: %s", ex.what());
+  }
+}
+
+const rclcpp::Logger ModbusPoller::getLogger()
+{
+  return rclcpp::get_logger("ModbusPoller");
+}
+
+void ModbusPoller::addRange(const Table table, const int addr, const int count)
+{
+  if (addr < 0 || count < 1) {
+    throw std::runtime_error("Invalid Modbus range.");
+  }
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->ranges_.push_back({table, addr, count});
+  // Planned again by the next poll
+  this->plan_.reset();
+}
+
+void ModbusPoller::open(
+  const std::string & ip, const int port, const int slave_id, const bool is_rtu)
+{
+  this->close();
+  const int index = this->commander_->modbusCreate(ip, port, slave_id, is_rtu);
+
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->index_ = index;
+  this->is_open_ = true;
+  this->plan_.reset();
+  // Everything is reported again on a new connection
+  for (auto & values : this->last_values_) {
+    values.clear();
+  }
+}
+
+void ModbusPoller::close()
+{
+  int index = 0;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->is_open_) {
+      return;
+    }
+    index = this->index_;
+    this->is_open_ = false;
+    this->plan_.reset();
+  }
+  this->commander_->modbusClose(index);
+}
+
+bool ModbusPoller::isOpen()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->is_open_;
+}
+
+std::vector<ModbusPoller::Change> ModbusPoller::poll()
+{
+  const auto plan = this->takePlan();
+  return this->update(*plan, this->commander_->sendBatch(plan->commands));
+}
+
+bool ModbusPoller::poll(const ChangeCallback & callback)
+{
+  if (this->is_polling_.exchange(true)) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    ++this->stats_.skipped;
+    return false;
+  }
+
+  std::shared_ptr<const Plan> plan;
+  try {
+    plan = this->takePlan();
+  } catch (...) {
+    this->is_polling_.store(false);
+    throw;
+  }
+  this->commander_->sendBatch(
+    plan->commands,
+    [this, plan, callback](std::vector<DashboardCommander::BatchResult> results) {
+      try {
+        callback(this->update(*plan, results));
+      } catch (const std::exception & ex) {
+        RCLCPP_ERROR(this->getLogger(), "Modbus poll failed: %s", ex.what());
+      }
+      this->is_polling_.store(false);
+    });
+  return true;
+}
+
+ModbusPoller::Stats ModbusPoller::getStats()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->stats_;
+}
+
+std::vector<ModbusPoller::Range> ModbusPoller::plan(
+  std::vector<Range> ranges, const Limits & limits)
+{
+  std::sort(
+    ranges.begin(), ranges.end(),
+    [](const Range & lhs, const Range & rhs) {
+      if (lhs.table != rhs.table) {
+        return lhs.table < rhs.table;
+      }
+      return lhs.addr < rhs.addr;
+    });
+
+  // Overlapping, adjacent or close enough ranges become one span
+  std::vector<Range> spans;
+  for (const auto & range : ranges) {
+    if (!spans.empty() && spans.back().table == range.table &&
+      range.addr <= spans.back().addr + spans.back().count + limits.max_gap)
+    {
+      auto & span = spans.back();
+      span.count = std::max(span.addr + span.count, range.addr + range.count) - span.addr;
+    } else {
+      spans.push_back(range);
+    }
+  }
+
+  // Each span is then read in as few calls as the limits allow
+  std::vector<Range> reads;
+  for (const auto & span : spans) {
+    const bool is_bit = span.table == Table::COIL || span.table == Table::DISCRETE_INPUT;
+    const int max_count = is_bit ? limits.max_bits : limits.max_registers;
+    for (int addr = span.addr; addr < span.addr + span.count; addr += max_count) {
+      reads.push_back({span.table, addr, std::min(max_count, span.addr + span.count - addr)});
+    }
+  }
+  return reads;
+}
+
+std::string ModbusPoller::toCommand(const int index, const Range & read)
+{
+  char buf[128];
+  int cx = 0;
+  switch (read.table) {
+    case Table::COIL:
+      cx = snprintf(buf, sizeof(buf), "GetCoils(%d,%d,%d)", index, read.addr, read.count);
+      break;
+    case Table::DISCRETE_INPUT:
+      cx = snprintf(buf, sizeof(buf), "GetInBits(%d,%d,%d)", index, read.addr, read.count);
+      break;
+    case Table::INPUT_REGISTER:
+      cx = snprintf(buf, sizeof(buf), "GetInRegs(%d,%d,%d,U16)", index, read.addr, read.count);
+      break;
+    case Table::HOLDING_REGISTER:
+      cx = snprintf(buf, sizeof(buf), "GetHoldRegs(%d,%d,%d,U16)", index, read.addr, read.count);
+      break;
+  }
+  return std::string(buf, cx);
+}
+
+std::shared_ptr<const ModbusPoller::Plan> ModbusPoller::takePlan()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (!this->is_open_) {
+    throw std::runtime_error("Modbus not opened.");
+  }
+  if (this->plan_) {
+    return this->plan_;
+  }
+
+  auto plan = std::make_shared<Plan>();
+  plan->reads = this->plan(this->ranges_, this->LIMITS);
+  for (const auto & read : plan->reads) {
+    // Built once: polls only resend them
+    plan->commands.push_back(this->toCommand(this->index_, read));
+  }
+  for (const auto & range : this->ranges_) {
+    auto & registered = plan->registered[static_cast<size_t>(range.table)];
+    for (int addr = range.addr; addr < range.addr + range.count; ++addr) {
+      registered.insert(addr);
+    }
+  }
+  this->plan_ = plan;
+  return this->plan_;
+}
+
+std::vector<ModbusPoller::Change> ModbusPoller::update(
+  const Plan & plan, const std::vector<DashboardCommander::BatchResult> & results)
+{
+  std::array<Change, 4> changes = {
+    Change{Table::COIL, {}, {}},
+    Change{Table::DISCRETE_INPUT, {}, {}},
+    Change{Table::INPUT_REGISTER, {}, {}},
+    Change{Table::HOLDING_REGISTER, {}, {}}};
+
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  ++this->stats_.polls;
+  for (size_t i = 0; i < plan.reads.size() && i < results.size(); ++i) {
+    const auto & read = plan.reads[i];
+    ++this->stats_.reads;
+
+    std::vector<int> values;
+    if (results[i].ok) {
+      try {
+        DashboardResponse response;
+        ResponseParser::parseResponse(results[i].response, response);
+        values = ResponseParser::takeIntArray(response.ret_val);
+      } catch (const std::logic_error &) {
+        // Non numeric value
+        values.clear();
+      }
+    }
+    if (values.size() != static_cast<size_t>(read.count)) {
+      ++this->stats_.failures;
+      RCLCPP_DEBUG(
+        this->getLogger(), "%s failed: %s", plan.commands[i].c_str(),
+        results[i].ok ? results[i].response.c_str() : results[i].error.c_str());
+      continue;
+    }
+
+    const auto table = static_cast<size_t>(read.table);
+    const auto & registered = plan.registered[table];
+    auto & last_values = this->last_values_[table];
+    for (int j = 0; j < read.count; ++j) {
+      const int addr = read.addr + j;
+      if (registered.count(addr) == 0) {
+        // Only read to join two ranges
+        continue;
+      }
+      const auto last = last_values.find(addr);
+      if (last != last_values.end() && last->second == values[j]) {
+        continue;
+      }
+      last_values[addr] = values[j];
+      changes[table].addresses.push_back(addr);
+      changes[table].values.push_back(values[j]);
+    }
+  }
+
+  std::vector<Change> ret;
+  for (auto & change : changes) {
+    if (!change.addresses.empty()) {
+      ret.push_back(std::move(change));
+    }
+  }
+  return ret;
+}
+}  // namespace mg400_interface
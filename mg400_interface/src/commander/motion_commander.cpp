@@ -14,8 +14,54 @@
 
 #include "mg400_interface/commander/motion_commander.hpp"
 
+#include <array>
+
+#include "mg400_interface/commander/command_encoder.hpp"
+
 namespace mg400_interface
 {
+namespace
+{
+constexpr char MOV_J[] = "MovJ";
+constexpr char MOV_L[] = "MovL";
+constexpr char JOINT_MOV_J[] = "JointMovJ";
+constexpr char MOV_L_IO[] = "MovLIO";
+constexpr char MOV_J_IO[] = "MovJIO";
+constexpr char MOVE_JOG[] = "MoveJog";
+constexpr char SYNC[] = "Sync";
+constexpr char CP[] = "CP";
+constexpr char REL_MOV_J_USER[] = "RelMovJUser";
+constexpr char REL_MOV_L_USER[] = "RelMovLUser";
+constexpr char REL_JOINT_MOV_J[] = "RelJointMovJ";
+constexpr char SERVO_J[] = "ServoJ";
+constexpr char SERVO_P[] = "ServoP";
+
+// {mode, distance, index, status} of the IO commands
+using IOParams = std::array<int64_t, 4>;
+
+using MovJCommand = CommandEncoder<MOV_J, double, double, double, double, double, double>;
+using MovJ4AxisCommand = CommandEncoder<MOV_J, double, double, double, double>;
+using MovLCommand = CommandEncoder<MOV_L, double, double, double, double, double, double>;
+using MovJCPCommand = CommandEncoder<MOV_J, double, double, double, double, NamedParam<CP, int>>;
+using MovLCPCommand = CommandEncoder<MOV_L, double, double, double, double, NamedParam<CP, int>>;
+using JointMovJCommand =
+  CommandEncoder<JOINT_MOV_J, double, double, double, double, double, double>;
+using MovLIOCommand =
+  CommandEncoder<MOV_L_IO, double, double, double, double, double, double, IOParams>;
+using MovJIOCommand =
+  CommandEncoder<MOV_J_IO, double, double, double, double, double, double, IOParams>;
+using MoveJogCommand = CommandEncoder<MOVE_JOG, std::string_view>;
+using SyncCommand = CommandEncoder<SYNC>;
+using RelMovJUserCommand =
+  CommandEncoder<REL_MOV_J_USER, double, double, double, double, double, double, int>;
+using RelMovLUserCommand =
+  CommandEncoder<REL_MOV_L_USER, double, double, double, double, double, double, int>;
+using RelJointMovJCommand =
+  CommandEncoder<REL_JOINT_MOV_J, double, double, double, double, double, double>;
+using ServoJCommand = CommandEncoder<SERVO_J, double, double, double, double>;
+using ServoPCommand = CommandEncoder<SERVO_P, double, double, double, double>;
+}  // namespace
+
 MotionCommander::MotionCommander(MotionTcpInterfaceBase * tcp_if)
 : tcp_if_(tcp_if)
 {
@@ -26,26 +72,20 @@ void MotionCommander::movJ(
   const si_m x, const si_m y, const si_m z,
   const si_rad rx, const si_rad ry, const si_rad rz)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "MovJ(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf)",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(rx), rad2degree(ry), rad2degree(rz));
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovJCommand::encode(
+      buf, m2mm(x), m2mm(y), m2mm(z),
+      rad2degree(rx), rad2degree(ry), rad2degree(rz)));
 }
 
 void MotionCommander::mov_4axis(
   const si_m x, const si_m y, const si_m z,
   const si_rad r)
 {
-  char buf[100];
-  snprintf( 
-    buf, sizeof(buf),
-    "MovJ(%.3lf,%.3lf,%.3lf,%.3lf)",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(r));
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovJ4AxisCommand::encode(buf, m2mm(x), m2mm(y), m2mm(z), rad2degree(r)));
 }
 
 
@@ -53,26 +93,40 @@ void MotionCommander::movL(
   const si_m x, const si_m y, const si_m z,
   const si_rad rx, const si_rad ry, const si_rad rz)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "MovL(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf)",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(rx), rad2degree(ry), rad2degree(rz));
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovLCommand::encode(
+      buf, m2mm(x), m2mm(y), m2mm(z),
+      rad2degree(rx), rad2degree(ry), rad2degree(rz)));
 }
 
 void MotionCommander::jointMovJ(
   const si_rad j1, const si_rad j2, const si_rad j3,
   const si_rad j4, const si_rad j5, const si_rad j6)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "JointMovJ(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf)",
-    rad2degree(j1), rad2degree(j2), rad2degree(j3),
-    rad2degree(j4), rad2degree(j5), rad2degree(j6));
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    JointMovJCommand::encode(
+      buf, rad2degree(j1), rad2degree(j2), rad2degree(j3),
+      rad2degree(j4), rad2degree(j5), rad2degree(j6)));
+}
+
+void MotionCommander::movJCP(
+  const si_m x, const si_m y, const si_m z,
+  const si_rad r, const int cp)
+{
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovJCPCommand::encode(buf, m2mm(x), m2mm(y), m2mm(z), rad2degree(r), {cp}));
+}
+
+void MotionCommander::movLCP(
+  const si_m x, const si_m y, const si_m z,
+  const si_rad r, const int cp)
+{
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovLCPCommand::encode(buf, m2mm(x), m2mm(y), m2mm(z), rad2degree(r), {cp}));
 }
 
 void MotionCommander::movLIO(
@@ -95,14 +149,12 @@ void MotionCommander::movLIO(
   const DOIndex::_index_type & index,
   const DOStatus::_status_type & status)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "MovLIO(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,{%u,%d,%u,%u})",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(rx), rad2degree(ry), rad2degree(rz),
-    mode, distance, index, status);
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovLIOCommand::encode(
+      buf, m2mm(x), m2mm(y), m2mm(z),
+      rad2degree(rx), rad2degree(ry), rad2degree(rz),
+      IOParams{mode, distance, index, status}));
 }
 
 void MotionCommander::movJIO(
@@ -123,14 +175,12 @@ void MotionCommander::movJIO(
   const DOIndex::_index_type & index,
   const DOStatus::_status_type & status)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "MovJIO(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,{%u,%d,%u,%u})",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(rx), rad2degree(ry), rad2degree(rz),
-    mode, distance, index, status);
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    MovJIOCommand::encode(
+      buf, m2mm(x), m2mm(y), m2mm(z),
+      rad2degree(rx), rad2degree(ry), rad2degree(rz),
+      IOParams{mode, distance, index, status}));
 }
 
 /* https://github.com/Dobot-Arm/TCP-IP-CR-Python/issues/4#:~:text=The%20arc%20function%20needs%20to%20be%20fixed%20by%20Dobot
@@ -159,17 +209,15 @@ void MotionCommander::moveJog(const MoveJog::SharedPtr & jog_mode)
 
 void MotionCommander::moveJog(const MoveJog::_jog_mode_type & jog_mode)
 {
-  char buf[100];
-  snprintf(buf, sizeof(buf), "MoveJog(%s)", jog_mode.c_str());
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(MoveJogCommand::encode(buf, jog_mode));
 }
 
 
 void MotionCommander::sync()
 {
-  char buf[100];
-  snprintf(buf, sizeof(buf), "Sync()");
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(SyncCommand::encode(buf));
 }
 
 void MotionCommander::relMovJUser(
@@ -187,13 +235,11 @@ void MotionCommander::relMovJUser(
   const si_rad rx, const si_rad ry, const si_rad rz,
   const User::_user_type & user)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "RelMovJUser(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%u)",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(rx), rad2degree(ry), rad2degree(rz), user);
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    RelMovJUserCommand::encode(
+      buf, m2mm(x), m2mm(y), m2mm(z),
+      rad2degree(rx), rad2degree(ry), rad2degree(rz), user));
 }
 
 void MotionCommander::relMovLUser(
@@ -211,26 +257,39 @@ void MotionCommander::relMovLUser(
   const si_rad rx, const si_rad ry, const si_rad rz,
   const User::_user_type & user)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "RelMovLUser(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%u)",
-    m2mm(x), m2mm(y), m2mm(z),
-    rad2degree(rx), rad2degree(ry), rad2degree(rz), user);
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    RelMovLUserCommand::encode(
+      buf, m2mm(x), m2mm(y), m2mm(z),
+      rad2degree(rx), rad2degree(ry), rad2degree(rz), user));
 }
 
 void MotionCommander::relJointMovJ(
   const si_rad j1, const si_rad j2, const si_rad j3,
   const si_rad j4, const si_rad j5, const si_rad j6)
 {
-  char buf[100];
-  snprintf(
-    buf, sizeof(buf),
-    "RelJointMovJ(%.3lf,%.3lf,%.3lf,%.3lf,%.3lf,%.3lf)",
-    rad2degree(j1), rad2degree(j2), rad2degree(j3),
-    rad2degree(j4), rad2degree(j5), rad2degree(j6));
-  this->tcp_if_->sendCommand(buf);
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    RelJointMovJCommand::encode(
+      buf, rad2degree(j1), rad2degree(j2), rad2degree(j3),
+      rad2degree(j4), rad2degree(j5), rad2degree(j6)));
+}
+
+void MotionCommander::servoJ(
+  const si_rad j1, const si_rad j2, const si_rad j3, const si_rad j4)
+{
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    ServoJCommand::encode(
+      buf, rad2degree(j1), rad2degree(j2), rad2degree(j3), rad2degree(j4)));
+}
+
+void MotionCommander::servoP(
+  const si_m x, const si_m y, const si_m z, const si_rad r)
+{
+  CommandBuffer buf;
+  this->tcp_if_->sendCommandView(
+    ServoPCommand::encode(buf, m2mm(x), m2mm(y), m2mm(z), rad2degree(r)));
 }
 
 // End DOBOT MG400 Official Command -----------------------------------------
@@ -0,0 +1,209 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/motion_preemptor.hpp"
+
+namespace mg400_interface
+{
+namespace
+{
+// Clock of the feedback stamps
+int64_t systemNow()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}  // namespace
+
+MotionPreemptor::MotionPreemptor(
+  const StopFunction & stop_function,
+  const FeedbackSource & feedback_source,
+  const Config & config)
+: stop_function_(stop_function),
+  feedback_source_(feedback_source),
+  CONFIG(config),
+  owner_(0),
+  last_owner_(0),
+  stop_{0, false, false, 0, 0}
+{
+}
+
+MotionPreemptor::Owner MotionPreemptor::acquire()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  const bool is_preempting = this->owner_ != 0;
+  this->owner_ = ++this->last_owner_;
+  if (is_preempting) {
+    RCLCPP_INFO(this->getLogger(), "Preempting the current goal");
+    this->sendStop();
+  }
+  return this->owner_;
+}
+
+void MotionPreemptor::release(const Owner owner)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->isOwnerLocked(owner)) {
+    this->owner_ = 0;
+  }
+}
+
+bool MotionPreemptor::isOwner(const Owner owner)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->isOwnerLocked(owner);
+}
+
+bool MotionPreemptor::sendIfOwner(const Owner owner, const std::function<void()> & send)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (!this->isOwnerLocked(owner)) {
+    return false;
+  }
+  send();
+  return true;
+}
+
+bool MotionPreemptor::isOwned()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->owner_ != 0;
+}
+
+bool MotionPreemptor::sendIfUnowned(const std::function<void()> & send)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->owner_ != 0) {
+    return false;
+  }
+  send();
+  return true;
+}
+
+bool MotionPreemptor::requestStop(const Owner owner)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (!this->isOwnerLocked(owner)) {
+    return false;
+  }
+  this->sendStop();
+  return true;
+}
+
+bool MotionPreemptor::waitForStop(const Owner owner)
+{
+  const auto deadline = std::chrono::steady_clock::now() + this->CONFIG.stop_timeout;
+  while (this->isOwner(owner)) {
+    StopRequest stop;
+    {
+      std::lock_guard<std::mutex> lock(this->stop_mutex_);
+      stop = this->stop_;
+    }
+    if (!stop.is_pending) {
+      return true;
+    }
+    if (stop.is_failed) {
+      // Reported once: the next goal may try again
+      std::lock_guard<std::mutex> lock(this->stop_mutex_);
+      if (this->stop_.seq == stop.seq) {
+        this->stop_.is_pending = false;
+      }
+      return false;
+    }
+
+    // The queue is dropped once the stop is accepted: a packet received
+    // after that and not RUNNING shows the arm standing still
+    const auto snapshot = this->feedback_source_();
+    if (stop.accept_ns != 0 && snapshot.stamp_ns > stop.accept_ns &&
+      snapshot.robot_mode != RobotMode::RUNNING)
+    {
+      const auto latency = std::chrono::nanoseconds(snapshot.stamp_ns - stop.request_ns);
+      {
+        std::lock_guard<std::mutex> lock(this->stop_mutex_);
+        // A newer request is left pending
+        if (this->stop_.seq == stop.seq) {
+          this->stop_.is_pending = false;
+        }
+      }
+      this->stop_latency_.record(latency);
+      RCLCPP_INFO(
+        this->getLogger(), "Motion stopped %.1lf ms after the request",
+        std::chrono::duration<double, std::milli>(latency).count());
+      continue;
+    }
+
+    if (std::chrono::steady_clock::now() > deadline) {
+      this->stop_latency_.recordTimeout();
+      RCLCPP_ERROR(
+        this->getLogger(), "Motion did not stop within %.1lf ms",
+        std::chrono::duration<double, std::milli>(this->CONFIG.stop_timeout).count());
+      return false;
+    }
+    std::this_thread::sleep_for(this->CONFIG.poll_period);
+  }
+  return false;
+}
+
+LatencyHistogram::Summary MotionPreemptor::getStopLatency() const
+{
+  return this->stop_latency_.summarize();
+}
+
+const rclcpp::Logger MotionPreemptor::getLogger()
+{
+  return rclcpp::get_logger("MotionPreemptor");
+}
+
+bool MotionPreemptor::isOwnerLocked(const Owner owner) const
+{
+  return owner != 0 && this->owner_ == owner;
+}
+
+void MotionPreemptor::sendStop()
+{
+  uint64_t seq = 0;
+  {
+    std::lock_guard<std::mutex> lock(this->stop_mutex_);
+    seq = ++this->stop_.seq;
+    this->stop_.is_pending = true;
+    this->stop_.is_failed = false;
+    this->stop_.request_ns = systemNow();
+    this->stop_.accept_ns = 0;
+  }
+  try {
+    this->stop_function_(
+      [this, seq](const bool is_accepted) {
+        this->onStopDone(seq, is_accepted);
+      });
+  } catch (const std::exception & ex) {
+    RCLCPP_ERROR(this->getLogger(), "Failed to stop: %s", ex.what());
+    this->onStopDone(seq, false);
+  }
+}
+
+void MotionPreemptor::onStopDone(const uint64_t seq, const bool is_accepted)
+{
+  std::lock_guard<std::mutex> lock(this->stop_mutex_);
+  if (this->stop_.seq != seq) {
+    // Superseded by a newer request
+    return;
+  }
+  if (is_accepted) {
+    this->stop_.accept_ns = systemNow();
+  } else {
+    this->stop_.is_failed = true;
+    this->stop_latency_.recordError();
+  }
+}
+}  // namespace mg400_interface
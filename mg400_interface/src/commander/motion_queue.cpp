@@ -0,0 +1,357 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/motion_queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mg400_interface
+{
+MotionQueue::MotionQueue(MotionTcpInterfaceBase * tcp_if, const Config & config)
+: commander_(tcp_if),
+  config_(config),
+  next_id_(1),
+  last_stamp_ns_(0),
+  idle_since_ns_(0)
+{
+  this->config_.depth = std::max<size_t>(this->config_.depth, 1);
+}
+
+void MotionQueue::setDepth(const size_t depth)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->config_.depth = std::max<size_t>(depth, 1);
+  this->cv_.notify_all();
+}
+
+uint64_t MotionQueue::tryPush(const Move & move)
+{
+  std::lock_guard<std::mutex> send_lock(this->send_mutex_);
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (this->in_flight_.size() >= this->config_.depth) {
+    return 0;
+  }
+  return this->send(lock, move);
+}
+
+uint64_t MotionQueue::push(const Move & move, const std::chrono::nanoseconds timeout)
+{
+  std::lock_guard<std::mutex> send_lock(this->send_mutex_);
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  const bool has_room = this->cv_.wait_for(
+    lock, timeout, [this]() {return this->in_flight_.size() < this->config_.depth;});
+  if (!has_room) {
+    throw std::runtime_error("Motion queue is full");
+  }
+  return this->send(lock, move);
+}
+
+void MotionQueue::update(const RealTimeData * data, const int64_t stamp_ns)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (data == nullptr) {
+    if (!this->in_flight_.empty()) {
+      RCLCPP_WARN(
+        this->getLogger(), "Feedback lost: %zu moves failed", this->in_flight_.size());
+    }
+    while (!this->in_flight_.empty()) {
+      this->finish(State::FAILED, this->last_stamp_ns_);
+    }
+    return;
+  }
+  if (stamp_ns <= this->last_stamp_ns_) {
+    // A packet already seen
+    return;
+  }
+  if (this->last_stamp_ns_ == 0) {
+    this->idle_since_ns_ = stamp_ns;
+  }
+  this->last_stamp_ns_ = stamp_ns;
+
+  const uint64_t mode = data->robot_mode;
+  if (mode != RobotMode::ENABLE && mode != RobotMode::RUNNING &&
+    mode != RobotMode::PAUSE && mode != RobotMode::JOG)
+  {
+    // The controller drops its queue on errors and when disabled
+    if (!this->in_flight_.empty()) {
+      RCLCPP_WARN(
+        this->getLogger(), "Robot mode %lu: %zu moves failed", mode, this->in_flight_.size());
+    }
+    while (!this->in_flight_.empty()) {
+      this->finish(State::FAILED, stamp_ns);
+    }
+    return;
+  }
+
+  bool is_moving = false;
+  for (size_t i = 0; i < 4; ++i) {
+    is_moving |= std::abs(data->qd_target[i]) > this->config_.velocity_tolerance_deg;
+  }
+  if (is_moving || mode != RobotMode::ENABLE) {
+    this->idle_since_ns_ = stamp_ns;
+  }
+
+  while (!this->in_flight_.empty()) {
+    auto & front = this->in_flight_.front();
+    if (front.record.state == State::SENT && (is_moving || mode == RobotMode::RUNNING)) {
+      front.record.state = State::RUNNING;
+      front.record.start_ns = stamp_ns;
+    }
+    // The planner passes through a goal without stopping while more moves
+    // wait behind it
+    const bool has_next = this->in_flight_.size() > 1;
+    const bool is_done =
+      (this->isReached(front, *data) && (!is_moving || has_next)) ||
+      (has_next && this->isInBlendZone(front, *data));
+    if (!is_done) {
+      break;
+    }
+    if (front.record.start_ns == 0) {
+      // Already there: started and done at once
+      front.record.start_ns = stamp_ns;
+    }
+    this->finish(State::DONE, stamp_ns);
+  }
+
+  // Standing at a later goal: the ones before it were blended through
+  // without ever being reached exactly. Only once the planner started on
+  // them: a closed path ends where it starts.
+  if (!is_moving && !this->in_flight_.empty() &&
+    this->in_flight_.front().record.state == State::RUNNING)
+  {
+    for (size_t i = this->in_flight_.size(); i-- > 1; ) {
+      if (this->isReached(this->in_flight_[i], *data)) {
+        for (size_t j = 0; j <= i; ++j) {
+          if (this->in_flight_.front().record.start_ns == 0) {
+            this->in_flight_.front().record.start_ns = stamp_ns;
+          }
+          this->finish(State::DONE, stamp_ns);
+        }
+        break;
+      }
+    }
+  }
+
+  if (this->in_flight_.empty()) {
+    return;
+  }
+  const int64_t idle_since_ns =
+    std::max(this->idle_since_ns_, this->in_flight_.front().record.sent_ns);
+  if (std::chrono::nanoseconds(stamp_ns - idle_since_ns) > this->config_.stall_timeout) {
+    RCLCPP_WARN(
+      this->getLogger(), "Move %lu never reached its goal", this->in_flight_.front().record.id);
+    this->finish(State::FAILED, stamp_ns);
+    this->idle_since_ns_ = stamp_ns;
+  }
+}
+
+void MotionQueue::clear()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  while (!this->in_flight_.empty()) {
+    this->finish(State::FAILED, this->last_stamp_ns_);
+  }
+}
+
+bool MotionQueue::getRecord(const uint64_t id, Record & record)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->findRecord(id, record);
+}
+
+bool MotionQueue::wait(
+  const uint64_t id, const std::chrono::nanoseconds timeout, Record & record)
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  bool is_known = true;
+  const bool is_over = this->cv_.wait_for(
+    lock, timeout, [this, id, &record, &is_known]() {
+      is_known = this->findRecord(id, record);
+      return !is_known || record.state == State::DONE || record.state == State::FAILED;
+    });
+  return is_over && is_known;
+}
+
+size_t MotionQueue::countInFlight()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->in_flight_.size();
+}
+
+MotionQueue::Move MotionQueue::movJ(
+  const si_m x, const si_m y, const si_m z, const si_rad r)
+{
+  return {Type::MOV_J, {x, y, z, r}};
+}
+
+MotionQueue::Move MotionQueue::movL(
+  const si_m x, const si_m y, const si_m z, const si_rad r)
+{
+  return {Type::MOV_L, {x, y, z, r}};
+}
+
+MotionQueue::Move MotionQueue::jointMovJ(
+  const si_rad j1, const si_rad j2, const si_rad j3, const si_rad j4)
+{
+  return {Type::JOINT_MOV_J, {j1, j2, j3, j4}};
+}
+
+const char * MotionQueue::toString(const State state)
+{
+  switch (state) {
+    case State::SENT:
+      return "SENT";
+    case State::RUNNING:
+      return "RUNNING";
+    case State::DONE:
+      return "DONE";
+    case State::FAILED:
+      return "FAILED";
+  }
+  return "UNKNOWN";
+}
+
+const rclcpp::Logger MotionQueue::getLogger()
+{
+  return rclcpp::get_logger("MotionQueue");
+}
+
+uint64_t MotionQueue::send(std::unique_lock<std::mutex> & lock, const Move & move)
+{
+  Entry entry;
+  entry.record = {this->next_id_++, State::SENT, this->last_stamp_ns_, 0, 0};
+  entry.type = move.type;
+  entry.blend_zone_mm = m2mm(move.blend_zone);
+  if (move.type == Type::JOINT_MOV_J) {
+    for (size_t i = 0; i < 4; ++i) {
+      entry.goal[i] = rad2degree(move.goal[i]);
+    }
+  } else {
+    entry.goal = {
+      m2mm(move.goal[0]), m2mm(move.goal[1]), m2mm(move.goal[2]), rad2degree(move.goal[3])};
+  }
+  const uint64_t id = entry.record.id;
+  this->in_flight_.push_back(entry);
+
+  // Followed from now on: the feedback may see it start before send() returns
+  lock.unlock();
+  try {
+    const auto & goal = move.goal;
+    switch (move.type) {
+      case Type::MOV_J:
+        if (move.cp < 0) {
+          this->commander_.movJ(goal[0], goal[1], goal[2], goal[3]);
+        } else {
+          this->commander_.movJCP(goal[0], goal[1], goal[2], goal[3], move.cp);
+        }
+        break;
+      case Type::MOV_L:
+        if (move.cp < 0) {
+          this->commander_.movL(goal[0], goal[1], goal[2], goal[3]);
+        } else {
+          this->commander_.movLCP(goal[0], goal[1], goal[2], goal[3], move.cp);
+        }
+        break;
+      case Type::JOINT_MOV_J:
+        this->commander_.jointMovJ(goal[0], goal[1], goal[2], goal[3], 0.0, 0.0);
+        break;
+    }
+  } catch (...) {
+    lock.lock();
+    const auto it = std::find_if(
+      this->in_flight_.begin(), this->in_flight_.end(),
+      [id](const Entry & e) {return e.record.id == id;});
+    if (it != this->in_flight_.end()) {
+      auto record = it->record;
+      this->in_flight_.erase(it);
+      record.state = State::FAILED;
+      record.end_ns = this->last_stamp_ns_;
+      this->archive(record);
+    }
+    throw;
+  }
+  return id;
+}
+
+void MotionQueue::finish(const State state, const int64_t stamp_ns)
+{
+  auto record = this->in_flight_.front().record;
+  this->in_flight_.pop_front();
+  record.state = state;
+  record.end_ns = stamp_ns;
+  this->archive(record);
+}
+
+void MotionQueue::archive(const Record & record)
+{
+  this->history_.push_back(record);
+  while (this->history_.size() > HISTORY) {
+    this->history_.pop_front();
+  }
+  this->cv_.notify_all();
+}
+
+bool MotionQueue::isReached(const Entry & entry, const RealTimeData & data) const
+{
+  const auto is_angle_reached = [this](const double actual, const double goal) {
+      // MG400 reports angles within +-180 degree
+      return std::abs(std::remainder(actual - goal, 360.0)) <= this->config_.angle_tolerance_deg;
+    };
+  if (entry.type == Type::JOINT_MOV_J) {
+    for (size_t i = 0; i < 4; ++i) {
+      if (!is_angle_reached(data.q_target[i], entry.goal[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    if (std::abs(data.tool_vector_target[i] - entry.goal[i]) >
+      this->config_.position_tolerance_mm)
+    {
+      return false;
+    }
+  }
+  return is_angle_reached(data.tool_vector_target[3], entry.goal[3]);
+}
+
+bool MotionQueue::isInBlendZone(const Entry & entry, const RealTimeData & data) const
+{
+  if (entry.type == Type::JOINT_MOV_J || entry.blend_zone_mm <= 0.0) {
+    return false;
+  }
+  const double dx = data.tool_vector_target[0] - entry.goal[0];
+  const double dy = data.tool_vector_target[1] - entry.goal[1];
+  const double dz = data.tool_vector_target[2] - entry.goal[2];
+  return std::sqrt(dx * dx + dy * dy + dz * dz) <= entry.blend_zone_mm;
+}
+
+bool MotionQueue::findRecord(const uint64_t id, Record & record) const
+{
+  for (const auto & entry : this->in_flight_) {
+    if (entry.record.id == id) {
+      record = entry.record;
+      return true;
+    }
+  }
+  for (const auto & done : this->history_) {
+    if (done.id == id) {
+      record = done;
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace mg400_interface
@@ -166,4 +166,27 @@ int ResponseParser::takeInt(const std::string & response)
   }
   return std::stoi(buf);
 }
+
+std::vector<int> ResponseParser::takeIntArray(const std::string & response)
+{
+  std::vector<int> ret;
+  std::string buf;
+  for (auto s : response) {
+    if (s == '{') {
+      continue;
+    }
+    if (s == ',' || s == '}') {
+      if (!buf.empty()) {
+        ret.push_back(std::stoi(buf));
+      }
+      buf.clear();
+      if (s == '}') {
+        break;
+      }
+      continue;
+    }
+    buf.push_back(s);
+  }
+  return ret;
+}
 }  // namespace mg400_interface
@@ -0,0 +1,304 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/servo_streamer.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace mg400_interface
+{
+namespace
+{
+constexpr int64_t NS_PER_S = 1000000000;
+
+int64_t toNs(const timespec & ts)
+{
+  return static_cast<int64_t>(ts.tv_sec) * NS_PER_S + ts.tv_nsec;
+}
+
+timespec toTimespec(const int64_t ns)
+{
+  timespec ts;
+  ts.tv_sec = static_cast<time_t>(ns / NS_PER_S);
+  ts.tv_nsec = static_cast<long>(ns % NS_PER_S);  // NOLINT
+  return ts;
+}
+
+// CLOCK_MONOTONIC, the clock std::chrono::steady_clock reads on Linux
+int64_t monotonicNow()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return toNs(ts);
+}
+}  // namespace
+
+ServoStreamer::ServoStreamer(
+  const MotionCommander::SharedPtr & commander,
+  const FeedbackSource & feedback_source,
+  const Config & config)
+: commander_(commander),
+  feedback_source_(feedback_source),
+  config_(config),
+  setpoint_(Setpoint{false, Mode::JOINT, {}, 0}),
+  is_running_(false),
+  is_streaming_(false),
+  is_paused_(false),
+  mode_(Mode::JOINT),
+  command_{},
+  ticks_(0),
+  sent_(0),
+  overruns_(0),
+  watchdog_stops_(0),
+  limited_(0)
+{
+  if (this->config_.period <= std::chrono::nanoseconds::zero()) {
+    throw std::runtime_error("Servo period must be positive");
+  }
+}
+
+ServoStreamer::~ServoStreamer()
+{
+  this->stop();
+}
+
+void ServoStreamer::setSendGuard(const SendGuard & send_guard)
+{
+  this->send_guard_ = send_guard;
+}
+
+void ServoStreamer::start()
+{
+  if (this->is_running_.load()) {
+    return;
+  }
+  // The thread may have ended by itself
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+
+  this->is_streaming_ = false;
+  this->is_paused_ = false;
+  this->is_running_.store(true);
+  this->thread_ = std::thread(&ServoStreamer::run, this);
+
+  if (this->config_.priority > 0) {
+    sched_param param{};
+    param.sched_priority = this->config_.priority;
+    const int err = pthread_setschedparam(this->thread_.native_handle(), SCHED_FIFO, &param);
+    if (err != 0) {
+      RCLCPP_WARN(
+        this->getLogger(), "Failed to set SCHED_FIFO priority %d: %s",
+        this->config_.priority, strerror(err));
+    }
+  }
+}
+
+void ServoStreamer::stop()
+{
+  this->is_running_.store(false);
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+}
+
+bool ServoStreamer::isRunning() const
+{
+  return this->is_running_.load();
+}
+
+void ServoStreamer::setJointSetpoint(
+  const si_rad j1, const si_rad j2, const si_rad j3, const si_rad j4)
+{
+  this->setSetpoint(Mode::JOINT, {j1, j2, j3, j4});
+}
+
+void ServoStreamer::setPoseSetpoint(
+  const si_m x, const si_m y, const si_m z, const si_rad r)
+{
+  this->setSetpoint(Mode::POSE, {x, y, z, r});
+}
+
+ServoStreamer::Stats ServoStreamer::getStats() const
+{
+  Stats stats;
+  stats.ticks = this->ticks_.load(std::memory_order_relaxed);
+  stats.sent = this->sent_.load(std::memory_order_relaxed);
+  stats.overruns = this->overruns_.load(std::memory_order_relaxed);
+  stats.watchdog_stops = this->watchdog_stops_.load(std::memory_order_relaxed);
+  stats.limited = this->limited_.load(std::memory_order_relaxed);
+  stats.jitter = this->jitter_.summarize();
+  return stats;
+}
+
+bool ServoStreamer::limit(
+  const Mode mode, const std::array<double, 4> & to, const double max_step,
+  const double max_angular_step, std::array<double, 4> & from)
+{
+  bool is_limited = false;
+  const auto clamp = [&is_limited](const double delta, const double max) {
+      if (std::abs(delta) <= max) {
+        return delta;
+      }
+      is_limited = true;
+      return std::copysign(max, delta);
+    };
+
+  if (mode == Mode::JOINT) {
+    for (size_t i = 0; i < from.size(); ++i) {
+      from[i] += clamp(to[i] - from[i], max_step);
+    }
+    return is_limited;
+  }
+
+  // Keep the direction of the tool: scale x, y and z together
+  const double dx = to[0] - from[0];
+  const double dy = to[1] - from[1];
+  const double dz = to[2] - from[2];
+  const double norm = std::sqrt(dx * dx + dy * dy + dz * dz);
+  const double scale = norm > max_step ? max_step / norm : 1.0;
+  is_limited = norm > max_step;
+  from[0] += dx * scale;
+  from[1] += dy * scale;
+  from[2] += dz * scale;
+  from[3] += clamp(to[3] - from[3], max_angular_step);
+  return is_limited;
+}
+
+const rclcpp::Logger ServoStreamer::getLogger()
+{
+  return rclcpp::get_logger("ServoStreamer");
+}
+
+void ServoStreamer::setSetpoint(const Mode mode, const std::array<double, 4> & values)
+{
+  std::lock_guard<std::mutex> lock(this->setpoint_mutex_);
+  this->setpoint_.store(Setpoint{true, mode, values, monotonicNow()});
+}
+
+void ServoStreamer::run()
+{
+  const int64_t period_ns = this->config_.period.count();
+  int64_t deadline_ns = monotonicNow();
+
+  while (this->is_running_.load()) {
+    deadline_ns += period_ns;
+    const timespec deadline = toTimespec(deadline_ns);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+
+    const int64_t now_ns = monotonicNow();
+    const int64_t late_ns = now_ns - deadline_ns;
+    this->jitter_.record(std::chrono::nanoseconds(std::max<int64_t>(late_ns, 0)));
+    if (late_ns >= period_ns) {
+      // Skip the periods already gone instead of sending them in a burst
+      const int64_t missed = late_ns / period_ns;
+      this->overruns_.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+      deadline_ns += missed * period_ns;
+    }
+
+    if (!this->tick(now_ns)) {
+      this->is_running_.store(false);
+    }
+  }
+}
+
+bool ServoStreamer::tick(const int64_t now_ns)
+{
+  this->ticks_.fetch_add(1, std::memory_order_relaxed);
+
+  const Setpoint setpoint = this->setpoint_.load();
+  if (!setpoint.valid) {
+    return true;
+  }
+
+  if (now_ns - setpoint.stamp_ns > this->config_.setpoint_timeout.count()) {
+    if (this->is_streaming_) {
+      RCLCPP_WARN(
+        this->getLogger(), "Setpoint is %.1lf ms old: servo stopped",
+        static_cast<double>(now_ns - setpoint.stamp_ns) * 1e-6);
+      this->watchdog_stops_.fetch_add(1, std::memory_order_relaxed);
+      this->is_streaming_ = false;
+    }
+    return true;
+  }
+
+  if (!this->is_streaming_ || this->mode_ != setpoint.mode) {
+    // (Re)start from where the arm is
+    const auto snapshot = this->feedback_source_();
+    if (!snapshot.active) {
+      return true;
+    }
+    if (setpoint.mode == Mode::JOINT) {
+      this->command_ = snapshot.joints;
+    } else {
+      this->command_ = {
+        mm2m(snapshot.tool_vector[0]), mm2m(snapshot.tool_vector[1]),
+        mm2m(snapshot.tool_vector[2]), degree2rad(snapshot.tool_vector[3])};
+    }
+    this->mode_ = setpoint.mode;
+    this->is_streaming_ = true;
+  }
+
+  const double period_s = std::chrono::duration<double>(this->config_.period).count();
+  const double max_step = this->mode_ == Mode::JOINT ?
+    this->config_.max_joint_velocity * period_s : this->config_.max_linear_velocity * period_s;
+  const double max_angular_step = this->config_.max_angular_velocity * period_s;
+  if (this->limit(this->mode_, setpoint.values, max_step, max_angular_step, this->command_)) {
+    this->limited_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const auto & c = this->command_;
+  const auto send = [this, &c]() {
+      if (this->mode_ == Mode::JOINT) {
+        this->commander_->servoJ(c[0], c[1], c[2], c[3]);
+      } else {
+        this->commander_->servoP(c[0], c[1], c[2], c[3]);
+      }
+    };
+  bool is_sent = true;
+  try {
+    if (this->send_guard_) {
+      is_sent = this->send_guard_(send);
+    } else {
+      send();
+    }
+  } catch (const std::exception & ex) {
+    // TcpSocketException once disconnected
+    RCLCPP_ERROR(this->getLogger(), "Servo stopped: %s", ex.what());
+    this->is_streaming_ = false;
+    return false;
+  }
+
+  if (!is_sent) {
+    if (!this->is_paused_) {
+      RCLCPP_WARN(this->getLogger(), "Servo paused: commands refused");
+      this->is_paused_ = true;
+    }
+    // The arm may be moved meanwhile
+    this->is_streaming_ = false;
+    return true;
+  }
+  this->is_paused_ = false;
+  this->sent_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+}  // namespace mg400_interface
@@ -0,0 +1,92 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/commander/settings_cache.hpp"
+
+#include "mg400_interface/commander/dashboard_pipeline.hpp"
+
+namespace mg400_interface
+{
+SettingsCache::SettingsCache()
+: epoch_(0),
+  next_ticket_(0),
+  stats_{0, 0, 0}
+{
+}
+
+bool SettingsCache::lookup(const std::string & command, const uint64_t epoch, uint64_t & ticket)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto & entry = this->find(command, epoch);
+  if (entry.is_valid && entry.command == command) {
+    ++this->stats_.hits;
+    return true;
+  }
+  ticket = this->reserve(entry, command);
+  return false;
+}
+
+uint64_t SettingsCache::reserve(const std::string & command, const uint64_t epoch)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->reserve(this->find(command, epoch), command);
+}
+
+void SettingsCache::store(const std::string & command, const uint64_t ticket)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  const auto it = this->entries_.find(DashboardPipeline::takeFunctionName(command));
+  // Superseded by a later lookup or voided by an invalidation otherwise
+  if (it != this->entries_.end() && it->second.ticket == ticket) {
+    it->second.is_valid = true;
+  }
+}
+
+void SettingsCache::invalidate()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->clear();
+}
+
+SettingsCache::Stats SettingsCache::getStats()
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->stats_;
+}
+
+SettingsCache::Entry & SettingsCache::find(const std::string & command, const uint64_t epoch)
+{
+  if (epoch != this->epoch_) {
+    this->epoch_ = epoch;
+    this->clear();
+  }
+  return this->entries_[DashboardPipeline::takeFunctionName(command)];
+}
+
+uint64_t SettingsCache::reserve(Entry & entry, const std::string & command)
+{
+  // Whatever was in effect is unknown until the controller answers
+  entry.command = command;
+  entry.ticket = ++this->next_ticket_;
+  entry.is_valid = false;
+  ++this->stats_.misses;
+  return entry.ticket;
+}
+
+void SettingsCache::clear()
+{
+  this->entries_.clear();
+  ++this->stats_.invalidations;
+}
+}  // namespace mg400_interface
@@ -19,9 +19,16 @@ namespace mg400_interface
 {
 JointHandler::JointState::UniquePtr
 JointHandler::getJointState(const std::array<double, 4> & joint_states, const std::string & prefix)
+{
+  return JointHandler::getJointState(joint_states, prefix, rclcpp::Clock().now());
+}
+
+JointHandler::JointState::UniquePtr JointHandler::getJointState(
+  const std::array<double, 4> & joint_states, const std::string & prefix,
+  const rclcpp::Time & stamp)
 {
   auto msg = std::make_unique<JointState>();
-  msg->header.stamp = rclcpp::Clock().now();
+  msg->header.stamp = stamp;
   msg->header.frame_id = prefix + BASE_LINK_NAME;
 
   msg->name = {
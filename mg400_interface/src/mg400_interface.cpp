@@ -18,16 +18,59 @@ namespace mg400_interface
 {
 
 MG400Interface::MG400Interface(const std::string & ip_address)
-: IP(ip_address)
+: MG400Interface(ip_address, Ports())
+{
+}
+
+MG400Interface::MG400Interface(const std::string & ip_address, const Ports & ports)
+: IP(ip_address),
+  PORTS(ports),
+  time_to_ready_(0)
 {
 }
 
 bool MG400Interface::configure(const std::string & frame_id_prefix)
 {
-  this->dashboard_tcp_if_ = std::make_unique<DashboardTcpInterface>(this->IP);
-  this->motion_tcp_if_ = std::make_unique<MotionTcpInterface>(this->IP);
+  this->io_reactor_ = std::make_shared<IoReactor>();
+  this->dashboard_tcp_if_ = std::make_unique<DashboardTcpInterface>(
+    this->IP, this->io_reactor_, this->PORTS.dashboard);
+  this->motion_tcp_if_ = std::make_unique<MotionTcpInterface>(
+    this->IP, this->io_reactor_, this->PORTS.motion);
   this->realtime_tcp_interface = std::make_shared<RealtimeFeedbackTcpInterface>(
-    this->IP, frame_id_prefix);
+    this->IP, this->io_reactor_, frame_id_prefix, this->PORTS.feedback);
+  // Kept across reconnections with its pipeline and settings cache:
+  // the plugins hold on to it
+  this->dashboard_commander = std::make_shared<DashboardCommander>(this->dashboard_tcp_if_.get());
+  this->dashboard_commander->setModeChangeCounter(
+    [realtime_tcp_interface = this->realtime_tcp_interface]() {
+      return realtime_tcp_interface->countModeChanges();
+    });
+  this->motion_queue = std::make_shared<MotionQueue>(this->motion_tcp_if_.get());
+  this->realtime_tcp_interface->setPacketListener(
+    [motion_queue = this->motion_queue](const RealTimeData * data, const int64_t stamp_ns) {
+      motion_queue->update(data, stamp_ns);
+    });
+  this->motion_preemptor = std::make_shared<MotionPreemptor>(
+    [this](const MotionPreemptor::StopCallback & done) {
+      // ResetRobot() stops the arm and drops the queue of the controller.
+      // Fails through `done` while disconnected.
+      this->dashboard_commander->resetRobot(
+        [this, done](std::future<void> result) {
+          try {
+            result.get();
+          } catch (const std::exception & ex) {
+            // Also TcpSocketException while disconnected
+            RCLCPP_ERROR(this->getLogger(), "Failed to stop the robot: %s", ex.what());
+            done(false);
+            return;
+          }
+          this->motion_queue->clear();
+          done(true);
+        });
+    },
+    [realtime_tcp_interface = this->realtime_tcp_interface]() {
+      return realtime_tcp_interface->getSnapshot();
+    });
 
   this->error_msg_generator =
     std::make_unique<ErrorMsgGenerator>("alarm_controller.json");
@@ -35,57 +78,80 @@ bool MG400Interface::configure(const std::string & frame_id_prefix)
   return this->error_msg_generator->loadJsonFile();
 }
 
+void MG400Interface::setSocketProfiles(
+  const SocketProfile & dashboard, const SocketProfile & motion,
+  const SocketProfile & feedback)
+{
+  this->dashboard_tcp_if_->setSocketProfile(dashboard);
+  this->motion_tcp_if_->setSocketProfile(motion);
+  this->realtime_tcp_interface->setSocketProfile(feedback);
+}
+
+void MG400Interface::setFeedbackMaxAge(const std::chrono::nanoseconds max_age)
+{
+  if (max_age > std::chrono::nanoseconds::zero()) {
+    this->dashboard_commander->setFeedbackSource(
+      [realtime_tcp_interface = this->realtime_tcp_interface]() {
+        return realtime_tcp_interface->getSnapshot();
+      }, max_age);
+  }
+}
 
 bool MG400Interface::activate()
 {
-  using namespace std::chrono_literals;  // NOLINT
+  const auto start = IoReactor::SteadyClock::now();
+  this->io_reactor_->start();
   this->dashboard_tcp_if_->init();
   this->realtime_tcp_interface->init();
   this->motion_tcp_if_->init();
 
-  auto clock = rclcpp::Clock();
-  const auto start = clock.now();
-
-  using namespace std::chrono_literals;  // NOLINT
-  if (rclcpp::sleep_for(2s) && !this->isConnected()) {
-    RCLCPP_ERROR(this->getLogger(), "Could not connect to DOBOT MG400.");
-    this->deactivate();
-    return false;
-  }
+  // Woken up by the reactor on every connection change and
+  // when the first valid feedback packet arrives.
+  const auto is_ok = [this]() {return this->ok();};
+  if (!this->io_reactor_->waitUntil(is_ok, start + this->CONNECT_TIMEOUT)) {
+    if (!this->isConnected()) {
+      RCLCPP_ERROR(this->getLogger(), "Could not connect to DOBOT MG400.");
+      this->deactivate();
+      return false;
+    }
 
-  if (this->isConnected() && !this->ok()) {
     RCLCPP_WARN(
       this->getLogger(),
       "Connection established but no data sent from DOBOT MG400. Waiting...");
-    if (rclcpp::sleep_for(10s) && !this->ok()) {
+    if (!this->io_reactor_->waitUntil(is_ok, start + this->READY_TIMEOUT)) {
       this->deactivate();
       return false;
     }
   }
+  this->time_to_ready_ = IoReactor::SteadyClock::now() - start;
 
-  this->dashboard_commander = std::make_shared<DashboardCommander>(this->dashboard_tcp_if_.get());
   this->motion_commander = std::make_shared<MotionCommander>(this->motion_tcp_if_.get());
 
-  RCLCPP_INFO(this->getLogger(), "Connected to DOBOT MG400");
+  RCLCPP_INFO(
+    this->getLogger(), "Connected to DOBOT MG400 (ready in %.1f ms)",
+    std::chrono::duration<double, std::milli>(this->time_to_ready_).count());
   return true;
 }
 
 bool MG400Interface::deactivate()
 {
-  this->dashboard_commander.reset();
   this->motion_commander.reset();
 
-  // disconnect each interface in parallel because it takes time sometimes.
-  std::thread discnt_dashboard_tcp_if_([this]() {this->dashboard_tcp_if_->disConnect();});
-  std::thread discnt_realtime_tcp_if_([this]() {this->realtime_tcp_interface->disConnect();});
-  std::thread discnt_motion_tcp_if_([this]() {this->motion_tcp_if_->disConnect();});
-  discnt_dashboard_tcp_if_.join();
-  discnt_realtime_tcp_if_.join();
-  discnt_motion_tcp_if_.join();
+  // Nothing blocks here: pending dashboard requests are woken up
+  // and the reactor thread leaves epoll_wait() through its eventfd.
+  this->dashboard_tcp_if_->disConnect();
+  this->realtime_tcp_interface->disConnect();
+  this->motion_tcp_if_->disConnect();
+  this->io_reactor_->stop();
 
   return true;
 }
 
+std::chrono::nanoseconds MG400Interface::getTimeToReady() const
+{
+  return this->time_to_ready_;
+}
+
 bool MG400Interface::ok()
 {
   // When MG400 is being initialized when booting up, realtime tcp interface
@@ -0,0 +1,118 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/script_tracker.hpp"
+
+namespace mg400_interface
+{
+ScriptTracker::ScriptTracker(const std::chrono::nanoseconds start_timeout)
+: START_TIMEOUT(start_timeout),
+  progress_{State::FINISHED, 0ns, 0ns, 0},
+  last_stamp_ns_(0),
+  started_ns_(0),
+  is_stopping_(false)
+{
+}
+
+void ScriptTracker::start(const int64_t stamp_ns)
+{
+  this->progress_ = {State::STARTING, 0ns, 0ns, 0};
+  this->last_stamp_ns_ = stamp_ns;
+  this->started_ns_ = stamp_ns;
+  this->is_stopping_ = false;
+}
+
+void ScriptTracker::stop()
+{
+  this->is_stopping_ = true;
+}
+
+bool ScriptTracker::update(const uint64_t robot_mode, const int64_t stamp_ns)
+{
+  if (this->isDone() || stamp_ns <= this->last_stamp_ns_) {
+    // Over, or a packet already seen
+    return false;
+  }
+
+  // Time until this packet is spent in the state seen so far
+  const auto elapsed = std::chrono::nanoseconds(stamp_ns - this->last_stamp_ns_);
+  this->last_stamp_ns_ = stamp_ns;
+  if (this->progress_.state == State::RUNNING) {
+    this->progress_.running += elapsed;
+  } else if (this->progress_.state == State::PAUSED) {
+    this->progress_.paused += elapsed;
+  }
+
+  State next = this->progress_.state;
+  switch (robot_mode) {
+    case RobotMode::RUNNING:
+      next = State::RUNNING;
+      break;
+    case RobotMode::PAUSE:
+      next = State::PAUSED;
+      break;
+    case RobotMode::ENABLE:
+      if (this->progress_.state != State::STARTING || this->is_stopping_) {
+        next = this->is_stopping_ ? State::STOPPED : State::FINISHED;
+      } else if (std::chrono::nanoseconds(stamp_ns - this->started_ns_) > this->START_TIMEOUT) {
+        next = State::FAILED;
+      }
+      break;
+    default:
+      // ERROR, DISABLED, or anything else the script cannot run in
+      next = State::FAILED;
+      break;
+  }
+
+  if (next == this->progress_.state) {
+    return false;
+  }
+  if (next == State::PAUSED) {
+    ++this->progress_.pauses;
+  }
+  this->progress_.state = next;
+  return true;
+}
+
+ScriptTracker::Progress ScriptTracker::getProgress() const
+{
+  return this->progress_;
+}
+
+bool ScriptTracker::isDone() const
+{
+  return this->progress_.state == State::FINISHED ||
+         this->progress_.state == State::STOPPED ||
+         this->progress_.state == State::FAILED;
+}
+
+const char * ScriptTracker::toString(const State state)
+{
+  switch (state) {
+    case State::STARTING:
+      return "STARTING";
+    case State::RUNNING:
+      return "RUNNING";
+    case State::PAUSED:
+      return "PAUSED";
+    case State::FINISHED:
+      return "FINISHED";
+    case State::STOPPED:
+      return "STOPPED";
+    case State::FAILED:
+      return "FAILED";
+  }
+  return "UNKNOWN";
+}
+}  // namespace mg400_interface
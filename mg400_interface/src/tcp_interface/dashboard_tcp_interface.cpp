@@ -18,9 +18,13 @@ namespace mg400_interface
 {
 using namespace std::chrono_literals; // NOLINT
 
-DashboardTcpInterface::DashboardTcpInterface(const std::string & ip)
+DashboardTcpInterface::DashboardTcpInterface(
+  const std::string & ip, const IoReactor::SharedPtr & reactor, const uint16_t port)
+: PORT_(port),
+  is_closed_(true),
+  connection_count_(0),
+  reactor_(reactor)
 {
-  this->is_running_.store(false);
   this->tcp_socket_ = std::make_shared<TcpSocketHandler>(ip, this->PORT_);
 }
 
@@ -36,30 +40,65 @@ rclcpp::Logger DashboardTcpInterface::getLogger()
 
 void DashboardTcpInterface::init() noexcept
 {
-  try {
-    this->is_running_.store(true);
-    this->thread_ = std::make_unique<std::thread>(&DashboardTcpInterface::checkConnection, this);
-  } catch (const TcpSocketException & err) {
-    RCLCPP_ERROR(this->getLogger(), "%s", err.what());
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->is_closed_ = false;
+    this->framer_.clear();
   }
+  this->reactor_->add(this);
 }
 
-void DashboardTcpInterface::checkConnection()
+std::shared_ptr<TcpSocketHandler> DashboardTcpInterface::getSocket()
 {
-  while (this->is_running_.load()) {
-    try {
-      if (!this->tcp_socket_->isConnected()) {
-        this->tcp_socket_->connect(1s);
-      } else {
-        rclcpp::sleep_for(1s);
+  return this->tcp_socket_;
+}
+
+uint32_t DashboardTcpInterface::getEvents() const
+{
+  return EPOLLIN;
+}
+
+void DashboardTcpInterface::onConnected()
+{
+  {
+    // Drop a partial response left over from the previous connection
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->framer_.clear();
+  }
+  this->connection_count_.fetch_add(1);
+}
+
+void DashboardTcpInterface::onReadable()
+{
+  bool has_frame = false;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    while (true) {
+      size_t writable;
+      char * buf = this->framer_.prepare(writable);
+      if (writable == 0) {
+        RCLCPP_ERROR(
+          this->getLogger(), "Response exceeds %zu bytes. Discarded.",
+          this->framer_.capacity());
+        this->framer_.clear();
         continue;
       }
-    } catch (const TcpSocketException & err) {
-      this->tcp_socket_->disConnect();
-      RCLCPP_ERROR(this->getLogger(), "Tcp recv error : %s", err.what());
-      return;
+      const uint32_t len = this->tcp_socket_->tryRecv(buf, writable);
+      if (len == 0) {
+        break;
+      }
+      this->framer_.commit(len);
     }
+    has_frame = this->framer_.hasFrame();
   }
+  if (has_frame) {
+    this->cv_.notify_all();
+  }
+}
+
+void DashboardTcpInterface::onDisconnected()
+{
+  this->cv_.notify_all();
 }
 
 bool DashboardTcpInterface::isConnected()
@@ -67,26 +106,63 @@ bool DashboardTcpInterface::isConnected()
   return this->tcp_socket_->isConnected();
 }
 
+void DashboardTcpInterface::setSocketProfile(const SocketProfile & profile)
+{
+  this->tcp_socket_->setProfile(profile);
+}
+
 void DashboardTcpInterface::sendCommand(const std::string & cmd)
 {
   this->tcp_socket_->send(cmd.data(), cmd.size());
 }
 
+void DashboardTcpInterface::sendCommands(const std::vector<std::string> & cmds)
+{
+  // A single write instead of one per command
+  std::vector<iovec> iov(cmds.size());
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    iov[i].iov_base = const_cast<char *>(cmds[i].data());
+    iov[i].iov_len = cmds[i].size();
+  }
+  this->tcp_socket_->sendv(iov.data(), iov.size());
+}
+
+uint64_t DashboardTcpInterface::countConnections()
+{
+  return this->connection_count_.load();
+}
+
 void DashboardTcpInterface::disConnect()
 {
-  this->is_running_.store(false);
-  if (this->thread_->joinable()) {
-    this->thread_->join();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->is_closed_ = true;
   }
+  this->cv_.notify_all();
+  this->reactor_->remove(this);
   this->tcp_socket_->disConnect();
   RCLCPP_INFO(this->getLogger(), "Close connection.");
 }
 
 std::string DashboardTcpInterface::recvResponse()
 {
-  char buf[100];
-  this->tcp_socket_->recv(buf, sizeof(buf), 500ms);
-  RCLCPP_DEBUG(this->getLogger(), "recv: %s", std::string(buf).c_str());
-  return std::string(buf);
+  // Returns one complete response, or an empty string on timeout
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->cv_.wait_for(
+    lock, this->RECV_TIMEOUT_, [this]() {
+      return this->framer_.hasFrame() || this->is_closed_ ||
+      !this->tcp_socket_->isConnected();
+    });
+
+  std::string_view frame;
+  if (this->framer_.next(frame)) {
+    RCLCPP_DEBUG(
+      this->getLogger(), "recv: %.*s", static_cast<int>(frame.size()), frame.data());
+    return std::string(frame);
+  }
+  if (this->is_closed_ || !this->tcp_socket_->isConnected()) {
+    throw TcpSocketException(this->tcp_socket_->toString() + " : connection closed");
+  }
+  return "";
 }
 }  // namespace mg400_interface
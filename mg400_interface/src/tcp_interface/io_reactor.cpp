@@ -0,0 +1,356 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/tcp_interface/io_reactor.hpp"
+
+#include <sys/eventfd.h>
+
+#include <algorithm>
+#include <array>
+
+namespace mg400_interface
+{
+IoReactor::IoReactor()
+: epoll_fd_(-1),
+  wakeup_fd_(-1),
+  loop_count_(0),
+  event_count_(0),
+  last_dispatch_ns_(0),
+  max_dispatch_ns_(0),
+  total_dispatch_ns_(0)
+{
+  this->is_running_.store(false);
+
+  this->epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  if (this->epoll_fd_ < 0) {
+    throw TcpSocketException(std::string("epoll_create1() : ") + strerror(errno));
+  }
+
+  this->wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->wakeup_fd_ < 0) {
+    ::close(this->epoll_fd_);
+    throw TcpSocketException(std::string("eventfd() : ") + strerror(errno));
+  }
+
+  // nullptr marks the wakeup event
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  if (::epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, this->wakeup_fd_, &ev) < 0) {
+    ::close(this->wakeup_fd_);
+    ::close(this->epoll_fd_);
+    throw TcpSocketException(std::string("epoll_ctl() : ") + strerror(errno));
+  }
+}
+
+IoReactor::~IoReactor()
+{
+  this->stop();
+  ::close(this->wakeup_fd_);
+  ::close(this->epoll_fd_);
+}
+
+rclcpp::Logger IoReactor::getLogger()
+{
+  return rclcpp::get_logger("IoReactor");
+}
+
+void IoReactor::start()
+{
+  if (this->is_running_.exchange(true)) {
+    return;
+  }
+  if (this->thread_ && this->thread_->joinable()) {
+    this->thread_->join();
+  }
+  this->thread_ = std::make_unique<std::thread>(&IoReactor::run, this);
+}
+
+void IoReactor::stop()
+{
+  this->is_running_.store(false);
+  this->wakeup();
+  if (this->thread_ && this->thread_->joinable()) {
+    this->thread_->join();
+  }
+}
+
+bool IoReactor::isRunning() const
+{
+  return this->is_running_.load();
+}
+
+void IoReactor::add(Handler * handler)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->findEntry(handler)) {
+      return;
+    }
+    this->entries_.push_back(
+      Entry{handler, handler->getSocket(), -1, false, SteadyClock::now(), {}});
+  }
+  this->wakeup();
+}
+
+void IoReactor::remove(Handler * handler)
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto it = std::find_if(
+    this->entries_.begin(), this->entries_.end(),
+    [handler](const Entry & entry) {return entry.handler == handler;});
+  if (it == this->entries_.end()) {
+    return;
+  }
+  if (it->registered_fd >= 0 && it->registered_fd == it->socket->getFd()) {
+    ::epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, it->registered_fd, nullptr);
+  }
+  this->entries_.erase(it);
+}
+
+IoReactor::Statistics IoReactor::getStatistics() const
+{
+  return Statistics{
+    this->loop_count_.load(),
+    this->event_count_.load(),
+    std::chrono::nanoseconds(this->last_dispatch_ns_.load()),
+    std::chrono::nanoseconds(this->max_dispatch_ns_.load()),
+    std::chrono::nanoseconds(this->total_dispatch_ns_.load())};
+}
+
+void IoReactor::notify()
+{
+  {
+    // Pairs with the predicate check in waitUntil() so no wakeup is lost
+    std::lock_guard<std::mutex> lock(this->state_mutex_);
+  }
+  this->state_cv_.notify_all();
+}
+
+void IoReactor::run()
+{
+  std::array<epoll_event, MAX_EVENTS> events;
+  auto next_timer = SteadyClock::now();
+  auto next_wakeup = next_timer;
+
+  while (this->is_running_.load()) {
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+      next_wakeup - SteadyClock::now());
+    const int n = ::epoll_wait(
+      this->epoll_fd_, events.data(), MAX_EVENTS,
+      static_cast<int>(std::max<int64_t>(wait.count(), 0)));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      RCLCPP_ERROR(this->getLogger(), "epoll_wait() : %s", strerror(errno));
+      return;
+    }
+
+    const auto start = SteadyClock::now();
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (int i = 0; i < n; ++i) {
+      if (events[i].data.ptr == nullptr) {
+        uint64_t count;
+        while (::read(this->wakeup_fd_, &count, sizeof(count)) > 0) {}
+        continue;
+      }
+      // The handler may have been removed while epoll_wait() was returning.
+      Entry * entry = this->findEntry(static_cast<Handler *>(events[i].data.ptr));
+      if (entry) {
+        this->dispatch(*entry, events[i].events);
+      }
+    }
+
+    for (auto & entry : this->entries_) {
+      if (entry.socket->isConnected()) {
+        continue;
+      }
+      if (entry.socket->isConnecting()) {
+        if (start >= entry.connect_deadline) {
+          RCLCPP_DEBUG(
+            this->getLogger(), "%s connect : timeout", entry.socket->toString().c_str());
+          this->close(entry);
+          entry.next_connect_time = start + this->RECONNECT_INTERVAL;
+        }
+        continue;
+      }
+      if (entry.is_connected) {
+        // Closed outside the reactor (e.g. send error).
+        // The kernel already dropped the fd from the epoll set.
+        this->close(entry);
+      }
+      if (start >= entry.next_connect_time) {
+        this->connect(entry, start);
+      }
+    }
+
+    if (start >= next_timer) {
+      for (auto & entry : this->entries_) {
+        entry.handler->onTimer(start);
+      }
+      next_timer = start + this->TIMER_PERIOD;
+    }
+    next_wakeup = this->getNextWakeup(next_timer);
+
+    this->updateStatistics(SteadyClock::now() - start, n);
+  }
+}
+
+void IoReactor::wakeup()
+{
+  const uint64_t one = 1;
+  const auto ret = ::write(this->wakeup_fd_, &one, sizeof(one));
+  (void)ret;  // counter overflow only means a wakeup is already pending
+}
+
+IoReactor::Entry * IoReactor::findEntry(const Handler * handler)
+{
+  for (auto & entry : this->entries_) {
+    if (entry.handler == handler) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void IoReactor::dispatch(Entry & entry, const uint32_t events)
+{
+  if (entry.socket->isConnecting()) {
+    this->finishConnect(entry);
+    return;
+  }
+
+  try {
+    // Consume pending data first so nothing is lost when the peer closes.
+    if (events & EPOLLIN) {
+      entry.handler->onReadable();
+    }
+    if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+      RCLCPP_WARN(
+        this->getLogger(), "%s : connection closed by peer",
+        entry.socket->toString().c_str());
+      this->close(entry);
+    }
+  } catch (const TcpSocketException & err) {
+    RCLCPP_ERROR(this->getLogger(), "%s", err.what());
+    this->close(entry);
+  }
+}
+
+void IoReactor::connect(Entry & entry, const SteadyClock::time_point & now)
+{
+  // Every socket connects in parallel: start the handshake here and
+  // complete it in finishConnect() once epoll reports writability.
+  entry.next_connect_time = now + this->RECONNECT_INTERVAL;
+  entry.connect_deadline = now + this->CONNECT_TIMEOUT;
+  try {
+    if (entry.socket->startConnect(this->CONNECT_TIMEOUT)) {
+      this->finishConnect(entry);
+      return;
+    }
+  } catch (const TcpSocketException & err) {
+    RCLCPP_DEBUG(this->getLogger(), "%s", err.what());
+    return;
+  }
+
+  epoll_event ev = {};
+  ev.events = EPOLLOUT;
+  ev.data.ptr = entry.handler;
+  const int fd = entry.socket->getFd();
+  if (::epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    RCLCPP_ERROR(
+      this->getLogger(), "%s epoll_ctl() : %s",
+      entry.socket->toString().c_str(), strerror(errno));
+    entry.socket->disConnect();
+    return;
+  }
+  entry.registered_fd = fd;
+}
+
+void IoReactor::finishConnect(Entry & entry)
+{
+  try {
+    if (entry.socket->isConnecting()) {
+      entry.socket->finishConnect();
+    }
+  } catch (const TcpSocketException & err) {
+    RCLCPP_DEBUG(this->getLogger(), "%s", err.what());
+    // finishConnect() already closed the fd
+    entry.registered_fd = -1;
+    return;
+  }
+
+  epoll_event ev = {};
+  ev.events = entry.handler->getEvents() | EPOLLRDHUP;
+  ev.data.ptr = entry.handler;
+  const int fd = entry.socket->getFd();
+  const int op = entry.registered_fd == fd ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (::epoll_ctl(this->epoll_fd_, op, fd, &ev) < 0) {
+    RCLCPP_ERROR(
+      this->getLogger(), "%s epoll_ctl() : %s",
+      entry.socket->toString().c_str(), strerror(errno));
+    entry.socket->disConnect();
+    entry.registered_fd = -1;
+    return;
+  }
+  entry.registered_fd = fd;
+  entry.is_connected = true;
+  entry.handler->onConnected();
+  this->notify();
+}
+
+void IoReactor::close(Entry & entry)
+{
+  // The fd is gone already when the socket closed itself on an IO error.
+  if (entry.registered_fd >= 0 && entry.registered_fd == entry.socket->getFd()) {
+    ::epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, entry.registered_fd, nullptr);
+  }
+  entry.registered_fd = -1;
+  entry.socket->disConnect();
+  if (entry.is_connected) {
+    entry.is_connected = false;
+    entry.handler->onDisconnected();
+    this->notify();
+  }
+}
+
+IoReactor::SteadyClock::time_point IoReactor::getNextWakeup(
+  const SteadyClock::time_point & next_timer) const
+{
+  auto next_wakeup = next_timer;
+  for (const auto & entry : this->entries_) {
+    if (entry.socket->isConnected()) {
+      continue;
+    }
+    next_wakeup = std::min(
+      next_wakeup,
+      entry.socket->isConnecting() ? entry.connect_deadline : entry.next_connect_time);
+  }
+  return next_wakeup;
+}
+
+void IoReactor::updateStatistics(const std::chrono::nanoseconds & elapsed, const int events)
+{
+  // Only the reactor thread writes these counters.
+  const int64_t ns = elapsed.count();
+  this->loop_count_.fetch_add(1, std::memory_order_relaxed);
+  this->event_count_.fetch_add(events, std::memory_order_relaxed);
+  this->last_dispatch_ns_.store(ns, std::memory_order_relaxed);
+  this->total_dispatch_ns_.fetch_add(ns, std::memory_order_relaxed);
+  if (ns > this->max_dispatch_ns_.load(std::memory_order_relaxed)) {
+    this->max_dispatch_ns_.store(ns, std::memory_order_relaxed);
+  }
+}
+}  // namespace mg400_interface
@@ -17,9 +17,11 @@
 namespace mg400_interface
 {
 
-MotionTcpInterface::MotionTcpInterface(const std::string & ip)
+MotionTcpInterface::MotionTcpInterface(
+  const std::string & ip, const IoReactor::SharedPtr & reactor, const uint16_t port)
+: PORT_(port),
+  reactor_(reactor)
 {
-  this->is_running_.store(false);
   this->tcp_socket_ = std::make_shared<TcpSocketHandler>(ip, this->PORT_);
 }
 
@@ -35,30 +37,28 @@ rclcpp::Logger MotionTcpInterface::getLogger()
 
 void MotionTcpInterface::init() noexcept
 {
-  try {
-    this->is_running_.store(true);
-    this->thread_ = std::make_unique<std::thread>(&MotionTcpInterface::checkConnection, this);
-  } catch (const TcpSocketException & err) {
-    RCLCPP_ERROR(this->getLogger(), "%s", err.what());
-  }
+  this->reactor_->add(this);
+}
+
+std::shared_ptr<TcpSocketHandler> MotionTcpInterface::getSocket()
+{
+  return this->tcp_socket_;
+}
+
+uint32_t MotionTcpInterface::getEvents() const
+{
+  return EPOLLIN;
 }
 
-void MotionTcpInterface::checkConnection()
+void MotionTcpInterface::onReadable()
 {
-  using namespace std::chrono_literals; // NOLINT
-  while (this->is_running_.load()) {
-    try {
-      if (!this->tcp_socket_->isConnected()) {
-        this->tcp_socket_->connect(1s);
-      } else {
-        rclcpp::sleep_for(1s);
-        continue;
-      }
-    } catch (const TcpSocketException & err) {
-      this->tcp_socket_->disConnect();
-      RCLCPP_ERROR(this->getLogger(), "Tcp recv error : %s", err.what());
-      return;
-    }
+  // The controller acknowledges every motion command on this port.
+  // Drain them so the receive buffer never fills up.
+  char buf[256];
+  uint32_t len;
+  while ((len = this->tcp_socket_->tryRecv(buf, sizeof(buf))) > 0) {
+    RCLCPP_DEBUG(
+      this->getLogger(), "recv: %s", std::string(buf, len).c_str());
   }
 }
 
@@ -67,17 +67,24 @@ bool MotionTcpInterface::isConnected()
   return this->tcp_socket_->isConnected();
 }
 
+void MotionTcpInterface::setSocketProfile(const SocketProfile & profile)
+{
+  this->tcp_socket_->setProfile(profile);
+}
+
 void MotionTcpInterface::disConnect()
 {
-  this->is_running_.store(false);
-  if (this->thread_->joinable()) {
-    this->thread_->join();
-  }
+  this->reactor_->remove(this);
   this->tcp_socket_->disConnect();
   RCLCPP_INFO(this->getLogger(), "Close connection.");
 }
 
 void MotionTcpInterface::sendCommand(const std::string & cmd)
+{
+  this->sendCommandView(cmd);
+}
+
+void MotionTcpInterface::sendCommandView(const std::string_view cmd)
 {
   this->tcp_socket_->send(cmd.data(), cmd.size());
 }
@@ -0,0 +1,75 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/tcp_interface/realtime_data_pool.hpp"
+
+namespace mg400_interface
+{
+RealTimeDataPool::RealTimeDataPool()
+: latest_(nullptr)
+{
+}
+
+RealTimeDataPool::Handle RealTimeDataPool::acquire()
+{
+  for (auto & slot : this->slots_) {
+    uint32_t expected = 0;
+    // Acquire: the last reader is done with the slot before it is overwritten
+    if (slot.ref_count.compare_exchange_strong(
+        expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+      return Handle(&slot);
+    }
+  }
+  return Handle();
+}
+
+void RealTimeDataPool::publish(Handle data)
+{
+  // The reference held by data is handed over to latest_
+  Slot * const previous = this->latest_.exchange(data.slot_);
+  data.slot_ = nullptr;
+  if (previous) {
+    previous->ref_count.fetch_sub(1);
+  }
+}
+
+RealTimeDataPool::Handle RealTimeDataPool::latest()
+{
+  while (true) {
+    Slot * const slot = this->latest_.load();
+    if (!slot) {
+      return Handle();
+    }
+    // Pin first, then make sure the slot was not recycled in the meantime.
+    // acquire() skips a slot pinned here even if it is no longer the latest.
+    slot->ref_count.fetch_add(1);
+    if (this->latest_.load() == slot) {
+      return Handle(slot);
+    }
+    slot->ref_count.fetch_sub(1);
+  }
+}
+
+size_t RealTimeDataPool::countFree() const
+{
+  size_t count = 0;
+  for (const auto & slot : this->slots_) {
+    if (slot.ref_count.load(std::memory_order_relaxed) == 0) {
+      ++count;
+    }
+  }
+  return count;
+}
+}  // namespace mg400_interface
@@ -15,15 +15,30 @@
 
 #include "mg400_interface/tcp_interface/realtime_feedback_tcp_interface.hpp"
 
+#include <array>
+#include <utility>
+
+#include <mg400_msgs/msg/robot_mode.hpp>
+
 namespace mg400_interface
 {
 RealtimeFeedbackTcpInterface::RealtimeFeedbackTcpInterface(
-  const std::string & ip, const std::string & prefix)
+  const std::string & ip, const IoReactor::SharedPtr & reactor, const std::string & prefix,
+  const uint16_t port)
 : frame_id_prefix(prefix),
-  current_joints_{}, rt_data_{}
+  PORT_(port),
+  mode_changes_(0),
+  dropped_packets_(0),
+  reactor_(reactor),
+  recv_size_(0),
+  recv_stamp_{},
+  is_active_(false),
+  controller_mode_(0),
+  log_clock_(RCL_STEADY_TIME)
 {
-  this->is_running_.store(false);
   this->tcp_socket_ = std::make_shared<TcpSocketHandler>(ip, this->PORT_);
+  this->tcp_socket_->setRxTimestamps(true);
+  this->recv_data_ = this->pool_.acquire();
 }
 
 RealtimeFeedbackTcpInterface::~RealtimeFeedbackTcpInterface()
@@ -33,12 +48,12 @@ RealtimeFeedbackTcpInterface::~RealtimeFeedbackTcpInterface()
 
 void RealtimeFeedbackTcpInterface::init() noexcept
 {
-  try {
-    this->is_running_.store(true);
-    this->thread_ = std::make_unique<std::thread>(&RealtimeFeedbackTcpInterface::recvData, this);
-  } catch (const TcpSocketException & err) {
-    RCLCPP_ERROR(this->getLogger(), "%s", err.what());
-  }
+  this->reactor_->add(this);
+}
+
+void RealtimeFeedbackTcpInterface::setPacketListener(const PacketListener & listener)
+{
+  this->packet_listener_ = listener;
 }
 
 rclcpp::Logger RealtimeFeedbackTcpInterface::getLogger()
@@ -51,39 +66,58 @@ bool RealtimeFeedbackTcpInterface::isConnected()
   return this->tcp_socket_->isConnected();
 }
 
+void RealtimeFeedbackTcpInterface::setSocketProfile(const SocketProfile & profile)
+{
+  this->tcp_socket_->setProfile(profile);
+}
+
 bool RealtimeFeedbackTcpInterface::isActive()
 {
-  return this->getRealtimeData() != nullptr;
+  return this->snapshot_.read([](const Snapshot & snapshot) {return snapshot.active;});
 }
 
 void RealtimeFeedbackTcpInterface::getCurrentJointStates(std::array<double, 4> & joints)
 {
-  this->mutex_current_joints_.lock();
-  joints = this->current_joints_;
-  this->mutex_current_joints_.unlock();
+  joints = this->snapshot_.read([](const Snapshot & snapshot) {return snapshot.joints;});
+}
+
+void RealtimeFeedbackTcpInterface::getCurrentJointStates(
+  std::array<double, 4> & joints, rclcpp::Time & stamp)
+{
+  int64_t stamp_ns = 0;
+  joints = this->snapshot_.read(
+    [&stamp_ns](const Snapshot & snapshot) {
+      stamp_ns = snapshot.stamp_ns;
+      return snapshot.joints;
+    });
+  stamp = rclcpp::Time(stamp_ns, RCL_SYSTEM_TIME);
 }
 
 void RealtimeFeedbackTcpInterface::getCurrentEndPose(Pose & pose)
 {
-  this->mutex_current_joints_.lock();
-  JointHandler::getEndPose(this->current_joints_, pose);
-  this->mutex_current_joints_.unlock();
+  std::array<double, 4> joints;
+  this->getCurrentJointStates(joints);
+  JointHandler::getEndPose(joints, pose);
 }
 
-std::shared_ptr<RealTimeData> RealtimeFeedbackTcpInterface::getRealtimeData()
+RealtimeFeedbackTcpInterface::Snapshot RealtimeFeedbackTcpInterface::getSnapshot() const
 {
-  std::shared_ptr<RealTimeData> rt_data_local_;
-  this->mutex_rt_data_.lock();
-  rt_data_local_ = this->rt_data_;
-  this->mutex_rt_data_.unlock();
-  return rt_data_local_;
+  return this->snapshot_.load();
+}
+
+RealTimeDataPool::Handle RealtimeFeedbackTcpInterface::getRealtimeData()
+{
+  return this->pool_.latest();
 }
 
 bool RealtimeFeedbackTcpInterface::getRobotMode(uint64_t & mode)
 {
-  std::shared_ptr<RealTimeData> rt_data_local_ = this->getRealtimeData();
-  if (rt_data_local_) {
-    mode = rt_data_local_->robot_mode;
+  const auto active_mode = this->snapshot_.read(
+    [](const Snapshot & snapshot) {
+      return std::make_pair(snapshot.active, snapshot.robot_mode);
+    });
+  if (active_mode.first) {
+    mode = active_mode.second;
     return true;
   } else {
     return false;
@@ -92,77 +126,158 @@ bool RealtimeFeedbackTcpInterface::getRobotMode(uint64_t & mode)
 
 void RealtimeFeedbackTcpInterface::getToolVectorActual(double* val)
 {
-    this->mutex_current_joints_.lock();
-    memcpy(val, this->tool_vector_, sizeof(this->tool_vector_));
-    this->mutex_current_joints_.unlock();
+  this->snapshot_.read(
+    [val](const Snapshot & snapshot) {
+      memcpy(val, snapshot.tool_vector, sizeof(snapshot.tool_vector));
+      return true;
+    });
 }
 
 
 bool RealtimeFeedbackTcpInterface::isRobotMode(const uint64_t & expected_mode)
 {
-  std::shared_ptr<RealTimeData> rt_data_local_ = this->getRealtimeData();
-  if (rt_data_local_) {
-    return rt_data_local_->robot_mode == expected_mode;
-  } else {
-    return false;
-  }
+  uint64_t mode;
+  return this->getRobotMode(mode) && mode == expected_mode;
+}
+
+uint64_t RealtimeFeedbackTcpInterface::countModeChanges() const
+{
+  return this->mode_changes_.load();
+}
+
+uint64_t RealtimeFeedbackTcpInterface::countDroppedPackets() const
+{
+  return this->dropped_packets_.load();
 }
 
 void RealtimeFeedbackTcpInterface::disConnect()
 {
-  this->is_running_.store(false);
-  if (this->thread_->joinable()) {
-    this->thread_->join();
-  }
+  this->reactor_->remove(this);
   this->tcp_socket_->disConnect();
   RCLCPP_INFO(this->getLogger(), "Close connection.");
 }
 
-void RealtimeFeedbackTcpInterface::recvData()
-{
-  using namespace std::chrono_literals;  // NOLINT
-  while (this->is_running_.load()) {
-    try {
-      // Error: Connection error
-      if (!this->tcp_socket_->isConnected()) {
-        this->tcp_socket_->connect(1s);
-        continue;
-      }
-
-      // Error: Data take timeout
-      auto recvd_data = std::make_shared<RealTimeData>();
-      if (!this->tcp_socket_->recv(recvd_data.get(), sizeof(RealTimeData), 1s)) {
-        RCLCPP_WARN(this->getLogger(), "Tcp recv timeout");
-        this->mutex_rt_data_.lock();
-        this->rt_data_ = nullptr;
-        this->mutex_rt_data_.unlock();
-        continue;
-      }
-
-      // Error: Size invalid
-      if (recvd_data->len != sizeof(RealTimeData)) {
-        this->mutex_rt_data_.lock();
-        this->rt_data_ = nullptr;
-        this->mutex_rt_data_.unlock();
-        continue;
-      }
-
-      // Success
-      this->mutex_rt_data_.lock();
-      this->rt_data_ = recvd_data;
-      this->mutex_rt_data_.unlock();
-
-      this->mutex_current_joints_.lock();
-      for (uint64_t i = 0; i < this->current_joints_.size(); ++i) {
-        this->current_joints_[i] = this->getRealtimeData()->q_actual[i] * TO_RADIAN;
-      }
-      memcpy(this->tool_vector_, this->rt_data_->tool_vector_actual, sizeof(this->tool_vector_));
-      this->mutex_current_joints_.unlock();
-    } catch (const TcpSocketException & err) {
-      this->tcp_socket_->disConnect();
-      RCLCPP_ERROR(this->getLogger(), "Tcp recv error: %s", err.what());
+std::shared_ptr<TcpSocketHandler> RealtimeFeedbackTcpInterface::getSocket()
+{
+  return this->tcp_socket_;
+}
+
+uint32_t RealtimeFeedbackTcpInterface::getEvents() const
+{
+  return EPOLLIN;
+}
+
+void RealtimeFeedbackTcpInterface::onConnected()
+{
+  this->recv_size_ = 0;
+  this->last_recv_time_ = IoReactor::SteadyClock::now();
+}
+
+void RealtimeFeedbackTcpInterface::onDisconnected()
+{
+  this->recv_size_ = 0;
+  this->updateData(nullptr);
+}
+
+void RealtimeFeedbackTcpInterface::onReadable()
+{
+  while (true) {
+    auto * buf = reinterpret_cast<uint8_t *>(this->recv_data_.get());
+    // The chunk completing a packet stamps it
+    const uint32_t len = this->tcp_socket_->tryRecv(
+      buf + this->recv_size_, sizeof(RealTimeData) - this->recv_size_, this->recv_stamp_);
+    if (len == 0) {
       return;
     }
+    this->recv_size_ += len;
+    if (this->recv_size_ < sizeof(RealTimeData)) {
+      continue;
+    }
+    this->recv_size_ = 0;
+    this->last_recv_time_ = IoReactor::SteadyClock::now();
+
+    // Error: Size invalid
+    if (this->recv_data_->len != sizeof(RealTimeData)) {
+      this->updateData(nullptr);
+      continue;
+    }
+
+    // Receive the next packet into a free slot
+    auto next = this->pool_.acquire();
+    if (!next) {
+      // Every other slot is pinned by readers: keep the current one
+      const uint64_t dropped = this->dropped_packets_.fetch_add(1) + 1;
+      RCLCPP_WARN_THROTTLE(
+        this->getLogger(), this->log_clock_, 1000,
+        "No free RealTimeData slot: %lu packets dropped so far", dropped);
+      continue;
+    }
+
+    // Success
+    this->updateData(
+      std::move(this->recv_data_),
+      static_cast<int64_t>(this->recv_stamp_.tv_sec) * 1000000000LL + this->recv_stamp_.tv_nsec);
+    this->recv_data_ = std::move(next);
+  }
+}
+
+void RealtimeFeedbackTcpInterface::onTimer(const IoReactor::SteadyClock::time_point & now)
+{
+  // Error: Data take timeout
+  if (this->tcp_socket_->isConnected() && now - this->last_recv_time_ > this->RECV_TIMEOUT_) {
+    RCLCPP_WARN(this->getLogger(), "Tcp recv timeout");
+    this->last_recv_time_ = now;
+    this->updateData(nullptr);
+  }
+}
+
+void RealtimeFeedbackTcpInterface::updateData(
+  RealTimeDataPool::Handle data, const int64_t stamp_ns)
+{
+  Snapshot snapshot = {};
+  if (data) {
+    snapshot.active = true;
+    snapshot.robot_mode = data->robot_mode;
+    snapshot.digital_inputs = data->digital_inputs;
+    for (uint64_t i = 0; i < snapshot.joints.size(); ++i) {
+      snapshot.joints[i] = data->q_actual[i] * TO_RADIAN;
+    }
+    memcpy(snapshot.q_actual, data->q_actual, sizeof(snapshot.q_actual));
+    memcpy(snapshot.tool_vector, data->tool_vector_actual, sizeof(snapshot.tool_vector));
+    snapshot.stamp_ns = stamp_ns;
+  }
+  if (this->packet_listener_) {
+    this->packet_listener_(data.get(), stamp_ns);
+  }
+
+  this->pool_.publish(std::move(data));
+  this->snapshot_.store(snapshot);
+
+  if (snapshot.active) {
+    const uint64_t mode = toControllerMode(snapshot.robot_mode);
+    if (mode != this->controller_mode_) {
+      // The first packet counts too: nothing is known about the mode before
+      this->controller_mode_ = mode;
+      this->mode_changes_.fetch_add(1);
+    }
+  }
+
+  if (snapshot.active != this->is_active_) {
+    this->is_active_ = snapshot.active;
+    this->reactor_->notify();
+  }
+}
+
+uint64_t RealtimeFeedbackTcpInterface::toControllerMode(const uint64_t robot_mode)
+{
+  using RobotMode = mg400_msgs::msg::RobotMode;
+  switch (robot_mode) {
+    case RobotMode::RUNNING:
+    case RobotMode::PAUSE:
+    case RobotMode::JOG:
+      return RobotMode::ENABLE;
+    default:
+      return robot_mode;
   }
 }
 }  // namespace mg400_interface
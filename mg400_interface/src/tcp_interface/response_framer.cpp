@@ -0,0 +1,91 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/tcp_interface/response_framer.hpp"
+
+#include <cstring>
+
+namespace mg400_interface
+{
+ResponseFramer::ResponseFramer(const size_t capacity, const char terminator)
+: buf_(capacity),
+  terminator_(terminator),
+  begin_(0),
+  end_(0),
+  scan_(0)
+{
+}
+
+char * ResponseFramer::prepare(size_t & writable)
+{
+  if (this->begin_ == this->end_) {
+    this->begin_ = this->end_ = this->scan_ = 0;
+  } else if (this->end_ == this->buf_.size() && this->begin_ > 0) {
+    // Only the partial frame is left: move it to the front
+    const size_t len = this->end_ - this->begin_;
+    memmove(this->buf_.data(), this->buf_.data() + this->begin_, len);
+    this->scan_ -= this->begin_;
+    this->begin_ = 0;
+    this->end_ = len;
+  }
+  writable = this->buf_.size() - this->end_;
+  return this->buf_.data() + this->end_;
+}
+
+void ResponseFramer::commit(const size_t len)
+{
+  this->end_ += len;
+}
+
+bool ResponseFramer::hasFrame()
+{
+  if (this->scan_ == this->end_) {
+    return false;
+  }
+  const void * found = memchr(
+    this->buf_.data() + this->scan_, this->terminator_, this->end_ - this->scan_);
+  if (!found) {
+    this->scan_ = this->end_;
+    return false;
+  }
+  this->scan_ = static_cast<const char *>(found) - this->buf_.data();
+  return true;
+}
+
+bool ResponseFramer::next(std::string_view & frame)
+{
+  if (!this->hasFrame()) {
+    return false;
+  }
+  const size_t frame_end = this->scan_ + 1;
+  frame = std::string_view(this->buf_.data() + this->begin_, frame_end - this->begin_);
+  this->begin_ = this->scan_ = frame_end;
+  return true;
+}
+
+void ResponseFramer::clear()
+{
+  this->begin_ = this->end_ = this->scan_ = 0;
+}
+
+size_t ResponseFramer::size() const
+{
+  return this->end_ - this->begin_;
+}
+
+size_t ResponseFramer::capacity() const
+{
+  return this->buf_.size();
+}
+}  // namespace mg400_interface
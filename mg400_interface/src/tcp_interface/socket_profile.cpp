@@ -0,0 +1,40 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/tcp_interface/socket_profile.hpp"
+
+namespace mg400_interface
+{
+std::string SocketProfile::toString() const
+{
+  std::string str;
+  const auto append = [&str](const std::string & option) {
+      str += str.empty() ? option : " " + option;
+    };
+
+  if (this->tcp_nodelay) {append("nodelay");}
+  if (this->tcp_quickack) {append("quickack");}
+  if (this->rcvbuf > 0) {append("rcvbuf=" + std::to_string(this->rcvbuf));}
+  if (this->sndbuf > 0) {append("sndbuf=" + std::to_string(this->sndbuf));}
+  if (this->priority > 0) {append("priority=" + std::to_string(this->priority));}
+  if (this->busy_poll > 0) {append("busy_poll=" + std::to_string(this->busy_poll));}
+  if (this->keepalive) {
+    append(
+      "keepalive=" + std::to_string(this->keepalive_idle) + "/" +
+      std::to_string(this->keepalive_interval) + "/" + std::to_string(this->keepalive_count));
+  }
+  if (this->user_timeout > 0) {append("user_timeout=" + std::to_string(this->user_timeout));}
+  return str.empty() ? "default" : str;
+}
+}  // namespace mg400_interface
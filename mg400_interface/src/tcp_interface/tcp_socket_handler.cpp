@@ -20,8 +20,10 @@ static const rclcpp::Logger LOGGER = rclcpp::get_logger("TcpClient");
 
 TcpSocketHandler::TcpSocketHandler(std::string ip, uint16_t port)
 : fd_(-1),
+  users_(0),
   port_(port),
-  ip_(std::move(ip))
+  ip_(std::move(ip)),
+  rx_timestamps_(false)
 {
   this->is_connected_.store(false);
 }
@@ -33,37 +35,82 @@ TcpSocketHandler::~TcpSocketHandler()
 
 void TcpSocketHandler::close()
 {
-  if (this->fd_ < 0) {
-    // TcpClient not connected
-    // Do nothing
-    return;
-  }
+  this->disConnect();
+}
 
-  ::close(this->fd_);
-  this->is_connected_.store(false);
-  this->fd_ = -1;
+void TcpSocketHandler::setProfile(const SocketProfile & profile)
+{
+  this->profile_ = profile;
+}
+
+const SocketProfile & TcpSocketHandler::getProfile() const
+{
+  return this->profile_;
+}
+
+void TcpSocketHandler::setRxTimestamps(const bool enable)
+{
+  this->rx_timestamps_ = enable;
 }
 
 void TcpSocketHandler::connect(const std::chrono::nanoseconds & timeout)
 {
-  if (this->fd_ < 0) {
-    this->fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (this->fd_ < 0) {
-      throw TcpSocketException(this->toString() + std::string(" socket : ") + strerror(errno));
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  if (this->startConnect(timeout)) {
+    return;
+  }
+
+  pollfd pfd = {this->getFd(), POLLOUT, 0};
+  while (true) {
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      this->close();
+      throw TcpSocketException(this->toString() + std::string(" connect : timeout"));
     }
 
-    timeval tv = {0, 0};
-    tv.tv_sec = timeout.count() / static_cast<int>(1e9);
-    tv.tv_usec = (timeout.count() % static_cast<int>(1e9)) / static_cast<int>(1e3);
-    if (::setsockopt(
-        this->fd_, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char *>(&tv), sizeof(tv)) < 0)
-    {
-      ::close(this->fd_);
-      this->fd_ = -1;
-      throw TcpSocketException(this->toString() + std::string(" socket : ") + strerror(errno));
+    const int err = ::poll(&pfd, 1, static_cast<int>(remaining.count()));
+    if (err > 0) {
+      break;
+    } else if (err < 0 && errno != EINTR) {
+      this->close();
+      throw TcpSocketException(this->toString() + std::string(" poll() : ") + strerror(errno));
     }
   }
 
+  this->finishConnect();
+}
+
+bool TcpSocketHandler::startConnect(const std::chrono::nanoseconds & send_timeout)
+{
+  this->close();
+
+  const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    throw TcpSocketException(this->toString() + std::string(" socket : ") + strerror(errno));
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->fd_mutex_);
+    this->fd_ = fd;
+  }
+
+  timeval tv = {0, 0};
+  tv.tv_sec = send_timeout.count() / static_cast<int>(1e9);
+  tv.tv_usec = (send_timeout.count() % static_cast<int>(1e9)) / static_cast<int>(1e3);
+  if (::setsockopt(
+      fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char *>(&tv), sizeof(tv)) < 0)
+  {
+    const int err = errno;
+    this->close();
+    throw TcpSocketException(this->toString() + std::string(" socket : ") + strerror(err));
+  }
+
+  // Buffer sizes must be set before connecting to affect the window scale
+  this->applyProfile(fd);
+  if (this->rx_timestamps_) {
+    this->setOption(fd, SOL_SOCKET, SO_TIMESTAMPNS, 1, "SO_TIMESTAMPNS");
+  }
+
   sockaddr_in addr = {};
 
   memset(&addr, 0, sizeof(addr));
@@ -71,14 +118,40 @@ void TcpSocketHandler::connect(const std::chrono::nanoseconds & timeout)
   addr.sin_family = AF_INET;
   addr.sin_port = htons(this->port_);
 
-  if (::connect(this->fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
-    ::close(this->fd_);
-    this->fd_ = -1;
-    if (errno == EINPROGRESS || errno == EAGAIN) {
-      throw  TcpSocketException(this->toString() + std::string(" connect : timeout"));
-    } else {
-      throw  TcpSocketException(this->toString() + std::string(" connect : ") + strerror(errno));
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    if (errno == EINPROGRESS) {
+      // Wait for writability, then call finishConnect()
+      return false;
     }
+    const int err = errno;
+    this->close();
+    throw TcpSocketException(this->toString() + std::string(" connect : ") + strerror(err));
+  }
+
+  this->finishConnect();
+  return true;
+}
+
+void TcpSocketHandler::finishConnect()
+{
+  // Only the connecting thread replaces the fd
+  const int fd = this->getFd();
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+    err = errno;
+  }
+  if (err != 0) {
+    this->close();
+    throw TcpSocketException(this->toString() + std::string(" connect : ") + strerror(err));
+  }
+
+  // send() and recv() rely on blocking IO bounded by SO_SNDTIMEO / select()
+  const int flags = ::fcntl(fd, F_GETFL, 0);
+  if (flags < 0 || ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+    err = errno;
+    this->close();
+    throw TcpSocketException(this->toString() + std::string(" fcntl() : ") + strerror(err));
   }
 
   this->is_connected_.store(true);
@@ -88,11 +161,40 @@ void TcpSocketHandler::connect(const std::chrono::nanoseconds & timeout)
 
 void TcpSocketHandler::disConnect()
 {
-  if (this->is_connected_.load()) {
+  std::lock_guard<std::mutex> lock(this->fd_mutex_);
+  this->shutdownFd();
+}
+
+void TcpSocketHandler::dropFd(const int fd)
+{
+  std::lock_guard<std::mutex> lock(this->fd_mutex_);
+  // Leave a newer connection alone
+  if (this->fd_ == fd) {
+    this->shutdownFd();
+  }
+}
+
+void TcpSocketHandler::shutdownFd()
+{
+  if (this->fd_ < 0) {
+    return;
+  }
+  this->is_connected_.store(false);
+  // Wakes up a blocked send() at once
+  ::shutdown(this->fd_, SHUT_RDWR);
+  if (this->users_ > 0) {
+    // Closed by the last call still using it
+    this->closing_fds_.push_back(this->fd_);
+  } else {
     ::close(this->fd_);
-    this->is_connected_.store(false);
-    this->fd_ = -1;
   }
+  this->fd_ = -1;
+}
+
+bool TcpSocketHandler::isConnecting() const
+{
+  std::lock_guard<std::mutex> lock(this->fd_mutex_);
+  return this->fd_ >= 0 && !this->is_connected_.load();
 }
 
 bool TcpSocketHandler::isConnected() const
@@ -100,62 +202,266 @@ bool TcpSocketHandler::isConnected() const
   return this->is_connected_.load();
 }
 
-void TcpSocketHandler::send(const void * buf, uint32_t len)
+int TcpSocketHandler::getFd() const
 {
-  if (!this->is_connected_.load()) {
+  std::lock_guard<std::mutex> lock(this->fd_mutex_);
+  return this->fd_;
+}
+
+int TcpSocketHandler::acquireFd()
+{
+  std::lock_guard<std::mutex> lock(this->fd_mutex_);
+  if (!this->is_connected_.load() || this->fd_ < 0) {
     throw TcpSocketException("tcp is disconnected");
   }
+  ++this->users_;
+  return this->fd_;
+}
+
+void TcpSocketHandler::releaseFd()
+{
+  std::lock_guard<std::mutex> lock(this->fd_mutex_);
+  if (--this->users_ > 0) {
+    return;
+  }
+  for (const int fd : this->closing_fds_) {
+    ::close(fd);
+  }
+  this->closing_fds_.clear();
+}
+
+void TcpSocketHandler::send(const void * buf, uint32_t len)
+{
+  const int fd = this->acquireFd();
 
-  RCLCPP_INFO(LOGGER, "send : %s", (const char *)buf);
+  WireTap::record(WireTap::Direction::SEND, this->port_, buf, len);
 
   const auto * tmp = (const uint8_t *)buf;
   while (len) {
-    int err = static_cast<int>(::send(fd_, tmp, len, MSG_NOSIGNAL));
+    int err = static_cast<int>(::send(fd, tmp, len, MSG_NOSIGNAL));
     if (err < 0) {
-      this->disConnect();
-      throw TcpSocketException(this->toString() + std::string(" ::send() ") + strerror(errno));
+      err = errno;
+      this->dropFd(fd);
+      this->releaseFd();
+      throw TcpSocketException(this->toString() + std::string(" ::send() ") + strerror(err));
     }
     len -= err;
     tmp += err;
   }
+  this->releaseFd();
+}
+
+void TcpSocketHandler::sendv(iovec * iov, size_t iovcnt)
+{
+  const int fd = this->acquireFd();
+
+  for (size_t i = 0; i < iovcnt; ++i) {
+    WireTap::record(WireTap::Direction::SEND, this->port_, iov[i].iov_base, iov[i].iov_len);
+  }
+
+  msghdr msg = {};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovcnt;
+  while (msg.msg_iovlen) {
+    // sendmsg() rather than writev() for MSG_NOSIGNAL
+    ssize_t err = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (err < 0) {
+      const int error = errno;
+      this->dropFd(fd);
+      this->releaseFd();
+      throw TcpSocketException(this->toString() + std::string(" ::sendmsg() ") + strerror(error));
+    }
+    // Skip what was written, possibly stopping in the middle of a buffer
+    while (msg.msg_iovlen && static_cast<size_t>(err) >= msg.msg_iov->iov_len) {
+      err -= msg.msg_iov->iov_len;
+      ++msg.msg_iov;
+      --msg.msg_iovlen;
+    }
+    if (msg.msg_iovlen) {
+      msg.msg_iov->iov_base = static_cast<uint8_t *>(msg.msg_iov->iov_base) + err;
+      msg.msg_iov->iov_len -= err;
+    }
+  }
+  this->releaseFd();
 }
 
 bool TcpSocketHandler::recv(void * buf, uint32_t len, const std::chrono::nanoseconds & timeout)
 {
+  const int fd = this->acquireFd();
   uint8_t * tmp = reinterpret_cast<uint8_t *>(buf);
   fd_set read_fds;
   timeval tv = {0, 0};
 
-  while (len) {
-    FD_ZERO(&read_fds);
-    FD_SET(this->fd_, &read_fds);
+  try {
+    while (len) {
+      FD_ZERO(&read_fds);
+      FD_SET(fd, &read_fds);
 
-    tv.tv_sec = timeout.count() / static_cast<int>(1e9);
-    tv.tv_usec = (timeout.count() % static_cast<int>(1e9)) / static_cast<int>(1e3);
-    int err = ::select(this->fd_ + 1, &read_fds, nullptr, nullptr, &tv);
-    if (err < 0) {
-      this->disConnect();
-      throw TcpSocketException(this->toString() + std::string(" select() : ") + strerror(errno));
-    } else if (err == 0) {
-      return false;
-    }
-    err = static_cast<int>(::read(fd_, tmp, len));
-    if (err < 0) {
-      this->disConnect();
-      throw TcpSocketException(this->toString() + std::string(" ::read() ") + strerror(errno));
-    } else if (err == 0) {
-      this->disConnect();
-      throw TcpSocketException(this->toString() + std::string(" tcp server has disconnected."));
+      tv.tv_sec = timeout.count() / static_cast<int>(1e9);
+      tv.tv_usec = (timeout.count() % static_cast<int>(1e9)) / static_cast<int>(1e3);
+      int err = ::select(fd + 1, &read_fds, nullptr, nullptr, &tv);
+      if (err < 0) {
+        err = errno;
+        this->dropFd(fd);
+        throw TcpSocketException(this->toString() + std::string(" select() : ") + strerror(err));
+      } else if (err == 0) {
+        this->releaseFd();
+        return false;
+      }
+      err = static_cast<int>(::read(fd, tmp, len));
+      if (err < 0) {
+        err = errno;
+        this->dropFd(fd);
+        throw TcpSocketException(this->toString() + std::string(" ::read() ") + strerror(err));
+      } else if (err == 0) {
+        this->dropFd(fd);
+        throw TcpSocketException(this->toString() + std::string(" tcp server has disconnected."));
+      }
+      WireTap::record(WireTap::Direction::RECV, this->port_, tmp, err);
+      if (this->profile_.tcp_quickack) {
+        this->setOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+      }
+      len -= err;
+      tmp += err;
     }
-    len -= err;
-    tmp += err;
+  } catch (...) {
+    // Closed once released
+    this->releaseFd();
+    throw;
   }
+  this->releaseFd();
   return true;
 }
 
+uint32_t TcpSocketHandler::tryRecv(void * buf, uint32_t len)
+{
+  const int fd = this->acquireFd();
+  const auto err = ::recv(fd, buf, len, MSG_DONTWAIT);
+  const int error = errno;
+  if (err > 0) {
+    WireTap::record(WireTap::Direction::RECV, this->port_, buf, err);
+    if (this->profile_.tcp_quickack) {
+      // The kernel falls back to delayed ACKs, so this is not a one-off option
+      this->setOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+    }
+  }
+  const bool retry = err < 0 && (error == EAGAIN || error == EWOULDBLOCK || error == EINTR);
+  if ((err < 0 && !retry) || (err == 0 && len > 0)) {
+    this->dropFd(fd);
+  }
+  this->releaseFd();
+
+  if (err < 0) {
+    if (retry) {
+      return 0;
+    }
+    throw TcpSocketException(this->toString() + std::string(" ::recv() ") + strerror(error));
+  } else if (err == 0 && len > 0) {
+    throw TcpSocketException(this->toString() + std::string(" tcp server has disconnected."));
+  }
+  return static_cast<uint32_t>(err);
+}
+
+uint32_t TcpSocketHandler::tryRecv(void * buf, uint32_t len, timespec & stamp)
+{
+  iovec iov = {buf, len};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  const int fd = this->acquireFd();
+  const auto err = ::recvmsg(fd, &msg, MSG_DONTWAIT);
+  const int error = errno;
+  if (err > 0 && this->profile_.tcp_quickack) {
+    this->setOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+  }
+  const bool retry = err < 0 && (error == EAGAIN || error == EWOULDBLOCK || error == EINTR);
+  if ((err < 0 && !retry) || (err == 0 && len > 0)) {
+    this->dropFd(fd);
+  }
+  this->releaseFd();
+
+  if (err < 0) {
+    if (retry) {
+      return 0;
+    }
+    throw TcpSocketException(this->toString() + std::string(" ::recvmsg() ") + strerror(error));
+  } else if (err == 0 && len > 0) {
+    throw TcpSocketException(this->toString() + std::string(" tcp server has disconnected."));
+  }
+
+  bool has_stamp = false;
+  for (cmsghdr * cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+      has_stamp = true;
+    }
+  }
+  if (!has_stamp) {
+    clock_gettime(CLOCK_REALTIME, &stamp);
+  }
+
+  WireTap::record(WireTap::Direction::RECV, this->port_, buf, err);
+  return static_cast<uint32_t>(err);
+}
+
 std::string TcpSocketHandler::toString()
 {
   return this->ip_ + ":" + std::to_string(this->port_);
 }
 
+void TcpSocketHandler::applyProfile(const int fd)
+{
+  const auto & profile = this->profile_;
+  if (profile.tcp_nodelay) {
+    this->setOption(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+  }
+  if (profile.tcp_quickack) {
+    this->setOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+  }
+  if (profile.rcvbuf > 0) {
+    this->setOption(fd, SOL_SOCKET, SO_RCVBUF, profile.rcvbuf, "SO_RCVBUF");
+  }
+  if (profile.sndbuf > 0) {
+    this->setOption(fd, SOL_SOCKET, SO_SNDBUF, profile.sndbuf, "SO_SNDBUF");
+  }
+  if (profile.priority > 0) {
+    this->setOption(fd, SOL_SOCKET, SO_PRIORITY, profile.priority, "SO_PRIORITY");
+  }
+  if (profile.busy_poll > 0) {
+    this->setOption(fd, SOL_SOCKET, SO_BUSY_POLL, profile.busy_poll, "SO_BUSY_POLL");
+  }
+  if (profile.keepalive) {
+    this->setOption(fd, SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE");
+    if (profile.keepalive_idle > 0) {
+      this->setOption(fd, IPPROTO_TCP, TCP_KEEPIDLE, profile.keepalive_idle, "TCP_KEEPIDLE");
+    }
+    if (profile.keepalive_interval > 0) {
+      this->setOption(fd, IPPROTO_TCP, TCP_KEEPINTVL, profile.keepalive_interval, "TCP_KEEPINTVL");
+    }
+    if (profile.keepalive_count > 0) {
+      this->setOption(fd, IPPROTO_TCP, TCP_KEEPCNT, profile.keepalive_count, "TCP_KEEPCNT");
+    }
+  }
+  if (profile.user_timeout > 0) {
+    this->setOption(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, profile.user_timeout, "TCP_USER_TIMEOUT");
+  }
+}
+
+bool TcpSocketHandler::setOption(
+  const int fd, const int level, const int name, const int value, const char * label)
+{
+  // A rejected option only costs latency, so keep the connection usable.
+  if (::setsockopt(fd, level, name, &value, sizeof(value)) < 0) {
+    RCLCPP_WARN(
+      LOGGER, "%s setsockopt(%s, %d) : %s",
+      this->toString().c_str(), label, value, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
 }  // namespace mg400_interface
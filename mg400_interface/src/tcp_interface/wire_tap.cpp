@@ -0,0 +1,254 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_interface/tcp_interface/wire_tap.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "mg400_interface/spsc_ring.hpp"
+
+namespace mg400_interface
+{
+struct WireTapSlot
+{
+  WireTap::RecordHeader header;
+  uint8_t payload[WireTap::MAX_PAYLOAD];
+};
+using WireTapRing = SpscRing<WireTapSlot, 64>;
+
+// Ring of the calling thread, valid while `session` matches the running capture
+struct WireTapThreadRing
+{
+  std::shared_ptr<WireTapRing> ring;
+  uint64_t session = 0;
+};
+
+static thread_local WireTapThreadRing thread_ring;
+
+// Guards everything below except the atomics
+static std::mutex session_mutex;
+static std::condition_variable session_cv;
+static std::atomic<uint64_t> session_id(0);
+static std::atomic<uint64_t> dropped_count(0);
+static bool is_running = false;
+static FILE * output = nullptr;
+static std::vector<std::shared_ptr<WireTapRing>> rings;
+static std::unique_ptr<std::thread> writer;
+
+std::atomic<bool> WireTap::is_enabled_(false);
+constexpr char WireTap::MAGIC[8];
+
+// Returns the number of records written.
+// Only one thread at a time may drain: the writer, or stop() after joining it.
+static size_t drain(const std::vector<std::shared_ptr<WireTapRing>> & targets)
+{
+  size_t count = 0;
+  for (const auto & ring : targets) {
+    const WireTapSlot * slot;
+    while ((slot = ring->front()) != nullptr) {
+      fwrite(&slot->header, sizeof(slot->header), 1, output);
+      fwrite(slot->payload, 1, slot->header.len, output);
+      ring->pop();
+      ++count;
+    }
+  }
+  return count;
+}
+
+static void runWriter()
+{
+  using namespace std::chrono_literals;  // NOLINT
+  std::vector<std::shared_ptr<WireTapRing>> targets;
+  std::unique_lock<std::mutex> lock(session_mutex);
+  while (is_running) {
+    // Rings only referenced from here belong to threads that have exited.
+    rings.erase(
+      std::remove_if(
+        rings.begin(), rings.end(),
+        [](const std::shared_ptr<WireTapRing> & ring) {
+          return ring.use_count() == 1 && ring->empty();
+        }),
+      rings.end());
+    targets = rings;
+
+    lock.unlock();
+    const size_t count = drain(targets);
+    lock.lock();
+
+    if (count == 0) {
+      session_cv.wait_for(lock, 10ms);
+    }
+  }
+}
+
+rclcpp::Logger WireTap::getLogger()
+{
+  return rclcpp::get_logger("WireTap");
+}
+
+bool WireTap::start(const std::string & path)
+{
+  std::lock_guard<std::mutex> lock(session_mutex);
+  if (is_running) {
+    return true;
+  }
+
+  output = fopen(path.c_str(), "wb");
+  if (!output) {
+    RCLCPP_ERROR(
+      getLogger(), "Could not open %s : %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  FileHeader header = {};
+  memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version = VERSION;
+  fwrite(&header, sizeof(header), 1, output);
+
+  dropped_count.store(0);
+  session_id.fetch_add(1, std::memory_order_release);
+  is_running = true;
+  writer = std::make_unique<std::thread>(runWriter);
+  is_enabled_.store(true);
+
+  RCLCPP_INFO(getLogger(), "Capturing to %s", path.c_str());
+  return true;
+}
+
+void WireTap::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(session_mutex);
+    if (!is_running) {
+      return;
+    }
+    is_enabled_.store(false);
+    is_running = false;
+  }
+  session_cv.notify_all();
+  writer->join();
+  writer.reset();
+
+  // Flush what the writer had not picked up yet
+  std::lock_guard<std::mutex> lock(session_mutex);
+  drain(rings);
+  rings.clear();
+  fclose(output);
+  output = nullptr;
+
+  RCLCPP_INFO(
+    getLogger(), "Capture stopped (%lu frames dropped)", dropped_count.load());
+}
+
+uint64_t WireTap::getDroppedCount()
+{
+  return dropped_count.load();
+}
+
+void WireTap::push(
+  const Direction direction, const uint16_t port,
+  const void * buf, const uint32_t len) noexcept
+{
+  const uint64_t session = session_id.load(std::memory_order_acquire);
+  if (thread_ring.session != session) {
+    // First frame of this thread in this capture: register a new ring.
+    std::lock_guard<std::mutex> lock(session_mutex);
+    if (!is_running) {
+      return;
+    }
+    try {
+      thread_ring.ring = std::make_shared<WireTapRing>();
+    } catch (const std::bad_alloc &) {
+      dropped_count.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    thread_ring.session = session_id.load();
+    rings.push_back(thread_ring.ring);
+  }
+
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  const int64_t stamp_ns = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+  const auto * data = reinterpret_cast<const uint8_t *>(buf);
+  uint32_t offset = 0;
+  do {
+    WireTapSlot * slot = thread_ring.ring->beginPush();
+    if (!slot) {
+      dropped_count.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const uint32_t chunk = std::min(len - offset, MAX_PAYLOAD);
+    slot->header.stamp_ns = stamp_ns;
+    slot->header.port = port;
+    slot->header.direction = static_cast<uint8_t>(direction);
+    slot->header.reserved = 0;
+    slot->header.len = chunk;
+    memcpy(slot->payload, data + offset, chunk);
+    thread_ring.ring->endPush();
+    offset += chunk;
+  } while (offset < len);
+}
+
+WireTapReader::WireTapReader(const std::string & path)
+: fp_(fopen(path.c_str(), "rb"))
+{
+  if (!this->fp_) {
+    throw std::runtime_error("Could not open " + path);
+  }
+
+  WireTap::FileHeader header;
+  if (fread(&header, sizeof(header), 1, this->fp_) != 1 ||
+    memcmp(header.magic, WireTap::MAGIC, sizeof(header.magic)) != 0)
+  {
+    fclose(this->fp_);
+    throw std::runtime_error(path + " is not a wire tap file");
+  }
+  if (header.version != WireTap::VERSION) {
+    fclose(this->fp_);
+    throw std::runtime_error(
+      "Unsupported wire tap version " + std::to_string(header.version));
+  }
+}
+
+WireTapReader::~WireTapReader()
+{
+  fclose(this->fp_);
+}
+
+bool WireTapReader::next(Record & record)
+{
+  WireTap::RecordHeader header;
+  if (fread(&header, sizeof(header), 1, this->fp_) != 1) {
+    return false;
+  }
+
+  record.stamp = std::chrono::nanoseconds(header.stamp_ns);
+  record.port = header.port;
+  record.direction = static_cast<WireTap::Direction>(header.direction);
+  record.payload.resize(header.len);
+  if (fread(&record.payload[0], 1, header.len, this->fp_) != header.len) {
+    // Truncated by a crash while capturing
+    return false;
+  }
+  return true;
+}
+}  // namespace mg400_interface
@@ -0,0 +1,87 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Print a capture written by mg400_interface::WireTap as one line per frame:
+//   <unix time> <port> <direction> <length> <payload>
+// Text payloads are printed escaped, binary ones as a hex dump.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <mg400_interface/tcp_interface/wire_tap.hpp>
+
+static bool isText(const std::string & payload)
+{
+  for (const unsigned char c : payload) {
+    if (!std::isprint(c) && c != '\n' && c != '\r' && c != '\t') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void printPayload(const std::string & payload, const size_t max_hex_bytes)
+{
+  if (isText(payload)) {
+    for (const char c : payload) {
+      switch (c) {
+        case '\n': printf("\\n"); break;
+        case '\r': printf("\\r"); break;
+        case '\t': printf("\\t"); break;
+        default: putchar(c); break;
+      }
+    }
+    return;
+  }
+
+  const size_t len = std::min(payload.size(), max_hex_bytes);
+  for (size_t i = 0; i < len; ++i) {
+    printf("%02x", static_cast<unsigned char>(payload[i]));
+  }
+  if (len < payload.size()) {
+    printf("...");
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <capture file> [max hex bytes (default 32)]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const size_t max_hex_bytes = argc > 2 ? std::stoul(argv[2]) : 32;
+
+  try {
+    mg400_interface::WireTapReader reader(argv[1]);
+    mg400_interface::WireTapReader::Record record;
+    while (reader.next(record)) {
+      const int64_t ns = record.stamp.count();
+      printf(
+        "%ld.%09ld %5u %s %5zu ",
+        ns / 1000000000L, ns % 1000000000L, record.port,
+        record.direction == mg400_interface::WireTap::Direction::SEND ? ">>" : "<<",
+        record.payload.size());
+      printPayload(record.payload, max_hex_bytes);
+      putchar('\n');
+    }
+  } catch (const std::runtime_error & ex) {
+    fprintf(stderr, "%s\n", ex.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <mg400_interface/commander/command_encoder.hpp>
+
+using mg400_interface::CommandBuffer;
+using mg400_interface::CommandEncoder;
+using mg400_interface::NamedParam;
+
+constexpr char SYNC[] = "Sync";
+constexpr char MOV_J[] = "MovJ";
+constexpr char MOV_L_IO[] = "MovLIO";
+constexpr char MOVE_JOG[] = "MoveJog";
+constexpr char CP[] = "CP";
+
+using SyncCommand = CommandEncoder<SYNC>;
+using MovJCommand = CommandEncoder<MOV_J, double, double, double, double>;
+using MovLIOCommand = CommandEncoder<MOV_L_IO, double, std::array<int64_t, 4>>;
+using MoveJogCommand = CommandEncoder<MOVE_JOG, std::string_view>;
+using MovJCPCommand = CommandEncoder<MOV_J, double, NamedParam<CP, int>>;
+
+TEST(TestCommandEncoder, Encode)
+{
+  CommandBuffer buf;
+  EXPECT_EQ(SyncCommand::encode(buf), "Sync()");
+  EXPECT_EQ(
+    MovJCommand::encode(buf, 1.0, -2.5, 0.0004, 300.0),
+    "MovJ(1.000,-2.500,0.000,300.000)");
+  EXPECT_EQ(
+    MovLIOCommand::encode(buf, 10.0, {0, -50, 1, 1}),
+    "MovLIO(10.000,{0,-50,1,1})");
+  EXPECT_EQ(MoveJogCommand::encode(buf, "J1+"), "MoveJog(J1+)");
+  EXPECT_EQ(MoveJogCommand::encode(buf, ""), "MoveJog()");
+  EXPECT_EQ(MovJCPCommand::encode(buf, 1.0, {50}), "MovJ(1.000,CP=50)");
+}
+
+TEST(TestCommandEncoder, SameAsSnprintf)
+{
+  // Rounding and the sign of values rounded to zero included
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-400.0, 400.0);
+  std::vector<double> values = {-0.0, -0.0004, 0.0005, 0.0015, 2.0005, -1e-9, 1e6};
+  for (int i = 0; i < 10000; ++i) {
+    values.push_back(dist(gen));
+  }
+
+  CommandBuffer buf;
+  for (const double value : values) {
+    char expected[100];
+    snprintf(
+      expected, sizeof(expected), "MovJ(%.3lf,%.3lf,%.3lf,%.3lf)", value, -value, value, 0.0);
+    ASSERT_EQ(MovJCommand::encode(buf, value, -value, value, 0.0), expected) << value;
+  }
+}
+
+TEST(TestCommandEncoder, ThrowsWhenTooLong)
+{
+  CommandBuffer buf;
+  EXPECT_THROW(MovJCommand::encode(buf, 1e300, 0.0, 0.0, 0.0), std::runtime_error);
+  EXPECT_THROW(
+    MoveJogCommand::encode(buf, std::string(buf.size(), 'J')), std::runtime_error);
+}
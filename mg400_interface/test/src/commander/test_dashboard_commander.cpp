@@ -13,10 +13,21 @@
 // limitations under the License.
 
 #include <gmock/gmock.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <mg400_interface/commander/dashboard_commander.hpp>
 #include <mg400_msgs/msg/robot_mode.hpp>
 
 using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
 using ::testing::StrEq;
 using ::testing::Return;
 
@@ -34,6 +45,7 @@ public:
   : mg400_interface::DashboardTcpInterfaceBase() {}
 
   MOCK_METHOD(void, sendCommand, (const std::string &), (override));
+  MOCK_METHOD(void, sendCommands, (const std::vector<std::string> &), (override));
   MOCK_METHOD(std::string, recvResponse, (), (override));
 };
 
@@ -239,35 +251,58 @@ TEST_F(TestDashboardCommander, CP) {
     Return("0,{},CP(50);"));
   ASSERT_NO_THROW(commander->cp(50));
 }
-/*
+
 TEST_F(TestDashboardCommander, RunScript) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("RunScript(demo)"))).Times(1);
-  commander->runScript("demo");
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},RunScript(demo);"));
+  ASSERT_NO_THROW(commander->runScript("demo"));
+}
+
+TEST_F(TestDashboardCommander, RunScriptLongName) {
+  const std::string name(200, 'a');
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("RunScript(" + name + ")"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},RunScript(" + name + ");"));
+  ASSERT_NO_THROW(commander->runScript(name));
 }
 
 TEST_F(TestDashboardCommander, StopScript) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("StopScript()"))).Times(1);
-  commander->stopScript();
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},StopScript();"));
+  ASSERT_NO_THROW(commander->stopScript());
 }
 
 TEST_F(TestDashboardCommander, PauseScript) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("PauseScript()"))).Times(1);
-  commander->pauseScript();
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},PauseScript();"));
+  ASSERT_NO_THROW(commander->pauseScript());
 }
 
 TEST_F(TestDashboardCommander, ContinueScript) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("ContinueScript()"))).Times(1);
-  commander->continueScript();
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},ContinueScript();"));
+  ASSERT_NO_THROW(commander->continueScript());
 }
-*/
+
 TEST_F(TestDashboardCommander, SetCollisionLevel) {
   EXPECT_CALL(
     mock, sendCommand(
@@ -325,64 +360,109 @@ TEST_F(TestDashboardCommander, EmergencyStop) {
     Return("0,{},EmergencyStop();"));
   ASSERT_NO_THROW(
     commander->emergencyStop());
+  EXPECT_EQ(commander->getUrgentDispatchStats().count, 1u);
 }
-/*
+
 TEST_F(TestDashboardCommander, ModbusCreate) {
   EXPECT_CALL(
     mock, sendCommand(
-      StrEq("ModbusCreate(127.0.0.1,60000,1,true)"))).Times(1);
-  commander->modbusCreate("127.0.0.1", 60000, 1, 1);
+      StrEq("ModbusCreate(127.0.0.1,60000,1,1)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{2},ModbusCreate(127.0.0.1,60000,1,1);"));
+  EXPECT_EQ(commander->modbusCreate("127.0.0.1", 60000, 1, true), 2);
 }
 
 TEST_F(TestDashboardCommander, ModbusClose) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("ModbusClose(0)"))).Times(1);
-  commander->modbusClose("0");
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},ModbusClose(0);"));
+  ASSERT_NO_THROW(commander->modbusClose(0));
 }
 
 TEST_F(TestDashboardCommander, GetInBits) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("GetInBits(0,3000,5)"))).Times(1);
-  commander->getInBits(0, 3000, 5);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{1,0,0,1,1},GetInBits(0,3000,5);"));
+  EXPECT_THAT(commander->getInBits(0, 3000, 5), ElementsAre(1, 0, 0, 1, 1));
 }
 
 TEST_F(TestDashboardCommander, GetInRegs) {
   EXPECT_CALL(
     mock, sendCommand(
-      StrEq("GetInRegs(0,4000,5)"))).Times(1);
-  commander->getInRegs(0, 4000, 5, "U16");
+      StrEq("GetInRegs(0,4000,2,U16)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{12,345},GetInRegs(0,4000,2,U16);"));
+  EXPECT_THAT(commander->getInRegs(0, 4000, 2, "U16"), ElementsAre(12, 345));
+}
+
+TEST_F(TestDashboardCommander, GetHoldRegsLongType) {
+  // Not a type the controller knows, but must not overrun the command
+  const std::string val_type(200, 'U');
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("GetHoldRegs(0,3095,1," + val_type + ")"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{6000},GetHoldRegs(0,3095,1," + val_type + ");"));
+  EXPECT_THAT(commander->getHoldRegs(0, 3095, 1, val_type), ElementsAre(6000));
 }
 
 TEST_F(TestDashboardCommander, GetCoils) {
   EXPECT_CALL(
     mock, sendCommand(
-      StrEq("GetCoils(0,1000,5)"))).Times(1);
-  commander->getCoils(0, 1000, 5);
+      StrEq("GetCoils(0,1000,3)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{0,1,0},GetCoils(0,1000,3);"));
+  EXPECT_THAT(commander->getCoils(0, 1000, 3), ElementsAre(0, 1, 0));
 }
 
 TEST_F(TestDashboardCommander, SetCoils) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("SetCoils(0,1000,3,{1,0,1})"))).Times(1);
-  commander->setCoils(0, 1000, 3, "1,0,1");
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},SetCoils(0,1000,3,{1,0,1});"));
+  ASSERT_NO_THROW(commander->setCoils(0, 1000, {1, 0, 1}));
 }
 
 TEST_F(TestDashboardCommander, GetHoldRegs) {
   EXPECT_CALL(
     mock, sendCommand(
-      StrEq("GetHoldRegs(0,3095,1)"))).Times(1);
-  commander->getHoldRegs(0, 3095, 1, "U16");
+      StrEq("GetHoldRegs(0,3095,1,U16)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{6000},GetHoldRegs(0,3095,1,U16);"));
+  EXPECT_THAT(commander->getHoldRegs(0, 3095, 1), ElementsAre(6000));
 }
 
 TEST_F(TestDashboardCommander, SetHoldRegs) {
   EXPECT_CALL(
     mock, sendCommand(
       StrEq("SetHoldRegs(0,3095,2,{6000,300},U16)"))).Times(1);
-  commander->setHoldRegs(0, 3095, 2, "6000,300", "U16");
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},SetHoldRegs(0,3095,2,{6000,300},U16);"));
+  ASSERT_NO_THROW(commander->setHoldRegs(0, 3095, {6000, 300}, "U16"));
 }
-*/
+
+TEST_F(TestDashboardCommander, ModbusError) {
+  EXPECT_CALL(mock, sendCommand).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("-1,{},GetHoldRegs(0,3095,1,U16);"));
+  EXPECT_THROW(commander->getHoldRegs(0, 3095, 1), std::runtime_error);
+}
+
 TEST_F(TestDashboardCommander, DI) {
   EXPECT_CALL(
     mock, sendCommand(
@@ -410,3 +490,433 @@ TEST_F(TestDashboardCommander, GetErrorID) {
   ASSERT_TRUE(ret.at(4).empty());
   ASSERT_TRUE(ret.at(5).empty());
 }
+
+TEST_F(TestDashboardCommander, EnableRobotWithCallback) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("EnableRobot()"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{},EnableRobot();"));
+
+  std::promise<void> done;
+  commander->enableRobot(
+    [&done](std::future<void> result) {
+      try {
+        result.get();
+        done.set_value();
+      } catch (...) {
+        done.set_exception(std::current_exception());
+      }
+    });
+  ASSERT_NO_THROW(done.get_future().get());
+}
+
+TEST_F(TestDashboardCommander, RobotModeWithCallback) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("RobotMode()"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("0,{5},RobotMode();"));
+
+  std::promise<uint64_t> mode;
+  commander->robotMode(
+    [&mode](std::future<uint64_t> result) {
+      mode.set_value(result.get());
+    });
+  ASSERT_EQ(mode.get_future().get(), mg400_msgs::msg::RobotMode::ENABLE);
+}
+
+TEST_F(TestDashboardCommander, CallbackReceivesError) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("ClearError()"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillOnce(
+    Return("-1,{},ClearError();"));
+
+  std::promise<bool> threw;
+  commander->clearError(
+    [&threw](std::future<void> result) {
+      try {
+        result.get();
+        threw.set_value(false);
+      } catch (const std::runtime_error &) {
+        threw.set_value(true);
+      }
+    });
+  ASSERT_TRUE(threw.get_future().get());
+}
+
+TEST_F(TestDashboardCommander, CallbackReceivesTimeout) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("GetErrorID()"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse()).WillRepeatedly(
+    Return(""));
+
+  std::promise<bool> threw;
+  commander->getErrorId(
+    [&threw](std::future<std::array<std::vector<int>, 6>> result) {
+      try {
+        result.get();
+        threw.set_value(false);
+      } catch (const std::runtime_error &) {
+        threw.set_value(true);
+      }
+    });
+  ASSERT_TRUE(threw.get_future().get());
+  // Destroy the commander first: its I/O thread keeps polling the mock
+  commander.reset();
+}
+
+// Echoes every command back as a successful response, in the order sent
+class EchoRobot
+{
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::string> responses_;
+  std::atomic<int> senders_;
+
+public:
+  std::atomic<bool> overlapped;
+  std::atomic<int> sent;
+
+  EchoRobot()
+  : senders_(0), overlapped(false), sent(0) {}
+
+  void sendCommand(const std::string & cmd)
+  {
+    ++this->sent;
+    if (this->senders_.fetch_add(1) != 0) {
+      this->overlapped = true;
+    }
+    std::string value;
+    if (cmd == "RobotMode()") {
+      value = "5";
+    } else if (cmd.rfind("DI(", 0) == 0) {
+      value = std::to_string(std::stoi(cmd.substr(3)) % 2);
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->responses_.push_back("0,{" + value + "}," + cmd + ";");
+    }
+    this->cv_.notify_all();
+    this->senders_.fetch_sub(1);
+  }
+
+  std::string recvResponse()
+  {
+    using namespace std::chrono_literals;
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    if (!this->cv_.wait_for(lock, 1ms, [this] {return !this->responses_.empty();})) {
+      return "";
+    }
+    const auto response = this->responses_.front();
+    this->responses_.pop_front();
+    return response;
+  }
+};
+
+TEST_F(TestDashboardCommander, ManyThreads) {
+  using namespace std::chrono_literals;
+  constexpr int THREADS = 8;
+  constexpr int ITERATIONS = 200;
+
+  EchoRobot robot;
+  ON_CALL(mock, sendCommand(_)).WillByDefault(Invoke(&robot, &EchoRobot::sendCommand));
+  ON_CALL(mock, recvResponse()).WillByDefault(Invoke(&robot, &EchoRobot::recvResponse));
+  EXPECT_CALL(mock, sendCommand(_)).Times(::testing::AnyNumber());
+  EXPECT_CALL(mock, recvResponse()).Times(::testing::AnyNumber());
+  commander = std::make_unique<mg400_interface::DashboardCommander>(&mock, 5s);
+
+  std::atomic<int> errors(0);
+  std::atomic<int> callbacks(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back(
+      [this, t, &errors, &callbacks]() {
+        for (int i = 0; i < ITERATIONS; ++i) {
+          const int index = t * ITERATIONS + i;
+          try {
+            switch (index % 4) {
+              case 0:
+                commander->speedFactor(index % 100 + 1);
+                break;
+              case 1:
+                if (commander->robotMode() != mg400_msgs::msg::RobotMode::ENABLE) {
+                  ++errors;
+                }
+                break;
+              case 2:
+                if (commander->DI(index % 16 + 1) != (index % 16 + 1) % 2) {
+                  ++errors;
+                }
+                break;
+              default:
+                commander->DI(
+                  index % 16 + 1, [index, &errors, &callbacks](std::future<int> result) {
+                    try {
+                      if (result.get() != (index % 16 + 1) % 2) {
+                        ++errors;
+                      }
+                    } catch (const std::exception &) {
+                      ++errors;
+                    }
+                    ++callbacks;
+                  });
+                break;
+            }
+          } catch (const std::exception &) {
+            ++errors;
+          }
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (callbacks < THREADS * ITERATIONS / 4 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(callbacks.load(), THREADS * ITERATIONS / 4);
+  EXPECT_EQ(errors.load(), 0);
+  EXPECT_FALSE(robot.overlapped.load());
+  // Repeated speed factors are answered by the settings cache
+  EXPECT_EQ(
+    robot.sent.load() + static_cast<int>(commander->getSettingsCacheStats().hits),
+    THREADS * ITERATIONS);
+  // Stop the I/O thread before the mock goes away
+  commander.reset();
+}
+
+TEST_F(TestDashboardCommander, UnchangedSettingIsNotSent) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("SpeedFactor(50)"))).Times(1);
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("SpeedFactor(60)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{},SpeedFactor(50);"))
+  .WillOnce(Return("0,{},SpeedFactor(60);"));
+
+  commander->speedFactor(50);
+  commander->speedFactor(50);
+  commander->speedFactor(60);
+  commander->speedFactor(60);
+
+  std::promise<void> done;
+  commander->speedFactor(
+    60, [&done](std::future<void> result) {
+      result.get();
+      done.set_value();
+    });
+  done.get_future().get();
+
+  const auto stats = commander->getSettingsCacheStats();
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST_F(TestDashboardCommander, RejectedSettingIsNotCached) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("AccJ(20)"))).Times(2);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("-1,{},AccJ(20);"))
+  .WillOnce(Return("0,{},AccJ(20);"));
+
+  EXPECT_THROW(commander->accJ(20), std::runtime_error);
+  ASSERT_NO_THROW(commander->accJ(20));
+  EXPECT_EQ(commander->getSettingsCacheStats().hits, 0u);
+}
+
+TEST_F(TestDashboardCommander, ResetRobotInvalidatesSettings) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("Tool(1)"))).Times(2);
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("ResetRobot()"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{},Tool(1);"))
+  .WillOnce(Return("0,{},ResetRobot();"))
+  .WillOnce(Return("0,{},Tool(1);"));
+
+  commander->tool(1);
+  commander->resetRobot();
+  commander->tool(1);
+}
+
+TEST_F(TestDashboardCommander, ModeChangeInvalidatesSettings) {
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("CP(50)"))).Times(2);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{},CP(50);"))
+  .WillOnce(Return("0,{},CP(50);"));
+
+  std::atomic<uint64_t> mode_changes(1);
+  commander->setModeChangeCounter([&mode_changes]() {return mode_changes.load();});
+
+  commander->cp(50);
+  commander->cp(50);
+  ++mode_changes;
+  commander->cp(50);
+  EXPECT_EQ(commander->getSettingsCacheStats().hits, 1u);
+}
+
+static mg400_interface::RealtimeFeedbackTcpInterface::Snapshot makeFeedback(
+  const std::chrono::nanoseconds age)
+{
+  mg400_interface::RealtimeFeedbackTcpInterface::Snapshot snapshot = {};
+  snapshot.active = true;
+  snapshot.robot_mode = mg400_msgs::msg::RobotMode::RUNNING;
+  snapshot.digital_inputs = 0b101;
+  for (int i = 0; i < 6; ++i) {
+    snapshot.q_actual[i] = 10.0 * (i + 1);
+    snapshot.tool_vector[i] = 100.0 * (i + 1);
+  }
+  snapshot.stamp_ns = (std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()) - age).count();
+  return snapshot;
+}
+
+TEST_F(TestDashboardCommander, QueriesAnsweredFromFeedback) {
+  using namespace std::chrono_literals;
+  EXPECT_CALL(mock, sendCommand(_)).Times(0);
+  commander->setFeedbackSource([]() {return makeFeedback(1ms);}, 50ms);
+
+  EXPECT_EQ(commander->robotMode(), mg400_msgs::msg::RobotMode::RUNNING);
+  EXPECT_EQ(commander->DI(1), 1);
+  EXPECT_EQ(commander->DI(2), 0);
+  EXPECT_EQ(commander->DI(3), 1);
+
+  const auto angles = commander->getAngle();
+  ASSERT_EQ(angles.size(), 6u);
+  EXPECT_DOUBLE_EQ(angles[0], 10.0 * M_PI / 180.0);
+  EXPECT_DOUBLE_EQ(angles[5], 60.0 * M_PI / 180.0);
+
+  const auto poses = commander->getPose();
+  ASSERT_EQ(poses.size(), 6u);
+  EXPECT_DOUBLE_EQ(poses[0], 0.1);
+  EXPECT_DOUBLE_EQ(poses[2], 0.3);
+
+  std::promise<std::vector<double>> pose;
+  commander->getPose(
+    [&pose](std::future<std::vector<double>> result) {
+      pose.set_value(result.get());
+    });
+  EXPECT_EQ(pose.get_future().get(), poses);
+}
+
+TEST_F(TestDashboardCommander, StaleFeedbackFallsBackToDashboard) {
+  using namespace std::chrono_literals;
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("RobotMode()"))).Times(1);
+  EXPECT_CALL(
+    mock, sendCommand(
+      StrEq("DI(1)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{5},RobotMode();"))
+  .WillOnce(Return("0,{0},DI(1);"));
+
+  commander->setFeedbackSource([]() {return makeFeedback(100ms);}, 50ms);
+  EXPECT_EQ(commander->robotMode(), mg400_msgs::msg::RobotMode::ENABLE);
+
+  // Inactive feedback is never used, however recent
+  commander->setFeedbackSource(
+    []() {
+      auto snapshot = makeFeedback(0ms);
+      snapshot.active = false;
+      return snapshot;
+    }, 50ms);
+  EXPECT_EQ(commander->DI(1), 0);
+}
+
+TEST_F(TestDashboardCommander, SendBatch) {
+  using namespace std::chrono_literals;
+  commander = std::make_unique<mg400_interface::DashboardCommander>(&mock, 1s);
+  EXPECT_CALL(mock, sendCommand(_)).Times(0);
+  EXPECT_CALL(
+    mock, sendCommands(
+      ElementsAre("Tool(1)", "SpeedFactor(50)", "DO(1,1)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{},Tool(1);"))
+  .WillOnce(Return("-1,{},SpeedFactor(50);"))
+  .WillOnce(Return("0,{},DO(1,1);"));
+
+  const auto results = commander->sendBatch({"Tool(1)", "SpeedFactor(50)", "DO(1,1)"});
+  ASSERT_EQ(results.size(), 3u);
+  EXPECT_TRUE(results[0].ok);
+  EXPECT_EQ(results[0].response, "0,{},Tool(1);");
+  EXPECT_FALSE(results[1].ok);
+  EXPECT_FALSE(results[1].error.empty());
+  EXPECT_TRUE(results[2].ok);
+
+  // Only the accepted setting is cached
+  commander->tool(1);
+  EXPECT_EQ(commander->getSettingsCacheStats().hits, 1u);
+}
+
+TEST_F(TestDashboardCommander, SendBatchWithCallback) {
+  using namespace std::chrono_literals;
+  commander = std::make_unique<mg400_interface::DashboardCommander>(&mock, 1s);
+  EXPECT_CALL(
+    mock, sendCommands(
+      ElementsAre("AccJ(50)", "CP(20)"))).Times(1);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{},AccJ(50);"))
+  .WillOnce(Return("0,{},CP(20);"))
+  .WillRepeatedly(Return(""));
+
+  std::promise<std::vector<mg400_interface::DashboardCommander::BatchResult>> results;
+  commander->sendBatch(
+    {"AccJ(50)", "CP(20)"},
+    [&results](std::vector<mg400_interface::DashboardCommander::BatchResult> result) {
+      results.set_value(result);
+    });
+  const auto result = results.get_future().get();
+  ASSERT_EQ(result.size(), 2u);
+  EXPECT_TRUE(result[0].ok);
+  EXPECT_TRUE(result[1].ok);
+  commander.reset();
+}
+
+TEST_F(TestDashboardCommander, LatencyStats) {
+  EXPECT_CALL(mock, sendCommand(_)).Times(3);
+  EXPECT_CALL(
+    mock, recvResponse())
+  .WillOnce(Return("0,{},EnableRobot();"))
+  .WillOnce(Return("-1,{},EnableRobot();"))
+  .WillRepeatedly(Return(""));
+
+  ASSERT_NO_THROW(commander->enableRobot());
+  EXPECT_THROW(commander->enableRobot(), std::runtime_error);
+  // Never answered within the 1 ms timeout
+  EXPECT_THROW(commander->getErrorId(), std::runtime_error);
+
+  const auto stats = commander->getLatencyStats();
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[0].first, "EnableRobot");
+  EXPECT_EQ(stats[0].second.count, 2u);
+  EXPECT_EQ(stats[0].second.errors, 1u);
+  EXPECT_EQ(stats[0].second.timeouts, 0u);
+  EXPECT_EQ(stats[1].first, "GetErrorID");
+  EXPECT_EQ(stats[1].second.count, 0u);
+  EXPECT_EQ(stats[1].second.timeouts, 1u);
+}
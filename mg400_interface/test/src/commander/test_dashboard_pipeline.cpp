@@ -0,0 +1,308 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/commander/dashboard_pipeline.hpp>
+
+using ::testing::InSequence;
+using ::testing::Return;
+using ::testing::StrEq;
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::DashboardPipeline;
+
+class MockTcpInterface : public mg400_interface::DashboardTcpInterfaceBase
+{
+public:
+  MockTcpInterface()
+  : mg400_interface::DashboardTcpInterfaceBase() {}
+
+  MOCK_METHOD(void, sendCommand, (const std::string &), (override));
+  MOCK_METHOD(std::string, recvResponse, (), (override));
+};
+
+// Connected again between requests
+class ReconnectingTcpInterface : public MockTcpInterface
+{
+public:
+  std::atomic<uint64_t> connections{1};
+
+  uint64_t countConnections() override {return this->connections.load();}
+};
+
+// Answers every command in order after a fixed delay, like the controller
+class EchoTcpInterface : public mg400_interface::DashboardTcpInterfaceBase
+{
+private:
+  std::mutex mutex_;
+  std::deque<std::string> responses_;
+
+public:
+  void sendCommand(const std::string & command) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->responses_.push_back("0,{}," + command + ";");
+  }
+
+  std::string recvResponse() override
+  {
+    std::this_thread::sleep_for(100us);
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->responses_.empty()) {
+      return "";
+    }
+    const auto response = this->responses_.front();
+    this->responses_.pop_front();
+    return response;
+  }
+};
+
+// Holds the first write until opened, as if the socket buffer were full
+class GatedTcpInterface : public mg400_interface::DashboardTcpInterfaceBase
+{
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool is_open_ = false;
+  bool is_held_ = false;
+
+public:
+  std::vector<std::string> sent;
+
+  void sendCommand(const std::string & command) override
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->sent.push_back(command);
+    if (this->sent.size() == 1) {
+      this->is_held_ = true;
+      this->cv_.notify_all();
+      this->cv_.wait(lock, [this] {return this->is_open_;});
+    }
+  }
+
+  std::string recvResponse() override {return "";}
+
+  void waitHeld()
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->cv_.wait(lock, [this] {return this->is_held_;});
+  }
+
+  void open()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->is_open_ = true;
+    this->cv_.notify_all();
+  }
+};
+
+class TestDashboardPipeline : public ::testing::Test
+{
+protected:
+  MockTcpInterface mock;
+  std::unique_ptr<DashboardPipeline> pipeline;
+
+  virtual void SetUp()
+  {
+    this->pipeline = std::make_unique<DashboardPipeline>(&this->mock);
+  }
+
+  static DashboardPipeline::SteadyClock::time_point deadline()
+  {
+    return DashboardPipeline::SteadyClock::now() + 100ms;
+  }
+};
+
+TEST_F(TestDashboardPipeline, TakeFunctionName) {
+  EXPECT_EQ(DashboardPipeline::takeFunctionName("SpeedFactor(50)"), "SpeedFactor");
+  EXPECT_EQ(DashboardPipeline::takeFunctionName("GetPose()"), "GetPose");
+  EXPECT_EQ(DashboardPipeline::takeFunctionName("GetPose"), "GetPose");
+}
+
+TEST_F(TestDashboardPipeline, ResponsesAreMatchedInOrder) {
+  {
+    InSequence seq;
+    EXPECT_CALL(mock, sendCommand(StrEq("SpeedFactor(50)"))).Times(1);
+    EXPECT_CALL(mock, sendCommand(StrEq("DI(1)"))).Times(1);
+    EXPECT_CALL(mock, sendCommand(StrEq("DI(2)"))).Times(1);
+  }
+  EXPECT_CALL(mock, recvResponse())
+  .WillOnce(Return("0,{},SpeedFactor(50);"))
+  .WillOnce(Return("0,{1},DI(1);"))
+  .WillOnce(Return("0,{0},DI(2);"));
+
+  // All sent before the first response is read
+  const auto speed = pipeline->submit("SpeedFactor(50)");
+  const auto di1 = pipeline->submit("DI(1)");
+  const auto di2 = pipeline->submit("DI(2)");
+  EXPECT_EQ(pipeline->countInFlight(), 3u);
+
+  EXPECT_EQ(pipeline->wait(speed, deadline()), "0,{},SpeedFactor(50);");
+  EXPECT_EQ(pipeline->wait(di1, deadline()), "0,{1},DI(1);");
+  EXPECT_EQ(pipeline->wait(di2, deadline()), "0,{0},DI(2);");
+  EXPECT_EQ(pipeline->countInFlight(), 0u);
+}
+
+TEST_F(TestDashboardPipeline, WaitingCompletesEarlierRequests) {
+  EXPECT_CALL(mock, sendCommand).Times(2);
+  EXPECT_CALL(mock, recvResponse())
+  .WillOnce(Return("0,{},User(1);"))
+  .WillOnce(Return("0,{},Tool(1);"));
+
+  const auto user = pipeline->submit("User(1)");
+  const auto tool = pipeline->submit("Tool(1)");
+
+  EXPECT_EQ(pipeline->wait(tool, deadline()), "0,{},Tool(1);");
+  // Already received while waiting for Tool(1)
+  EXPECT_EQ(pipeline->wait(user, deadline()), "0,{},User(1);");
+}
+
+TEST_F(TestDashboardPipeline, SkippedResponseFailsRequest) {
+  EXPECT_CALL(mock, sendCommand).Times(2);
+  EXPECT_CALL(mock, recvResponse())
+  .WillOnce(Return("0,{},ClearError();"));
+
+  const auto enable = pipeline->submit("EnableRobot()");
+  const auto clear = pipeline->submit("ClearError()");
+
+  EXPECT_EQ(pipeline->wait(clear, deadline()), "0,{},ClearError();");
+  EXPECT_THROW(pipeline->wait(enable, deadline()), std::runtime_error);
+}
+
+TEST_F(TestDashboardPipeline, UnexpectedResponseIsIgnored) {
+  EXPECT_CALL(mock, sendCommand).Times(1);
+  EXPECT_CALL(mock, recvResponse())
+  .WillOnce(Return("0,{},EnableRobot();"))
+  .WillOnce(Return("not a response"))
+  .WillOnce(Return("99999999999,{},RobotMode();"))
+  .WillOnce(Return("0,{5},RobotMode();"));
+
+  const auto mode = pipeline->submit("RobotMode()");
+  EXPECT_EQ(pipeline->wait(mode, deadline()), "0,{5},RobotMode();");
+}
+
+TEST_F(TestDashboardPipeline, LateResponseIsNotTakenForNextRequest) {
+  EXPECT_CALL(mock, sendCommand).Times(2);
+  EXPECT_CALL(mock, recvResponse())
+  .WillOnce(Return(""))
+  .WillOnce(Return("0,{1},DI(1);"))
+  .WillOnce(Return("0,{0},DI(1);"));
+
+  const auto first = pipeline->submit("DI(1)");
+  EXPECT_THROW(
+    pipeline->wait(first, DashboardPipeline::SteadyClock::now()), std::runtime_error);
+  EXPECT_EQ(pipeline->countInFlight(), 1u);
+
+  const auto second = pipeline->submit("DI(1)");
+  EXPECT_EQ(pipeline->wait(second, deadline()), "0,{0},DI(1);");
+}
+
+TEST_F(TestDashboardPipeline, ReceiveErrorFailsEveryRequest) {
+  EXPECT_CALL(mock, sendCommand).Times(2);
+  EXPECT_CALL(mock, recvResponse())
+  .WillOnce(::testing::Throw(std::runtime_error("connection closed")));
+
+  const auto enable = pipeline->submit("EnableRobot()");
+  const auto mode = pipeline->submit("RobotMode()");
+  EXPECT_THROW(pipeline->wait(mode, deadline()), std::runtime_error);
+  EXPECT_EQ(pipeline->countInFlight(), 0u);
+  // Failed without receiving again
+  EXPECT_THROW(pipeline->wait(enable, deadline()), std::runtime_error);
+}
+
+TEST(TestDashboardPipelineReconnect, StaleRequestsFailOnReconnect) {
+  ReconnectingTcpInterface tcp_if;
+  DashboardPipeline pipeline(&tcp_if);
+  EXPECT_CALL(tcp_if, sendCommand).Times(2);
+  EXPECT_CALL(tcp_if, recvResponse())
+  .WillOnce(Return(""))
+  .WillOnce(Return("0,{0},DI(1);"));
+
+  const auto first = pipeline.submit("DI(1)");
+  EXPECT_THROW(
+    pipeline.wait(first, DashboardPipeline::SteadyClock::now()), std::runtime_error);
+  EXPECT_EQ(pipeline.countInFlight(), 1u);
+
+  // Never answered on the new connection
+  tcp_if.connections.store(2);
+  const auto second = pipeline.submit("DI(1)");
+  EXPECT_EQ(pipeline.countInFlight(), 1u);
+  EXPECT_EQ(
+    pipeline.wait(second, DashboardPipeline::SteadyClock::now() + 100ms), "0,{0},DI(1);");
+}
+
+TEST(TestDashboardPipelineConcurrency, ConcurrentCallers) {
+  EchoTcpInterface echo;
+  DashboardPipeline pipeline(&echo);
+
+  std::vector<std::thread> callers;
+  std::atomic<int> mismatches(0);
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back(
+      [&pipeline, &mismatches, i]() {
+        for (int j = 0; j < 100; ++j) {
+          const std::string command = "DO(" + std::to_string(i) + "," + std::to_string(j) + ")";
+          const auto request = pipeline.submit(command);
+          const auto response =
+          pipeline.wait(request, DashboardPipeline::SteadyClock::now() + 1s);
+          if (response != "0,{}," + command + ";") {
+            mismatches.fetch_add(1);
+          }
+        }
+      });
+  }
+  for (auto & caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+  EXPECT_EQ(pipeline.countInFlight(), 0u);
+}
+
+TEST(TestDashboardPipelineConcurrency, UrgentRequestSkipsQueue) {
+  GatedTcpInterface gated;
+  DashboardPipeline pipeline(&gated);
+
+  std::thread sender([&pipeline]() {pipeline.submit("SpeedFactor(10)");});
+  gated.waitHeld();
+
+  // Queued behind the write in progress
+  pipeline.submit("GetPose()");
+  pipeline.submit("GetAngle()");
+  pipeline.submit("EmergencyStop()", DashboardPipeline::Priority::URGENT);
+  EXPECT_EQ(pipeline.getUrgentDispatchStats().count, 0u);
+
+  gated.open();
+  sender.join();
+
+  const std::vector<std::string> expected =
+  {"SpeedFactor(10)", "EmergencyStop()", "GetPose()", "GetAngle()"};
+  EXPECT_EQ(gated.sent, expected);
+  // Responses are matched in the order written
+  EXPECT_EQ(pipeline.countInFlight(), 4u);
+
+  const auto stats = pipeline.getUrgentDispatchStats();
+  EXPECT_EQ(stats.count, 1u);
+  EXPECT_EQ(stats.last, stats.max);
+  EXPECT_GT(stats.last, DashboardPipeline::SteadyClock::duration::zero());
+}
@@ -0,0 +1,123 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/commander/latency_stats.hpp>
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::LatencyHistogram;
+using mg400_interface::LatencyStats;
+
+TEST(TestLatencyHistogram, BucketsCoverEveryValue) {
+  // Exact below 8 us
+  for (uint64_t us = 0; us < 8; ++us) {
+    EXPECT_EQ(LatencyHistogram::toIndex(us), us);
+    EXPECT_EQ(LatencyHistogram::toUpperBound(us), us);
+  }
+
+  // Contiguous, and never more than 12.5% wide
+  uint64_t lower = 0;
+  for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+    const uint64_t upper = LatencyHistogram::toUpperBound(i);
+    EXPECT_EQ(LatencyHistogram::toIndex(lower), i);
+    EXPECT_EQ(LatencyHistogram::toIndex(upper), i);
+    EXPECT_LE(upper - lower, lower / 8);
+    lower = upper + 1;
+  }
+  EXPECT_EQ(lower, 1ull << 32);
+  EXPECT_EQ(LatencyHistogram::toIndex(1ull << 40), LatencyHistogram::BUCKETS - 1);
+}
+
+TEST(TestLatencyHistogram, Summarize) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.summarize().count, 0u);
+
+  for (int i = 0; i < 98; ++i) {
+    histogram.record(1ms);
+  }
+  histogram.record(10ms);
+  histogram.record(100ms);
+  histogram.recordTimeout();
+  histogram.recordError();
+
+  const auto summary = histogram.summarize();
+  EXPECT_EQ(summary.count, 100u);
+  EXPECT_EQ(summary.timeouts, 1u);
+  EXPECT_EQ(summary.errors, 1u);
+  EXPECT_DOUBLE_EQ(summary.mean_us, (98 * 1000 + 10000 + 100000) / 100.0);
+  EXPECT_EQ(summary.max_us, 100000u);
+  // Reported as the bucket upper bound
+  EXPECT_GE(summary.p50_us, 1000u);
+  EXPECT_LE(summary.p50_us, 1000u * 9 / 8);
+  EXPECT_EQ(summary.p90_us, summary.p50_us);
+  EXPECT_GE(summary.p99_us, 10000u);
+  EXPECT_LE(summary.p99_us, 10000u * 9 / 8);
+  ASSERT_EQ(summary.buckets.size(), 3u);
+  EXPECT_EQ(summary.buckets[0].second, 98u);
+  EXPECT_EQ(summary.buckets[2].first, LatencyHistogram::toUpperBound(
+      LatencyHistogram::toIndex(100000)));
+}
+
+TEST(TestLatencyStats, PerFunction) {
+  LatencyStats stats;
+  stats.get("GetPose").record(2ms);
+  stats.get("EnableRobot").record(3ms);
+  stats.get("GetPose").record(4ms);
+  EXPECT_EQ(&stats.get("GetPose"), &stats.get("GetPose"));
+
+  const auto summaries = stats.summarize();
+  ASSERT_EQ(summaries.size(), 2u);
+  EXPECT_EQ(summaries[0].first, "EnableRobot");
+  EXPECT_EQ(summaries[0].second.count, 1u);
+  EXPECT_EQ(summaries[1].first, "GetPose");
+  EXPECT_EQ(summaries[1].second.count, 2u);
+}
+
+TEST(TestLatencyStats, OverflowGoesToOthers) {
+  LatencyStats stats;
+  for (size_t i = 0; i < LatencyStats::CAPACITY + 2; ++i) {
+    stats.get("Function" + std::to_string(i)).record(1ms);
+  }
+  const auto summaries = stats.summarize();
+  ASSERT_EQ(summaries.size(), LatencyStats::CAPACITY + 1);
+  EXPECT_EQ(summaries[0].first, LatencyStats::OTHERS);
+  EXPECT_EQ(summaries[0].second.count, 2u);
+}
+
+TEST(TestLatencyStats, ConcurrentRecording) {
+  LatencyStats stats;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back(
+      [&stats]() {
+        for (int j = 0; j < 1000; ++j) {
+          stats.get("DO" + std::to_string(j % 10)).record(std::chrono::microseconds(j));
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  const auto summaries = stats.summarize();
+  ASSERT_EQ(summaries.size(), 10u);
+  for (const auto & summary : summaries) {
+    EXPECT_EQ(summary.second.count, 400u);
+  }
+}
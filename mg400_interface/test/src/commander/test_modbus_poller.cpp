@@ -0,0 +1,329 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/commander/modbus_poller.hpp>
+
+using ::testing::ElementsAre;
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::ModbusPoller;
+using Table = ModbusPoller::Table;
+
+// Dashboard server with a Modbus device behind it, answering like the controller
+class ModbusEmulator : public mg400_interface::DashboardTcpInterfaceBase
+{
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::string> responses_;
+  std::array<std::map<int, int>, 4> tables_;
+  bool is_held_ = false;
+
+public:
+  size_t writes = 0;
+  size_t reads = 0;
+  int max_count = 4;
+
+  void set(const Table table, const int addr, const int value)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->tables_[static_cast<size_t>(table)][addr] = value;
+  }
+
+  // Responses are held back until release()
+  void hold()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->is_held_ = true;
+  }
+
+  void release()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->is_held_ = false;
+    this->cv_.notify_all();
+  }
+
+  void sendCommand(const std::string & command) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    ++this->writes;
+    this->responses_.push_back(this->execute(command));
+  }
+
+  void sendCommands(const std::vector<std::string> & commands) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    ++this->writes;
+    for (const auto & command : commands) {
+      this->responses_.push_back(this->execute(command));
+    }
+  }
+
+  std::string recvResponse() override
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->cv_.wait_for(lock, 100ms, [this] {return !this->is_held_;});
+    if (this->is_held_ || this->responses_.empty()) {
+      lock.unlock();
+      std::this_thread::sleep_for(100us);
+      return "";
+    }
+    const auto response = this->responses_.front();
+    this->responses_.pop_front();
+    return response;
+  }
+
+private:
+  std::string execute(const std::string & command)
+  {
+    const auto open = command.find('(');
+    const auto function = command.substr(0, open);
+    std::vector<std::string> args;
+    std::stringstream ss(command.substr(open + 1, command.rfind(')') - open - 1));
+    std::string arg;
+    while (std::getline(ss, arg, ',')) {
+      args.push_back(arg);
+    }
+
+    if (function == "ModbusCreate") {
+      return "0,{3}," + command + ";";
+    }
+    if (function == "ModbusClose") {
+      return "0,{}," + command + ";";
+    }
+
+    Table table;
+    if (function == "GetCoils") {
+      table = Table::COIL;
+    } else if (function == "GetInBits") {
+      table = Table::DISCRETE_INPUT;
+    } else if (function == "GetInRegs") {
+      table = Table::INPUT_REGISTER;
+    } else if (function == "GetHoldRegs") {
+      table = Table::HOLDING_REGISTER;
+    } else {
+      return "-1,{}," + command + ";";
+    }
+    ++this->reads;
+
+    const int index = std::stoi(args.at(0));
+    const int addr = std::stoi(args.at(1));
+    const int count = std::stoi(args.at(2));
+    if (index != 3 || count > this->max_count) {
+      return "-1,{}," + command + ";";
+    }
+    std::string values;
+    for (int i = 0; i < count; ++i) {
+      const auto & registers = this->tables_[static_cast<size_t>(table)];
+      const auto it = registers.find(addr + i);
+      values += (i > 0 ? "," : "") + std::to_string(it == registers.end() ? 0 : it->second);
+    }
+    return "0,{" + values + "}," + command + ";";
+  }
+};
+
+class TestModbusPoller : public ::testing::Test
+{
+protected:
+  ModbusEmulator emulator;
+  std::unique_ptr<mg400_interface::DashboardCommander> commander;
+  std::unique_ptr<ModbusPoller> poller;
+
+  virtual void SetUp()
+  {
+    this->commander =
+      std::make_unique<mg400_interface::DashboardCommander>(&this->emulator, 1s);
+    this->poller = std::make_unique<ModbusPoller>(
+      this->commander.get(), ModbusPoller::Limits{2, 4, 4});
+  }
+
+  virtual void TearDown()
+  {
+    this->poller.reset();
+  }
+};
+
+TEST(TestModbusPollerPlan, MergesAdjacentRanges) {
+  const auto reads = ModbusPoller::plan(
+    {{Table::HOLDING_REGISTER, 12, 2},
+      {Table::COIL, 0, 2},
+      {Table::HOLDING_REGISTER, 10, 2},
+      {Table::COIL, 1, 3},
+      {Table::COIL, 20, 1}},
+    {0, 64, 64});
+
+  ASSERT_EQ(reads.size(), 3u);
+  EXPECT_EQ(reads[0].table, Table::COIL);
+  EXPECT_EQ(reads[0].addr, 0);
+  EXPECT_EQ(reads[0].count, 4);
+  EXPECT_EQ(reads[1].table, Table::COIL);
+  EXPECT_EQ(reads[1].addr, 20);
+  EXPECT_EQ(reads[1].count, 1);
+  EXPECT_EQ(reads[2].table, Table::HOLDING_REGISTER);
+  EXPECT_EQ(reads[2].addr, 10);
+  EXPECT_EQ(reads[2].count, 4);
+}
+
+TEST(TestModbusPollerPlan, BridgesGapsAndSplitsAtLimit) {
+  const std::vector<ModbusPoller::Range> ranges =
+  {{Table::INPUT_REGISTER, 0, 1}, {Table::INPUT_REGISTER, 3, 1}, {Table::INPUT_REGISTER, 9, 1}};
+
+  // Separate tables are never merged, and gaps are only bridged if allowed
+  EXPECT_EQ(ModbusPoller::plan(ranges, {0, 64, 64}).size(), 3u);
+
+  const auto bridged = ModbusPoller::plan(ranges, {2, 64, 64});
+  ASSERT_EQ(bridged.size(), 2u);
+  EXPECT_EQ(bridged[0].addr, 0);
+  EXPECT_EQ(bridged[0].count, 4);
+  EXPECT_EQ(bridged[1].addr, 9);
+
+  const auto split = ModbusPoller::plan({{Table::DISCRETE_INPUT, 100, 10}}, {0, 4, 64});
+  ASSERT_EQ(split.size(), 3u);
+  EXPECT_EQ(split[0].addr, 100);
+  EXPECT_EQ(split[0].count, 4);
+  EXPECT_EQ(split[1].addr, 104);
+  EXPECT_EQ(split[1].count, 4);
+  EXPECT_EQ(split[2].addr, 108);
+  EXPECT_EQ(split[2].count, 2);
+}
+
+TEST(TestModbusPollerPlan, ToCommand) {
+  EXPECT_EQ(ModbusPoller::toCommand(0, {Table::COIL, 1000, 3}), "GetCoils(0,1000,3)");
+  EXPECT_EQ(ModbusPoller::toCommand(1, {Table::DISCRETE_INPUT, 5, 2}), "GetInBits(1,5,2)");
+  EXPECT_EQ(
+    ModbusPoller::toCommand(0, {Table::INPUT_REGISTER, 4000, 2}), "GetInRegs(0,4000,2,U16)");
+  EXPECT_EQ(
+    ModbusPoller::toCommand(2, {Table::HOLDING_REGISTER, 3095, 1}), "GetHoldRegs(2,3095,1,U16)");
+}
+
+TEST_F(TestModbusPoller, PollBeforeOpenThrows) {
+  poller->addRange(Table::COIL, 0, 1);
+  EXPECT_THROW(poller->poll(), std::runtime_error);
+  EXPECT_THROW(poller->poll([](std::vector<ModbusPoller::Change>) {}), std::runtime_error);
+}
+
+TEST_F(TestModbusPoller, ReportsOnlyChanges) {
+  poller->addRange(Table::COIL, 0, 2);
+  poller->addRange(Table::COIL, 2, 2);
+  poller->addRange(Table::HOLDING_REGISTER, 100, 1);
+  poller->addRange(Table::HOLDING_REGISTER, 103, 1);
+  emulator.set(Table::COIL, 1, 1);
+  emulator.set(Table::HOLDING_REGISTER, 100, 6000);
+  emulator.set(Table::HOLDING_REGISTER, 103, 300);
+
+  poller->open("192.168.1.10", 502, 1);
+  EXPECT_TRUE(poller->isOpen());
+  const size_t writes = emulator.writes;
+
+  // Everything is new on the first poll
+  auto changes = poller->poll();
+  ASSERT_EQ(changes.size(), 2u);
+  EXPECT_EQ(changes[0].table, Table::COIL);
+  EXPECT_THAT(changes[0].addresses, ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(changes[0].values, ElementsAre(0, 1, 0, 0));
+  EXPECT_EQ(changes[1].table, Table::HOLDING_REGISTER);
+  EXPECT_THAT(changes[1].addresses, ElementsAre(100, 103));
+  EXPECT_THAT(changes[1].values, ElementsAre(6000, 300));
+  // One read per table, written at once
+  EXPECT_EQ(emulator.reads, 2u);
+  EXPECT_EQ(emulator.writes, writes + 1);
+
+  EXPECT_TRUE(poller->poll().empty());
+
+  // Bridged but unregistered addresses are never reported
+  emulator.set(Table::HOLDING_REGISTER, 101, 1);
+  emulator.set(Table::HOLDING_REGISTER, 103, 301);
+  changes = poller->poll();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_THAT(changes[0].addresses, ElementsAre(103));
+  EXPECT_THAT(changes[0].values, ElementsAre(301));
+
+  const auto stats = poller->getStats();
+  EXPECT_EQ(stats.polls, 3u);
+  EXPECT_EQ(stats.reads, 6u);
+  EXPECT_EQ(stats.failures, 0u);
+}
+
+TEST_F(TestModbusPoller, FailedReadKeepsLastValues) {
+  poller->addRange(Table::INPUT_REGISTER, 0, 2);
+  poller->addRange(Table::DISCRETE_INPUT, 0, 1);
+  emulator.set(Table::INPUT_REGISTER, 1, 7);
+  poller->open("192.168.1.10", 502, 1);
+  EXPECT_EQ(poller->poll().size(), 2u);
+
+  // Refused from now on: nothing to report, nothing forgotten
+  emulator.max_count = 1;
+  emulator.set(Table::INPUT_REGISTER, 1, 8);
+  const auto changes = poller->poll();
+  ASSERT_EQ(changes.size(), 0u);
+  EXPECT_EQ(poller->getStats().failures, 1u);
+
+  emulator.max_count = 4;
+  const auto recovered = poller->poll();
+  ASSERT_EQ(recovered.size(), 1u);
+  EXPECT_THAT(recovered[0].addresses, ElementsAre(1));
+  EXPECT_THAT(recovered[0].values, ElementsAre(8));
+}
+
+TEST_F(TestModbusPoller, ReopenReportsEverythingAgain) {
+  poller->addRange(Table::COIL, 5, 1);
+  poller->open("192.168.1.10", 502, 1);
+  EXPECT_EQ(poller->poll().size(), 1u);
+  EXPECT_TRUE(poller->poll().empty());
+
+  poller->open("192.168.1.10", 502, 1);
+  EXPECT_EQ(poller->poll().size(), 1u);
+
+  poller->close();
+  EXPECT_FALSE(poller->isOpen());
+}
+
+TEST_F(TestModbusPoller, AsyncPollSkipsWhileInFlight) {
+  poller->addRange(Table::HOLDING_REGISTER, 0, 1);
+  emulator.set(Table::HOLDING_REGISTER, 0, 42);
+  poller->open("192.168.1.10", 502, 1);
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::vector<ModbusPoller::Change>> received;
+  const auto callback = [&](std::vector<ModbusPoller::Change> changes) {
+      std::lock_guard<std::mutex> lock(mutex);
+      received.push_back(std::move(changes));
+      cv.notify_all();
+    };
+
+  emulator.hold();
+  EXPECT_TRUE(poller->poll(callback));
+  EXPECT_FALSE(poller->poll(callback));
+  EXPECT_EQ(poller->getStats().skipped, 1u);
+  emulator.release();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(cv.wait_for(lock, 1s, [&] {return !received.empty();}));
+  ASSERT_EQ(received.front().size(), 1u);
+  EXPECT_THAT(received.front()[0].values, ElementsAre(42));
+}
@@ -73,6 +73,34 @@ TEST_F(TestMotionCommander, JointMovJ)
   commander->jointMovJ(M_PI_2, M_PI_2, M_PI_2, M_PI_2, M_PI_2, M_PI_2);
 }
 
+TEST_F(TestMotionCommander, MovJCP)
+{
+  EXPECT_CALL(
+    mock, sendCommand(StrEq("MovJ(1.000,2.000,3.000,90.000,CP=50)"))).Times(1);
+  commander->movJCP(1.0e-3, 2.0e-3, 3.0e-3, M_PI_2, 50);
+}
+
+TEST_F(TestMotionCommander, MovLCP)
+{
+  EXPECT_CALL(
+    mock, sendCommand(StrEq("MovL(1.000,2.000,3.000,90.000,CP=0)"))).Times(1);
+  commander->movLCP(1.0e-3, 2.0e-3, 3.0e-3, M_PI_2, 0);
+}
+
+TEST_F(TestMotionCommander, ServoJ)
+{
+  EXPECT_CALL(
+    mock, sendCommand(StrEq("ServoJ(90.000,0.000,-90.000,180.000)"))).Times(1);
+  commander->servoJ(M_PI_2, 0.0, -M_PI_2, M_PI);
+}
+
+TEST_F(TestMotionCommander, ServoP)
+{
+  EXPECT_CALL(
+    mock, sendCommand(StrEq("ServoP(300.000,-20.000,50.000,45.000)"))).Times(1);
+  commander->servoP(0.3, -0.02, 0.05, M_PI_4);
+}
+
 TEST_F(TestMotionCommander, MovLIO) {
   EXPECT_CALL(
     mock, sendCommand(
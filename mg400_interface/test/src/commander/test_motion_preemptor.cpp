@@ -0,0 +1,231 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/commander/motion_preemptor.hpp>
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::MotionPreemptor;
+using mg400_interface::RealtimeFeedbackTcpInterface;
+using mg400_msgs::msg::RobotMode;
+
+class TestMotionPreemptor : public ::testing::Test
+{
+protected:
+  std::mutex mutex_;
+  RealtimeFeedbackTcpInterface::Snapshot snapshot_;
+  std::vector<MotionPreemptor::StopCallback> stops_;
+  std::unique_ptr<MotionPreemptor> preemptor_;
+
+  virtual void SetUp()
+  {
+    this->snapshot_ = {};
+    this->snapshot_.active = true;
+    this->snapshot_.robot_mode = RobotMode::RUNNING;
+    this->preemptor_ = std::make_unique<MotionPreemptor>(
+      [this](const MotionPreemptor::StopCallback & done) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stops_.push_back(done);
+      },
+      [this]() {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->snapshot_;
+      },
+      MotionPreemptor::Config{200ms, 1ms});
+  }
+
+  // Feedback packet received now
+  void receive(const uint64_t mode)
+  {
+    std::this_thread::sleep_for(1ms);
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->snapshot_.robot_mode = mode;
+    this->snapshot_.stamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  void accept(const size_t index, const bool is_accepted = true)
+  {
+    MotionPreemptor::StopCallback done;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      ASSERT_LT(index, this->stops_.size());
+      done = this->stops_[index];
+    }
+    done(is_accepted);
+  }
+
+  size_t countStops()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->stops_.size();
+  }
+};
+
+TEST_F(TestMotionPreemptor, FirstGoalDoesNotStop) {
+  const auto goal_a = this->preemptor_->acquire();
+  EXPECT_TRUE(this->preemptor_->isOwner(goal_a));
+  EXPECT_TRUE(this->preemptor_->waitForStop(goal_a));
+  EXPECT_EQ(this->countStops(), 0u);
+
+  this->preemptor_->release(goal_a);
+  EXPECT_FALSE(this->preemptor_->isOwner(goal_a));
+  const auto goal_b = this->preemptor_->acquire();
+  EXPECT_EQ(this->countStops(), 0u);
+
+  // Never given twice
+  EXPECT_GT(goal_b, goal_a);
+  EXPECT_FALSE(this->preemptor_->isOwner(goal_a));
+  EXPECT_FALSE(this->preemptor_->requestStop(goal_a));
+}
+
+TEST_F(TestMotionPreemptor, NoOwnerIsNeverStopped) {
+  EXPECT_FALSE(this->preemptor_->isOwner(0));
+  EXPECT_FALSE(this->preemptor_->requestStop(0));
+  EXPECT_FALSE(this->preemptor_->sendIfOwner(0, []() {}));
+  EXPECT_EQ(this->countStops(), 0u);
+}
+
+TEST_F(TestMotionPreemptor, SendIfUnownedWhileNoGoalOwnsTheArm) {
+  int sent = 0;
+  const auto send = [&sent]() {++sent;};
+  EXPECT_FALSE(this->preemptor_->isOwned());
+  EXPECT_TRUE(this->preemptor_->sendIfUnowned(send));
+
+  const auto goal = this->preemptor_->acquire();
+  EXPECT_TRUE(this->preemptor_->isOwned());
+  EXPECT_FALSE(this->preemptor_->sendIfUnowned(send));
+
+  this->preemptor_->release(goal);
+  EXPECT_TRUE(this->preemptor_->sendIfUnowned(send));
+  EXPECT_EQ(sent, 2);
+  EXPECT_EQ(this->countStops(), 0u);
+}
+
+TEST_F(TestMotionPreemptor, NewerGoalWaitsForTheArmToStop) {
+  const auto goal_a = this->preemptor_->acquire();
+  const auto goal_b = this->preemptor_->acquire();
+  EXPECT_EQ(this->countStops(), 1u);
+  EXPECT_FALSE(this->preemptor_->isOwner(goal_a));
+  EXPECT_TRUE(this->preemptor_->isOwner(goal_b));
+
+  bool is_sent = false;
+  EXPECT_FALSE(this->preemptor_->sendIfOwner(goal_a, [&is_sent]() {is_sent = true;}));
+  EXPECT_FALSE(is_sent);
+
+  auto stopped = std::async(
+    std::launch::async, [this, goal_b]() {return this->preemptor_->waitForStop(goal_b);});
+
+  // Standing still before the controller took the stop: may still start
+  this->receive(RobotMode::ENABLE);
+  EXPECT_EQ(stopped.wait_for(20ms), std::future_status::timeout);
+
+  this->accept(0);
+  this->receive(RobotMode::RUNNING);
+  EXPECT_EQ(stopped.wait_for(20ms), std::future_status::timeout);
+
+  this->receive(RobotMode::ENABLE);
+  ASSERT_EQ(stopped.wait_for(100ms), std::future_status::ready);
+  EXPECT_TRUE(stopped.get());
+
+  const auto latency = this->preemptor_->getStopLatency();
+  EXPECT_EQ(latency.count, 1u);
+  EXPECT_GE(latency.max_us, 20000u);
+
+  EXPECT_TRUE(this->preemptor_->sendIfOwner(goal_b, [&is_sent]() {is_sent = true;}));
+  EXPECT_TRUE(is_sent);
+  // Confirmed: nothing left to wait for
+  EXPECT_TRUE(this->preemptor_->waitForStop(goal_b));
+}
+
+TEST_F(TestMotionPreemptor, CancelStopsOnlyTheOwner) {
+  const auto goal_a = this->preemptor_->acquire();
+  EXPECT_FALSE(this->preemptor_->requestStop(goal_a + 1));
+  EXPECT_EQ(this->countStops(), 0u);
+
+  EXPECT_TRUE(this->preemptor_->requestStop(goal_a));
+  EXPECT_EQ(this->countStops(), 1u);
+  this->accept(0);
+  this->receive(RobotMode::ENABLE);
+  EXPECT_TRUE(this->preemptor_->waitForStop(goal_a));
+}
+
+TEST_F(TestMotionPreemptor, TimesOutWhileTheArmKeepsRunning) {
+  this->preemptor_->acquire();
+  const auto goal_b = this->preemptor_->acquire();
+  this->accept(0);
+  this->receive(RobotMode::RUNNING);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(this->preemptor_->waitForStop(goal_b));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 200ms);
+  EXPECT_EQ(this->preemptor_->getStopLatency().timeouts, 1u);
+}
+
+TEST_F(TestMotionPreemptor, RejectedStopFailsOnce) {
+  this->preemptor_->acquire();
+  const auto goal_b = this->preemptor_->acquire();
+  this->accept(0, false);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(this->preemptor_->waitForStop(goal_b));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 100ms);
+  EXPECT_EQ(this->preemptor_->getStopLatency().errors, 1u);
+
+  EXPECT_TRUE(this->preemptor_->waitForStop(goal_b));
+}
+
+TEST_F(TestMotionPreemptor, StopFunctionThrows) {
+  MotionPreemptor preemptor(
+    [](const MotionPreemptor::StopCallback &) {
+      throw mg400_interface::TcpSocketException("connection closed");
+    },
+    [this]() {return this->snapshot_;});
+  preemptor.acquire();
+  const auto goal_b = preemptor.acquire();
+  EXPECT_FALSE(preemptor.waitForStop(goal_b));
+  EXPECT_EQ(preemptor.getStopLatency().errors, 1u);
+}
+
+TEST_F(TestMotionPreemptor, PreemptedWhileWaiting) {
+  this->preemptor_->acquire();
+  const auto goal_b = this->preemptor_->acquire();
+  auto stopped = std::async(
+    std::launch::async, [this, goal_b]() {return this->preemptor_->waitForStop(goal_b);});
+  std::this_thread::sleep_for(10ms);
+
+  // Lost the arm: the newest goal waits instead
+  const auto goal_c = this->preemptor_->acquire();
+  ASSERT_EQ(stopped.wait_for(100ms), std::future_status::ready);
+  EXPECT_FALSE(stopped.get());
+  EXPECT_EQ(this->countStops(), 2u);
+
+  // The superseded request is ignored
+  this->accept(0);
+  this->receive(RobotMode::ENABLE);
+  auto stopped_c = std::async(
+    std::launch::async, [&]() {return this->preemptor_->waitForStop(goal_c);});
+  EXPECT_EQ(stopped_c.wait_for(20ms), std::future_status::timeout);
+  this->accept(1);
+  this->receive(RobotMode::ENABLE);
+  ASSERT_EQ(stopped_c.wait_for(100ms), std::future_status::ready);
+  EXPECT_TRUE(stopped_c.get());
+}
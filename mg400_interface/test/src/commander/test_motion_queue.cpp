@@ -0,0 +1,312 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/commander/motion_queue.hpp>
+
+using ::testing::ElementsAre;
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::MotionQueue;
+using mg400_interface::RealTimeData;
+using mg400_msgs::msg::RobotMode;
+using State = MotionQueue::State;
+
+// Feedback period of the controller
+constexpr int64_t MS8 = 8000000;
+
+class FakeTcpInterface : public mg400_interface::MotionTcpInterfaceBase
+{
+public:
+  std::mutex mutex;
+  std::vector<std::string> commands;
+  bool is_broken = false;
+
+  void sendCommand(const std::string & cmd) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->is_broken) {
+      throw std::runtime_error("tcp is disconnected");
+    }
+    this->commands.push_back(cmd);
+  }
+};
+
+// Planner state: target pose in mm and degree, moving or not
+RealTimeData makePacket(
+  const uint64_t mode, const std::array<double, 4> & target, const bool is_moving = false)
+{
+  RealTimeData data = {};
+  data.len = sizeof(data);
+  data.robot_mode = mode;
+  for (size_t i = 0; i < 4; ++i) {
+    data.tool_vector_target[i] = target[i];
+    data.q_target[i] = target[i];
+    data.qd_target[i] = is_moving ? 10.0 : 0.0;
+  }
+  return data;
+}
+
+class TestMotionQueue : public ::testing::Test
+{
+protected:
+  FakeTcpInterface tcp_if;
+  std::unique_ptr<MotionQueue> queue;
+  int64_t stamp_ns = 0;
+
+  virtual void SetUp()
+  {
+    this->queue = std::make_unique<MotionQueue>(
+      &this->tcp_if, MotionQueue::Config{2, 0.1, 0.1, 0.01, 100ms});
+    this->feed(RobotMode::ENABLE, {0.0, 0.0, 0.0, 0.0});
+  }
+
+  void feed(const uint64_t mode, const std::array<double, 4> & target, const bool is_moving = false)
+  {
+    this->stamp_ns += MS8;
+    const auto data = makePacket(mode, target, is_moving);
+    this->queue->update(&data, this->stamp_ns);
+  }
+
+  State stateOf(const uint64_t id)
+  {
+    MotionQueue::Record record;
+    EXPECT_TRUE(this->queue->getRecord(id, record));
+    return record.state;
+  }
+};
+
+TEST_F(TestMotionQueue, RunsToCompletion)
+{
+  const auto id = this->queue->tryPush(MotionQueue::movJ(0.2, 0.1, 0.05, M_PI_2));
+  EXPECT_EQ(id, 1u);
+  EXPECT_THAT(
+    this->tcp_if.commands,
+    ElementsAre("MovJ(200.000,100.000,50.000,90.000,0.000,0.000)"));
+  EXPECT_EQ(this->stateOf(id), State::SENT);
+
+  // Not picked up yet
+  this->feed(RobotMode::ENABLE, {0.0, 0.0, 0.0, 0.0});
+  EXPECT_EQ(this->stateOf(id), State::SENT);
+
+  this->feed(RobotMode::RUNNING, {50.0, 20.0, 10.0, 20.0}, true);
+  EXPECT_EQ(this->stateOf(id), State::RUNNING);
+  // Still moving at the goal: decelerating
+  this->feed(RobotMode::RUNNING, {200.0, 100.0, 50.0, 90.0}, true);
+  EXPECT_EQ(this->stateOf(id), State::RUNNING);
+  this->feed(RobotMode::RUNNING, {200.0, 100.0, 50.0, 90.0});
+
+  MotionQueue::Record record;
+  ASSERT_TRUE(this->queue->wait(id, 0ms, record));
+  EXPECT_EQ(record.state, State::DONE);
+  EXPECT_EQ(record.sent_ns, MS8);
+  EXPECT_EQ(record.start_ns, 3 * MS8);
+  EXPECT_EQ(record.end_ns, 5 * MS8);
+  EXPECT_EQ(this->queue->countInFlight(), 0u);
+}
+
+TEST_F(TestMotionQueue, AlreadyThere)
+{
+  const auto id = this->queue->tryPush(MotionQueue::movL(0.0, 0.0, 0.0, 0.0));
+  this->feed(RobotMode::ENABLE, {0.0, 0.0, 0.0, 0.0});
+
+  MotionQueue::Record record;
+  ASSERT_TRUE(this->queue->getRecord(id, record));
+  EXPECT_EQ(record.state, State::DONE);
+  EXPECT_EQ(record.start_ns, record.end_ns);
+}
+
+TEST_F(TestMotionQueue, PassesThroughQueuedGoals)
+{
+  const auto first = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  const auto second = this->queue->tryPush(MotionQueue::movL(0.2, 0.0, 0.0, 0.0));
+  this->feed(RobotMode::RUNNING, {50.0, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(first), State::RUNNING);
+  EXPECT_EQ(this->stateOf(second), State::SENT);
+
+  // Blended: never stops at the first goal
+  this->feed(RobotMode::RUNNING, {100.05, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(first), State::DONE);
+  EXPECT_EQ(this->stateOf(second), State::RUNNING);
+
+  this->feed(RobotMode::RUNNING, {200.0, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(second), State::RUNNING);
+  this->feed(RobotMode::ENABLE, {200.0, 0.0, 0.0, 0.0});
+  EXPECT_EQ(this->stateOf(second), State::DONE);
+}
+
+TEST_F(TestMotionQueue, BlendZone)
+{
+  auto move = MotionQueue::movL(0.1, 0.0, 0.0, 0.0);
+  move.cp = 50;
+  move.blend_zone = 0.005;
+  const auto first = this->queue->tryPush(move);
+  const auto second = this->queue->tryPush(MotionQueue::movL(0.1, 0.1, 0.0, 0.0));
+  EXPECT_THAT(
+    this->tcp_if.commands,
+    ElementsAre(
+      "MovL(100.000,0.000,0.000,0.000,CP=50)",
+      "MovL(100.000,100.000,0.000,0.000,0.000,0.000)"));
+
+  this->feed(RobotMode::RUNNING, {90.0, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(first), State::RUNNING);
+  // Cuts the corner 4 mm away from it
+  this->feed(RobotMode::RUNNING, {97.0, 3.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(first), State::DONE);
+  EXPECT_EQ(this->stateOf(second), State::RUNNING);
+}
+
+TEST_F(TestMotionQueue, StandingAtLaterGoal)
+{
+  // Blended through without a zone: over once the last one is reached
+  auto move = MotionQueue::movL(0.1, 0.0, 0.0, 0.0);
+  move.cp = 100;
+  const auto first = this->queue->tryPush(move);
+  const auto second = this->queue->tryPush(MotionQueue::movL(0.1, 0.1, 0.0, 0.0));
+  this->feed(RobotMode::RUNNING, {97.0, 3.0, 0.0, 0.0}, true);
+  this->feed(RobotMode::ENABLE, {100.0, 100.0, 0.0, 0.0});
+  EXPECT_EQ(this->stateOf(first), State::DONE);
+  EXPECT_EQ(this->stateOf(second), State::DONE);
+}
+
+TEST_F(TestMotionQueue, ClosedPath)
+{
+  // Ends where the arm stands: not done before the planner starts
+  const auto first = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  const auto second = this->queue->tryPush(MotionQueue::movL(0.0, 0.0, 0.0, 0.0));
+  this->feed(RobotMode::ENABLE, {0.0, 0.0, 0.0, 0.0});
+  EXPECT_EQ(this->stateOf(first), State::SENT);
+  EXPECT_EQ(this->stateOf(second), State::SENT);
+
+  this->feed(RobotMode::RUNNING, {50.0, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(first), State::RUNNING);
+  EXPECT_EQ(this->stateOf(second), State::SENT);
+  this->feed(RobotMode::RUNNING, {100.0, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(first), State::DONE);
+  this->feed(RobotMode::RUNNING, {50.0, 0.0, 0.0, 0.0}, true);
+  EXPECT_EQ(this->stateOf(second), State::RUNNING);
+  this->feed(RobotMode::ENABLE, {0.0, 0.0, 0.0, 0.0});
+  EXPECT_EQ(this->stateOf(second), State::DONE);
+}
+
+TEST_F(TestMotionQueue, JointGoals)
+{
+  // -180 and 180 degree are the same angle
+  const auto id = this->queue->tryPush(MotionQueue::jointMovJ(M_PI_2, 0.0, 0.0, -M_PI));
+  EXPECT_THAT(
+    this->tcp_if.commands,
+    ElementsAre("JointMovJ(90.000,0.000,0.000,-180.000,0.000,0.000)"));
+  this->feed(RobotMode::RUNNING, {45.0, 0.0, 0.0, 90.0}, true);
+  this->feed(RobotMode::ENABLE, {90.0, 0.0, 0.0, 180.0});
+  EXPECT_EQ(this->stateOf(id), State::DONE);
+}
+
+TEST_F(TestMotionQueue, Backpressure)
+{
+  const auto first = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  EXPECT_NE(this->queue->tryPush(MotionQueue::movL(0.2, 0.0, 0.0, 0.0)), 0u);
+  EXPECT_EQ(this->queue->tryPush(MotionQueue::movL(0.3, 0.0, 0.0, 0.0)), 0u);
+  EXPECT_THROW(
+    this->queue->push(MotionQueue::movL(0.3, 0.0, 0.0, 0.0), 10ms), std::runtime_error);
+  EXPECT_EQ(this->tcp_if.commands.size(), 2u);
+
+  // Let go once the first one is done
+  uint64_t third = 0;
+  std::thread pusher([this, &third]() {
+      third = this->queue->push(MotionQueue::movL(0.3, 0.0, 0.0, 0.0), 5s);
+    });
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(this->queue->countInFlight(), 2u);
+  this->feed(RobotMode::RUNNING, {100.0, 0.0, 0.0, 0.0}, true);
+  pusher.join();
+
+  EXPECT_EQ(this->stateOf(first), State::DONE);
+  EXPECT_EQ(third, 3u);
+  EXPECT_EQ(this->tcp_if.commands.size(), 3u);
+  EXPECT_EQ(this->queue->countInFlight(), 2u);
+
+  // Deeper queue: room right away
+  this->queue->setDepth(3);
+  EXPECT_EQ(this->queue->tryPush(MotionQueue::movL(0.4, 0.0, 0.0, 0.0)), 4u);
+}
+
+TEST_F(TestMotionQueue, FailsOnRobotError)
+{
+  const auto first = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  const auto second = this->queue->tryPush(MotionQueue::movL(0.2, 0.0, 0.0, 0.0));
+  this->feed(RobotMode::RUNNING, {50.0, 0.0, 0.0, 0.0}, true);
+  this->feed(RobotMode::ERROR, {50.0, 0.0, 0.0, 0.0});
+
+  MotionQueue::Record record;
+  ASSERT_TRUE(this->queue->getRecord(first, record));
+  EXPECT_EQ(record.state, State::FAILED);
+  EXPECT_EQ(record.end_ns, 3 * MS8);
+  EXPECT_EQ(this->stateOf(second), State::FAILED);
+  EXPECT_EQ(this->queue->countInFlight(), 0u);
+}
+
+TEST_F(TestMotionQueue, FailsOnFeedbackLost)
+{
+  const auto id = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  this->queue->update(nullptr, 0);
+  EXPECT_EQ(this->stateOf(id), State::FAILED);
+}
+
+TEST_F(TestMotionQueue, FailsWhenStalled)
+{
+  const auto id = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  // Paused: waits as long as it takes
+  for (int i = 0; i < 20; ++i) {
+    this->feed(RobotMode::PAUSE, {50.0, 0.0, 0.0, 0.0});
+  }
+  EXPECT_EQ(this->stateOf(id), State::SENT);
+
+  // 100 ms standing still in ENABLE
+  for (int i = 0; i < 12; ++i) {
+    this->feed(RobotMode::ENABLE, {50.0, 0.0, 0.0, 0.0});
+  }
+  EXPECT_EQ(this->stateOf(id), State::SENT);
+  this->feed(RobotMode::ENABLE, {50.0, 0.0, 0.0, 0.0});
+  EXPECT_EQ(this->stateOf(id), State::FAILED);
+}
+
+TEST_F(TestMotionQueue, Clear)
+{
+  const auto id = this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0));
+  this->queue->clear();
+  EXPECT_EQ(this->stateOf(id), State::FAILED);
+  EXPECT_EQ(this->queue->countInFlight(), 0u);
+}
+
+TEST_F(TestMotionQueue, SendFailure)
+{
+  this->tcp_if.is_broken = true;
+  EXPECT_THROW(
+    this->queue->tryPush(MotionQueue::movL(0.1, 0.0, 0.0, 0.0)), std::runtime_error);
+  EXPECT_EQ(this->stateOf(1), State::FAILED);
+  EXPECT_EQ(this->queue->countInFlight(), 0u);
+}
+
+TEST_F(TestMotionQueue, UnknownId)
+{
+  MotionQueue::Record record;
+  EXPECT_FALSE(this->queue->getRecord(42, record));
+  EXPECT_FALSE(this->queue->wait(42, 10ms, record));
+}
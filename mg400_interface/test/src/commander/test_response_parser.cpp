@@ -109,3 +109,22 @@ TEST(ResponseParser, takeInt)
   const auto res = mg400_interface::ResponseParser::takeInt(response.ret_val);
   ASSERT_EQ(res, 1);
 }
+
+TEST(ResponseParser, takeIntArray)
+{
+  const std::string packet =
+    "0,"
+    "{6000,300,-1}"
+    ",GetHoldRegs(0,3095,3,U16);";
+
+  mg400_interface::DashboardResponse response;
+  ASSERT_TRUE(mg400_interface::ResponseParser::parseResponse(packet, response));
+
+  const auto res = mg400_interface::ResponseParser::takeIntArray(response.ret_val);
+  ASSERT_EQ(res.size(), 3u);
+  ASSERT_EQ(res.at(0), 6000);
+  ASSERT_EQ(res.at(1), 300);
+  ASSERT_EQ(res.at(2), -1);
+
+  ASSERT_TRUE(mg400_interface::ResponseParser::takeIntArray("{}").empty());
+}
@@ -0,0 +1,275 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/commander/servo_streamer.hpp>
+#include <mg400_interface/tcp_interface/motion_tcp_interface.hpp>
+
+#include "../loopback_server.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::RealtimeFeedbackTcpInterface;
+using mg400_interface::ServoStreamer;
+using Mode = ServoStreamer::Mode;
+
+class FakeTcpInterface : public mg400_interface::MotionTcpInterfaceBase
+{
+public:
+  std::mutex mutex;
+  std::vector<std::string> commands;
+  bool is_broken = false;
+
+  void sendCommand(const std::string & cmd) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->is_broken) {
+      throw mg400_interface::TcpSocketException("tcp is disconnected");
+    }
+    this->commands.push_back(cmd);
+  }
+
+  std::vector<std::string> getCommands()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->commands;
+  }
+};
+
+class TestServoStreamer : public ::testing::Test
+{
+protected:
+  FakeTcpInterface tcp_if_;
+  mg400_interface::MotionCommander::SharedPtr commander_;
+  RealtimeFeedbackTcpInterface::Snapshot snapshot_;
+  ServoStreamer::FeedbackSource feedback_source_;
+
+  virtual void SetUp()
+  {
+    this->commander_ = std::make_shared<mg400_interface::MotionCommander>(&this->tcp_if_);
+    this->snapshot_ = {};
+    this->snapshot_.active = true;
+    this->feedback_source_ = [this]() {return this->snapshot_;};
+  }
+};
+
+TEST(ServoStreamerLimit, ClampsEveryJoint) {
+  std::array<double, 4> command = {0.0, 0.0, 0.0, 0.0};
+  EXPECT_TRUE(ServoStreamer::limit(Mode::JOINT, {1.0, -1.0, 0.005, 0.0}, 0.01, 0.0, command));
+  EXPECT_THAT(command, ::testing::ElementsAre(0.01, -0.01, 0.005, 0.0));
+
+  EXPECT_FALSE(ServoStreamer::limit(Mode::JOINT, {0.0, 0.0, 0.0, 0.0}, 0.01, 0.0, command));
+  EXPECT_THAT(command, ::testing::ElementsAre(0.0, 0.0, 0.0, 0.0));
+}
+
+TEST(ServoStreamerLimit, KeepsTheDirectionOfThePose) {
+  std::array<double, 4> command = {0.1, 0.0, 0.0, 0.0};
+  EXPECT_TRUE(ServoStreamer::limit(Mode::POSE, {0.4, 0.4, 0.0, 1.0}, 0.005, 0.02, command));
+  EXPECT_DOUBLE_EQ(command[0], 0.1 + 0.003);
+  EXPECT_DOUBLE_EQ(command[1], 0.004);
+  EXPECT_DOUBLE_EQ(command[2], 0.0);
+  EXPECT_DOUBLE_EQ(command[3], 0.02);
+
+  command = {0.1, 0.0, 0.0, 0.0};
+  EXPECT_FALSE(ServoStreamer::limit(Mode::POSE, {0.101, 0.0, 0.0, 0.01}, 0.005, 0.02, command));
+  EXPECT_DOUBLE_EQ(command[0], 0.101);
+  EXPECT_DOUBLE_EQ(command[3], 0.01);
+}
+
+TEST_F(TestServoStreamer, RampsTowardsTheSetpoint) {
+  // 1 rad/s every 10 ms: 0.01 rad (0.573 degree) a command
+  ServoStreamer streamer(this->commander_, this->feedback_source_, {10ms, 1s, 1.0, 0.2, 1.0, 0});
+  streamer.setJointSetpoint(1.0, 0.0, 0.0, 0.0);
+  streamer.start();
+  std::this_thread::sleep_for(100ms);
+  streamer.stop();
+
+  const auto commands = this->tcp_if_.getCommands();
+  ASSERT_GE(commands.size(), 3u);
+  EXPECT_EQ(commands[0], "ServoJ(0.573,0.000,0.000,0.000)");
+  EXPECT_EQ(commands[1], "ServoJ(1.146,0.000,0.000,0.000)");
+  EXPECT_EQ(commands[2], "ServoJ(1.719,0.000,0.000,0.000)");
+
+  const auto stats = streamer.getStats();
+  EXPECT_EQ(stats.sent, commands.size());
+  EXPECT_EQ(stats.limited, commands.size());
+  EXPECT_GE(stats.ticks, stats.sent);
+  EXPECT_EQ(stats.jitter.count, stats.ticks);
+}
+
+TEST_F(TestServoStreamer, StartsFromTheFeedbackPose) {
+  this->snapshot_.tool_vector[0] = 300.0;
+  this->snapshot_.tool_vector[2] = 50.0;
+
+  ServoStreamer streamer(this->commander_, this->feedback_source_, {10ms, 1s, 1.0, 0.2, 1.0, 0});
+  streamer.setPoseSetpoint(0.301, 0.0, 0.05, 0.0);
+  streamer.start();
+  std::this_thread::sleep_for(50ms);
+  streamer.stop();
+
+  const auto commands = this->tcp_if_.getCommands();
+  ASSERT_FALSE(commands.empty());
+  for (const auto & command : commands) {
+    EXPECT_EQ(command, "ServoP(301.000,0.000,50.000,0.000)");
+  }
+  EXPECT_EQ(streamer.getStats().limited, 0u);
+}
+
+TEST_F(TestServoStreamer, SendsNothingWithoutSetpointOrFeedback) {
+  ServoStreamer streamer(this->commander_, this->feedback_source_, {10ms, 1s, 1.0, 0.2, 1.0, 0});
+  streamer.start();
+  std::this_thread::sleep_for(50ms);
+  EXPECT_TRUE(this->tcp_if_.getCommands().empty());
+
+  streamer.stop();
+  this->snapshot_.active = false;
+  streamer.setJointSetpoint(1.0, 0.0, 0.0, 0.0);
+  streamer.start();
+  std::this_thread::sleep_for(50ms);
+  streamer.stop();
+  EXPECT_TRUE(this->tcp_if_.getCommands().empty());
+  EXPECT_GT(streamer.getStats().ticks, 0u);
+}
+
+TEST_F(TestServoStreamer, WatchdogStopsOnStaleSetpoint) {
+  ServoStreamer streamer(this->commander_, this->feedback_source_, {10ms, 50ms, 1.0, 0.2, 1.0, 0});
+  const auto start = std::chrono::steady_clock::now();
+  streamer.setJointSetpoint(1.0, 0.0, 0.0, 0.0);
+  streamer.start();
+  std::this_thread::sleep_for(150ms);
+  const size_t sent = this->tcp_if_.getCommands().size();
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - start);
+  std::this_thread::sleep_for(100ms);
+
+  // Nothing sent past the timeout
+  EXPECT_EQ(this->tcp_if_.getCommands().size(), sent);
+  EXPECT_GT(sent, 0u);
+  // At most one command a period while the setpoint was fresh
+  EXPECT_LE(sent, static_cast<size_t>(std::min(elapsed, 50ms) / 10ms) + 1);
+  EXPECT_EQ(streamer.getStats().watchdog_stops, 1u);
+
+  // A fresh setpoint resumes from the feedback
+  streamer.setJointSetpoint(0.0, 0.0, 0.0, 0.0);
+  std::this_thread::sleep_for(30ms);
+  streamer.stop();
+  const auto commands = this->tcp_if_.getCommands();
+  ASSERT_GT(commands.size(), sent);
+  EXPECT_EQ(commands[sent], "ServoJ(0.000,0.000,0.000,0.000)");
+}
+
+TEST_F(TestServoStreamer, StopsWhenSendFails) {
+  ServoStreamer streamer(this->commander_, this->feedback_source_, {10ms, 1s, 1.0, 0.2, 1.0, 0});
+  this->tcp_if_.is_broken = true;
+  streamer.setJointSetpoint(1.0, 0.0, 0.0, 0.0);
+  streamer.start();
+  std::this_thread::sleep_for(50ms);
+  EXPECT_FALSE(streamer.isRunning());
+  EXPECT_EQ(streamer.getStats().sent, 0u);
+
+  // Can be started again
+  {
+    std::lock_guard<std::mutex> lock(this->tcp_if_.mutex);
+    this->tcp_if_.is_broken = false;
+  }
+  streamer.setJointSetpoint(1.0, 0.0, 0.0, 0.0);
+  streamer.start();
+  EXPECT_TRUE(streamer.isRunning());
+  std::this_thread::sleep_for(30ms);
+  streamer.stop();
+  EXPECT_GT(streamer.getStats().sent, 0u);
+}
+
+TEST_F(TestServoStreamer, PausesWhileTheGuardRefuses) {
+  this->snapshot_.joints[0] = 0.5;
+  std::atomic<bool> is_allowed(false);
+  ServoStreamer streamer(this->commander_, this->feedback_source_, {10ms, 1s, 1.0, 0.2, 1.0, 0});
+  streamer.setSendGuard(
+    [&is_allowed](const std::function<void()> & send) {
+      if (!is_allowed.load()) {
+        return false;
+      }
+      send();
+      return true;
+    });
+  streamer.setJointSetpoint(1.0, 0.0, 0.0, 0.0);
+  streamer.start();
+  std::this_thread::sleep_for(50ms);
+  EXPECT_TRUE(streamer.isRunning());
+  EXPECT_TRUE(this->tcp_if_.getCommands().empty());
+  EXPECT_EQ(streamer.getStats().sent, 0u);
+
+  // Starts from the feedback once allowed
+  is_allowed.store(true);
+  std::this_thread::sleep_for(50ms);
+  streamer.stop();
+  const auto commands = this->tcp_if_.getCommands();
+  ASSERT_FALSE(commands.empty());
+  EXPECT_EQ(commands[0], "ServoJ(29.221,0.000,0.000,0.000)");
+}
+
+TEST_F(TestServoStreamer, StreamsToTheControllerAtTheRate) {
+  LoopbackServer controller;
+  auto reactor = std::make_shared<mg400_interface::IoReactor>();
+  mg400_interface::MotionTcpInterface tcp_if("127.0.0.1", reactor, controller.port());
+  tcp_if.init();
+  reactor->start();
+  ASSERT_TRUE(controller.accept(2s));
+  ASSERT_TRUE(
+    reactor->waitUntil(
+      [&tcp_if]() {return tcp_if.isConnected();},
+      std::chrono::steady_clock::now() + 2s));
+
+  // Same period as the feedback
+  auto commander = std::make_shared<mg400_interface::MotionCommander>(&tcp_if);
+  ServoStreamer streamer(commander, this->feedback_source_, {8ms, 100ms, 1.0, 0.2, 1.0, 0});
+  streamer.setJointSetpoint(0.5, 0.0, 0.0, 0.0);
+  streamer.start();
+
+  std::string received;
+  const auto start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - start < 400ms) {
+    streamer.setJointSetpoint(0.5, 0.0, 0.0, 0.0);
+    received += controller.recv(10ms);
+  }
+  streamer.stop();
+  for (std::string chunk = controller.recv(50ms); !chunk.empty(); chunk = controller.recv(50ms)) {
+    received += chunk;
+  }
+  reactor->stop();
+
+  size_t count = 0;
+  for (size_t pos = received.find("ServoJ("); pos != std::string::npos;
+    pos = received.find("ServoJ(", pos + 1))
+  {
+    ++count;
+  }
+  const auto stats = streamer.getStats();
+  EXPECT_EQ(count, stats.sent);
+  EXPECT_EQ(stats.sent, stats.ticks);
+  // 400 ms / 8 ms: a late wake up skips periods rather than sending them in a burst
+  EXPECT_GE(stats.ticks + stats.overruns, 45u);
+  EXPECT_LE(stats.ticks + stats.overruns, 52u);
+  EXPECT_LT(stats.jitter.p50_us, 2000u);
+}
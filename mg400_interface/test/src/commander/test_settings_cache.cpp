@@ -0,0 +1,85 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <mg400_interface/commander/settings_cache.hpp>
+
+using mg400_interface::SettingsCache;
+
+TEST(TestSettingsCache, HitAfterStore) {
+  SettingsCache cache;
+  uint64_t ticket = 0;
+  EXPECT_FALSE(cache.lookup("SpeedFactor(50)", 0, ticket));
+  // Not accepted yet
+  uint64_t unused = 0;
+  EXPECT_FALSE(cache.lookup("SpeedFactor(50)", 0, unused));
+
+  EXPECT_FALSE(cache.lookup("SpeedFactor(50)", 0, ticket));
+  cache.store("SpeedFactor(50)", ticket);
+  EXPECT_TRUE(cache.lookup("SpeedFactor(50)", 0, ticket));
+
+  // Another value of the same function replaces it
+  EXPECT_FALSE(cache.lookup("SpeedFactor(60)", 0, ticket));
+  EXPECT_FALSE(cache.lookup("SpeedFactor(50)", 0, ticket));
+
+  const auto stats = cache.getStats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 5u);
+}
+
+TEST(TestSettingsCache, FunctionsAreIndependent) {
+  SettingsCache cache;
+  uint64_t speed = 0, tool = 0;
+  EXPECT_FALSE(cache.lookup("SpeedFactor(50)", 0, speed));
+  EXPECT_FALSE(cache.lookup("Tool(1)", 0, tool));
+  cache.store("Tool(1)", tool);
+  cache.store("SpeedFactor(50)", speed);
+  EXPECT_TRUE(cache.lookup("SpeedFactor(50)", 0, speed));
+  EXPECT_TRUE(cache.lookup("Tool(1)", 0, tool));
+}
+
+TEST(TestSettingsCache, SupersededTicketIsNotStored) {
+  SettingsCache cache;
+  uint64_t first = 0, second = 0;
+  EXPECT_FALSE(cache.lookup("AccJ(10)", 0, first));
+  EXPECT_FALSE(cache.lookup("AccJ(20)", 0, second));
+  // The response to AccJ(10) arrives after AccJ(20) was sent
+  cache.store("AccJ(10)", first);
+  EXPECT_FALSE(cache.lookup("AccJ(10)", 0, first));
+}
+
+TEST(TestSettingsCache, InvalidationVoidsPendingTickets) {
+  SettingsCache cache;
+  uint64_t ticket = 0;
+  EXPECT_FALSE(cache.lookup("CP(50)", 0, ticket));
+  cache.invalidate();
+  cache.store("CP(50)", ticket);
+  EXPECT_FALSE(cache.lookup("CP(50)", 0, ticket));
+
+  cache.store("CP(50)", ticket);
+  EXPECT_TRUE(cache.lookup("CP(50)", 0, ticket));
+  cache.invalidate();
+  EXPECT_FALSE(cache.lookup("CP(50)", 0, ticket));
+  EXPECT_EQ(cache.getStats().invalidations, 2u);
+}
+
+TEST(TestSettingsCache, EpochChangeClears) {
+  SettingsCache cache;
+  uint64_t ticket = 0;
+  EXPECT_FALSE(cache.lookup("User(1)", 3, ticket));
+  cache.store("User(1)", ticket);
+  EXPECT_TRUE(cache.lookup("User(1)", 3, ticket));
+  EXPECT_FALSE(cache.lookup("User(1)", 4, ticket));
+}
@@ -0,0 +1,114 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Minimal TCP server on 127.0.0.1 standing in for the MG400 controller.
+class LoopbackServer
+{
+private:
+  int listen_fd_;
+  int client_fd_;
+  uint16_t port_;
+
+public:
+  explicit LoopbackServer(const uint16_t port = 0, const int backlog = 4)
+  : listen_fd_(-1), client_fd_(-1), port_(0)
+  {
+    this->listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (this->listen_fd_ < 0) {
+      throw std::runtime_error(std::string("socket: ") + strerror(errno));
+    }
+    const int yes = 1;
+    ::setsockopt(this->listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t len = sizeof(addr);
+    if (::bind(this->listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      ::listen(this->listen_fd_, backlog) < 0 ||
+      ::getsockname(this->listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) < 0)
+    {
+      // A port taken by another test or process must not pass unnoticed
+      const int err = errno;
+      ::close(this->listen_fd_);
+      throw std::runtime_error(
+        "listen on port " + std::to_string(port) + ": " + strerror(err));
+    }
+    this->port_ = ntohs(addr.sin_port);
+  }
+
+  ~LoopbackServer()
+  {
+    this->closeClient();
+    ::close(this->listen_fd_);
+  }
+
+  uint16_t port() const {return this->port_;}
+  int clientFd() const {return this->client_fd_;}
+
+  bool accept(const std::chrono::milliseconds & timeout)
+  {
+    pollfd pfd = {this->listen_fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+      return false;
+    }
+    this->closeClient();
+    this->client_fd_ = ::accept(this->listen_fd_, nullptr, nullptr);
+    return this->client_fd_ >= 0;
+  }
+
+  void closeClient()
+  {
+    if (this->client_fd_ >= 0) {
+      ::close(this->client_fd_);
+      this->client_fd_ = -1;
+    }
+  }
+
+  bool send(const void * buf, const size_t len)
+  {
+    return ::send(this->client_fd_, buf, len, MSG_NOSIGNAL) == static_cast<ssize_t>(len);
+  }
+
+  bool send(const std::string & str)
+  {
+    return this->send(str.data(), str.size());
+  }
+
+  std::string recv(const std::chrono::milliseconds & timeout)
+  {
+    pollfd pfd = {this->client_fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+      return "";
+    }
+    char buf[1024];
+    const auto len = ::recv(this->client_fd_, buf, sizeof(buf), 0);
+    return len > 0 ? std::string(buf, len) : "";
+  }
+};
@@ -0,0 +1,171 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mg400_interface/tcp_interface/io_reactor.hpp>
+
+#include "../loopback_server.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+
+class TestHandler : public mg400_interface::IoReactor::Handler
+{
+public:
+  std::shared_ptr<mg400_interface::TcpSocketHandler> socket;
+  std::atomic<int> connected_count{0};
+  std::atomic<int> disconnected_count{0};
+  std::atomic<int> timer_count{0};
+  std::mutex mutex;
+  std::string received;
+
+  explicit TestHandler(const uint16_t port)
+  : socket(std::make_shared<mg400_interface::TcpSocketHandler>("127.0.0.1", port)) {}
+
+  std::shared_ptr<mg400_interface::TcpSocketHandler> getSocket() override {return socket;}
+  uint32_t getEvents() const override {return EPOLLIN;}
+  void onConnected() override {connected_count++;}
+  void onDisconnected() override {disconnected_count++;}
+  void onTimer(const mg400_interface::IoReactor::SteadyClock::time_point &) override
+  {
+    timer_count++;
+  }
+  void onReadable() override
+  {
+    char buf[64];
+    uint32_t len;
+    while ((len = this->socket->tryRecv(buf, sizeof(buf))) > 0) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->received.append(buf, len);
+    }
+  }
+  std::string getReceived()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->received;
+  }
+};
+
+template<typename PredicateT>
+bool waitFor(PredicateT pred, const std::chrono::milliseconds & timeout = 2s)
+{
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (pred()) {
+      return true;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return pred();
+}
+
+class TestIoReactor : public ::testing::Test
+{
+protected:
+  LoopbackServer server;
+  std::unique_ptr<TestHandler> handler;
+  mg400_interface::IoReactor reactor;
+
+  virtual void SetUp()
+  {
+    this->handler = std::make_unique<TestHandler>(this->server.port());
+    this->reactor.start();
+  }
+
+  virtual void TearDown()
+  {
+    this->reactor.remove(this->handler.get());
+    this->reactor.stop();
+  }
+};
+
+TEST_F(TestIoReactor, ConnectAndDispatchReadable)
+{
+  this->reactor.add(this->handler.get());
+  ASSERT_TRUE(this->server.accept(2s));
+  ASSERT_TRUE(waitFor([this] {return this->handler->connected_count.load() == 1;}));
+  ASSERT_TRUE(this->handler->socket->isConnected());
+
+  ASSERT_TRUE(this->server.send("0,{},EnableRobot();"));
+  ASSERT_TRUE(
+    waitFor([this] {return this->handler->getReceived() == "0,{},EnableRobot();";}));
+
+  const auto stats = this->reactor.getStatistics();
+  EXPECT_GT(stats.loop_count, 0u);
+  EXPECT_GT(stats.event_count, 0u);
+  EXPECT_LE(stats.last_dispatch_time, stats.max_dispatch_time);
+}
+
+TEST_F(TestIoReactor, ReconnectAfterPeerClosed)
+{
+  this->reactor.add(this->handler.get());
+  ASSERT_TRUE(this->server.accept(2s));
+  ASSERT_TRUE(waitFor([this] {return this->handler->connected_count.load() == 1;}));
+
+  this->server.closeClient();
+  ASSERT_TRUE(waitFor([this] {return this->handler->disconnected_count.load() == 1;}));
+
+  ASSERT_TRUE(this->server.accept(2s));
+  ASSERT_TRUE(waitFor([this] {return this->handler->connected_count.load() == 2;}));
+  EXPECT_TRUE(this->handler->socket->isConnected());
+}
+
+TEST_F(TestIoReactor, TimerRunsWithoutTraffic)
+{
+  this->reactor.add(this->handler.get());
+  ASSERT_TRUE(waitFor([this] {return this->handler->timer_count.load() >= 2;}));
+}
+
+TEST_F(TestIoReactor, RemovedHandlerIsNotDispatched)
+{
+  this->reactor.add(this->handler.get());
+  ASSERT_TRUE(this->server.accept(2s));
+  ASSERT_TRUE(waitFor([this] {return this->handler->connected_count.load() == 1;}));
+
+  this->reactor.remove(this->handler.get());
+  ASSERT_TRUE(this->server.send("ignored"));
+  std::this_thread::sleep_for(200ms);
+  EXPECT_TRUE(this->handler->getReceived().empty());
+}
+
+TEST_F(TestIoReactor, UnreachablePeerDoesNotDelayOthers)
+{
+  LoopbackServer unreachable(0, 0);
+  std::vector<std::unique_ptr<mg400_interface::TcpSocketHandler>> fillers;
+  for (int i = 0; i < 4; ++i) {
+    fillers.emplace_back(
+      std::make_unique<mg400_interface::TcpSocketHandler>("127.0.0.1", unreachable.port()));
+    try {
+      fillers.back()->connect(50ms);
+    } catch (const mg400_interface::TcpSocketException &) {
+    }
+  }
+  TestHandler pending(unreachable.port());
+  this->reactor.add(&pending);
+  std::this_thread::sleep_for(10ms);
+
+  const auto start = std::chrono::steady_clock::now();
+  this->reactor.add(this->handler.get());
+  ASSERT_TRUE(waitFor([this] {return this->handler->connected_count.load() == 1;}));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 100ms);
+  EXPECT_EQ(pending.connected_count.load(), 0);
+
+  this->reactor.remove(&pending);
+}
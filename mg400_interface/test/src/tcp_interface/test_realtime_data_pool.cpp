@@ -0,0 +1,201 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <mg400_interface/tcp_interface/realtime_data_pool.hpp>
+#include <mg400_interface/tcp_interface/realtime_feedback_tcp_interface.hpp>
+
+#include "../loopback_server.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::RealTimeDataPool;
+
+// Every heap allocation of this process, from any thread
+static std::atomic<uint64_t> allocation_count(0);
+
+void * operator new(size_t size)
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void * ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// Not inlined, otherwise GCC flags free() of a pointer from operator new
+__attribute__((noinline)) void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void * ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+TEST(TestRealTimeDataPool, AcquireUntilExhausted)
+{
+  RealTimeDataPool pool;
+  std::vector<RealTimeDataPool::Handle> handles;
+  for (size_t i = 0; i < RealTimeDataPool::SIZE; ++i) {
+    handles.push_back(pool.acquire());
+    ASSERT_TRUE(handles.back());
+  }
+  EXPECT_EQ(pool.countFree(), 0u);
+  EXPECT_FALSE(pool.acquire());
+
+  handles.pop_back();
+  EXPECT_EQ(pool.countFree(), 1u);
+  EXPECT_TRUE(pool.acquire());
+}
+
+TEST(TestRealTimeDataPool, CopyPinsSlot)
+{
+  RealTimeDataPool pool;
+  auto handle = pool.acquire();
+  handle->robot_mode = 5;
+
+  auto reader = handle;
+  handle.reset();
+  EXPECT_EQ(pool.countFree(), RealTimeDataPool::SIZE - 1);
+  EXPECT_EQ(reader->robot_mode, 5u);
+
+  reader = nullptr;
+  EXPECT_EQ(pool.countFree(), RealTimeDataPool::SIZE);
+}
+
+TEST(TestRealTimeDataPool, SlotsAreCacheAligned)
+{
+  RealTimeDataPool pool;
+  auto first = pool.acquire();
+  auto second = pool.acquire();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first.get()) % 64, 0u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(second.get()) % 64, 0u);
+}
+
+TEST(TestRealTimeDataPool, FeedbackPathDoesNotAllocate)
+{
+  LoopbackServer feedback;
+  auto reactor = std::make_shared<mg400_interface::IoReactor>();
+  auto rt_tcp_if = std::make_shared<mg400_interface::RealtimeFeedbackTcpInterface>(
+    "127.0.0.1", reactor, "", feedback.port());
+  reactor->start();
+  rt_tcp_if->init();
+  ASSERT_TRUE(feedback.accept(2s));
+
+  mg400_interface::RealTimeData data = {};
+  data.len = sizeof(data);
+  const auto send_and_wait = [&](const uint64_t test_value) {
+      data.test_value = test_value;
+      if (!feedback.send(&data, sizeof(data))) {
+        return false;
+      }
+      const auto deadline = std::chrono::steady_clock::now() + 2s;
+      while (std::chrono::steady_clock::now() < deadline) {
+        const auto current = rt_tcp_if->getRealtimeData();
+        if (current && current->test_value == test_value) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+  // Connection set up and the first packet may allocate
+  ASSERT_TRUE(send_and_wait(1));
+
+  const uint64_t before = allocation_count.load();
+  bool received = true;
+  for (uint64_t i = 2; i < 1000 && received; ++i) {
+    received = send_and_wait(i);
+  }
+  const uint64_t allocated = allocation_count.load() - before;
+
+  ASSERT_TRUE(received);
+  EXPECT_EQ(allocated, 0u);
+
+  rt_tcp_if->disConnect();
+  reactor->stop();
+}
+
+TEST(TestRealTimeDataPool, FeedbackCountsDroppedPackets)
+{
+  LoopbackServer feedback;
+  auto reactor = std::make_shared<mg400_interface::IoReactor>();
+  auto rt_tcp_if = std::make_shared<mg400_interface::RealtimeFeedbackTcpInterface>(
+    "127.0.0.1", reactor, "", feedback.port());
+  reactor->start();
+  rt_tcp_if->init();
+  ASSERT_TRUE(feedback.accept(2s));
+
+  // Pin every packet received until no slot is left
+  std::vector<RealTimeDataPool::Handle> pinned;
+  mg400_interface::RealTimeData data = {};
+  data.len = sizeof(data);
+  for (uint64_t i = 1; i <= RealTimeDataPool::SIZE + 2; ++i) {
+    const uint64_t dropped = rt_tcp_if->countDroppedPackets();
+    data.test_value = i;
+    ASSERT_TRUE(feedback.send(&data, sizeof(data)));
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    bool is_done = false;
+    while (!is_done && std::chrono::steady_clock::now() < deadline) {
+      auto current = rt_tcp_if->getRealtimeData();
+      if (current && current->test_value == i) {
+        pinned.push_back(std::move(current));
+        is_done = true;
+      } else {
+        is_done = rt_tcp_if->countDroppedPackets() > dropped;
+      }
+    }
+    ASSERT_TRUE(is_done);
+  }
+
+  EXPECT_LT(pinned.size(), RealTimeDataPool::SIZE);
+  EXPECT_EQ(rt_tcp_if->countDroppedPackets(), RealTimeDataPool::SIZE + 2 - pinned.size());
+
+  rt_tcp_if->disConnect();
+  reactor->stop();
+}
+
+TEST(TestRealTimeDataPool, PublishedSlotStaysPinned)
+{
+  RealTimeDataPool pool;
+  EXPECT_FALSE(pool.latest());
+
+  auto first = pool.acquire();
+  first->test_value = 1;
+  pool.publish(std::move(first));
+  auto reader = pool.latest();
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(reader->test_value, 1u);
+
+  // Replaced, but still pinned by the reader
+  auto second = pool.acquire();
+  second->test_value = 2;
+  pool.publish(std::move(second));
+  EXPECT_EQ(pool.countFree(), RealTimeDataPool::SIZE - 2);
+  EXPECT_EQ(reader->test_value, 1u);
+  EXPECT_EQ(pool.latest()->test_value, 2u);
+
+  reader.reset();
+  EXPECT_EQ(pool.countFree(), RealTimeDataPool::SIZE - 1);
+  pool.publish(nullptr);
+  EXPECT_EQ(pool.countFree(), RealTimeDataPool::SIZE);
+}
@@ -0,0 +1,108 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <mg400_interface/tcp_interface/response_framer.hpp>
+
+using mg400_interface::ResponseFramer;
+
+// Returns the number of bytes accepted
+static size_t feed(ResponseFramer & framer, const std::string & data)
+{
+  size_t writable;
+  char * buf = framer.prepare(writable);
+  const size_t len = std::min(writable, data.size());
+  memcpy(buf, data.data(), len);
+  framer.commit(len);
+  return len;
+}
+
+TEST(TestResponseFramer, SplitAcrossReads)
+{
+  ResponseFramer framer;
+  std::string_view frame;
+
+  feed(framer, "0,{},Enable");
+  EXPECT_FALSE(framer.hasFrame());
+  EXPECT_FALSE(framer.next(frame));
+
+  feed(framer, "Robot();");
+  ASSERT_TRUE(framer.next(frame));
+  EXPECT_EQ(frame, "0,{},EnableRobot();");
+  EXPECT_EQ(framer.size(), 0u);
+}
+
+TEST(TestResponseFramer, SeveralFramesInOneRead)
+{
+  ResponseFramer framer;
+  std::string_view frame;
+
+  feed(framer, "0,{},ClearError();0,{5},RobotMode();0,{},Speed");
+  ASSERT_TRUE(framer.next(frame));
+  EXPECT_EQ(frame, "0,{},ClearError();");
+  ASSERT_TRUE(framer.next(frame));
+  EXPECT_EQ(frame, "0,{5},RobotMode();");
+  EXPECT_FALSE(framer.next(frame));
+  EXPECT_EQ(framer.size(), std::string("0,{},Speed").size());
+}
+
+TEST(TestResponseFramer, LongFrameIsKept)
+{
+  ResponseFramer framer;
+  std::string_view frame;
+
+  const std::string error_id =
+    "0,{[[18,22,23,24,25,26,27,28,29,30,31,32,33,34,35],"
+    "[16,17,18],[16,17,18],[16,17,18],[16,17,18],[],[]]},GetErrorID();";
+  ASSERT_GT(error_id.size(), 100u);
+  feed(framer, error_id);
+  ASSERT_TRUE(framer.next(frame));
+  EXPECT_EQ(frame, error_id);
+}
+
+TEST(TestResponseFramer, PartialFrameIsMovedToFront)
+{
+  ResponseFramer framer(16);
+  std::string_view frame;
+
+  EXPECT_EQ(feed(framer, "0,{},DO();0,{},"), 15u);
+  ASSERT_TRUE(framer.next(frame));
+  EXPECT_EQ(frame, "0,{},DO();");
+
+  EXPECT_EQ(feed(framer, "A"), 1u);
+  // The end of the buffer is reached: the partial frame makes room
+  EXPECT_EQ(feed(framer, "cc(3);"), 6u);
+  ASSERT_TRUE(framer.next(frame));
+  EXPECT_EQ(frame, "0,{},Acc(3);");
+}
+
+TEST(TestResponseFramer, FullBufferWithoutTerminator)
+{
+  ResponseFramer framer(8);
+  size_t writable;
+
+  EXPECT_EQ(feed(framer, "0123456789"), 8u);
+  EXPECT_FALSE(framer.hasFrame());
+  framer.prepare(writable);
+  EXPECT_EQ(writable, 0u);
+
+  framer.clear();
+  framer.prepare(writable);
+  EXPECT_EQ(writable, 8u);
+}
@@ -0,0 +1,195 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/tcp_interface/tcp_socket_handler.hpp>
+
+#include "../loopback_server.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::TcpSocketException;
+using mg400_interface::TcpSocketHandler;
+
+TEST(TestTcpSocketHandler, Connect)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+
+  ASSERT_NO_THROW(socket.connect(1s));
+  EXPECT_TRUE(socket.isConnected());
+  EXPECT_FALSE(socket.isConnecting());
+  ASSERT_TRUE(server.accept(1s));
+
+  socket.send("ping", 4);
+  EXPECT_EQ(server.recv(1s), "ping");
+}
+
+TEST(TestTcpSocketHandler, SendvWritesEveryBuffer)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+  ASSERT_NO_THROW(socket.connect(1s));
+  ASSERT_TRUE(server.accept(1s));
+
+  std::string first = "Tool(1)", second = "SpeedFactor(50)", third = "CP(100)";
+  iovec iov[] = {
+    {first.data(), first.size()},
+    {second.data(), second.size()},
+    {third.data(), third.size()}};
+  socket.sendv(iov, 3);
+
+  const std::string expected = first + second + third;
+  std::string received;
+  while (received.size() < expected.size()) {
+    const auto chunk = server.recv(1s);
+    if (chunk.empty()) {
+      break;
+    }
+    received += chunk;
+  }
+  EXPECT_EQ(received, expected);
+}
+
+TEST(TestTcpSocketHandler, ConnectRefusedFailsImmediately)
+{
+  uint16_t port;
+  {
+    LoopbackServer closed_server;
+    port = closed_server.port();
+  }
+  TcpSocketHandler socket("127.0.0.1", port);
+
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_THROW(socket.connect(1s), TcpSocketException);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 100ms);
+  EXPECT_FALSE(socket.isConnected());
+  EXPECT_LT(socket.getFd(), 0);
+}
+
+TEST(TestTcpSocketHandler, ConnectHonoursDeadline)
+{
+  // A full accept queue makes the server drop further SYNs,
+  // which is what an unreachable controller looks like.
+  LoopbackServer server(0, 0);
+  std::vector<std::unique_ptr<TcpSocketHandler>> fillers;
+  for (int i = 0; i < 4; ++i) {
+    fillers.emplace_back(std::make_unique<TcpSocketHandler>("127.0.0.1", server.port()));
+    try {
+      fillers.back()->connect(50ms);
+    } catch (const TcpSocketException &) {
+    }
+  }
+
+  TcpSocketHandler socket("127.0.0.1", server.port());
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_THROW(socket.connect(200ms), TcpSocketException);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_GE(elapsed, 190ms);
+  EXPECT_LT(elapsed, 300ms);
+  EXPECT_FALSE(socket.isConnected());
+  EXPECT_LT(socket.getFd(), 0);
+}
+
+TEST(TestTcpSocketHandler, StartConnectIsNonBlocking)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+
+  if (!socket.startConnect(1s)) {
+    EXPECT_TRUE(socket.isConnecting());
+    pollfd pfd = {socket.getFd(), POLLOUT, 0};
+    ASSERT_EQ(::poll(&pfd, 1, 1000), 1);
+    ASSERT_NO_THROW(socket.finishConnect());
+  }
+  EXPECT_TRUE(socket.isConnected());
+  EXPECT_FALSE(socket.isConnecting());
+}
+
+TEST(TestTcpSocketHandler, ProfileIsAppliedOnConnect)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+  mg400_interface::SocketProfile profile;
+  profile.tcp_nodelay = true;
+  profile.keepalive = true;
+  profile.keepalive_idle = 7;
+  profile.user_timeout = 1500;
+  socket.setProfile(profile);
+  ASSERT_NO_THROW(socket.connect(1s));
+
+  const auto get_option = [&socket](const int level, const int name) {
+      int value = 0;
+      socklen_t len = sizeof(value);
+      ::getsockopt(socket.getFd(), level, name, &value, &len);
+      return value;
+    };
+  EXPECT_NE(get_option(IPPROTO_TCP, TCP_NODELAY), 0);
+  EXPECT_NE(get_option(SOL_SOCKET, SO_KEEPALIVE), 0);
+  EXPECT_EQ(get_option(IPPROTO_TCP, TCP_KEEPIDLE), 7);
+  EXPECT_EQ(get_option(IPPROTO_TCP, TCP_USER_TIMEOUT), 1500);
+}
+
+TEST(TestTcpSocketHandler, RxTimestampIsArrivalTime)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+  socket.setRxTimestamps(true);
+  ASSERT_NO_THROW(socket.connect(1s));
+  ASSERT_TRUE(server.accept(1s));
+
+  timespec before;
+  clock_gettime(CLOCK_REALTIME, &before);
+  server.send("0,{},RobotMode();");
+  // Read well after the data arrived
+  std::this_thread::sleep_for(50ms);
+
+  timespec read_time;
+  clock_gettime(CLOCK_REALTIME, &read_time);
+  char buf[64];
+  timespec stamp = {};
+  ASSERT_GT(socket.tryRecv(buf, sizeof(buf), stamp), 0u);
+
+  const auto to_ns = [](const timespec & ts) {
+      return std::chrono::nanoseconds(
+        static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec);
+    };
+  EXPECT_GE(to_ns(stamp), to_ns(before));
+  EXPECT_LT(to_ns(stamp), to_ns(read_time) - 25ms);
+}
+
+TEST(TestTcpSocketHandler, DisconnectWakesBlockedReceiver)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+  ASSERT_NO_THROW(socket.connect(1s));
+  ASSERT_TRUE(server.accept(1s));
+
+  const auto start = std::chrono::steady_clock::now();
+  std::thread receiver([&socket] {
+      char buf[4];
+      EXPECT_THROW(socket.recv(buf, sizeof(buf), 5s), TcpSocketException);
+    });
+  std::this_thread::sleep_for(50ms);
+  socket.disConnect();
+  receiver.join();
+
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+  EXPECT_FALSE(socket.isConnected());
+  EXPECT_THROW(socket.send("ping", 4), TcpSocketException);
+}
@@ -0,0 +1,130 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/tcp_interface/tcp_socket_handler.hpp>
+#include <mg400_interface/tcp_interface/wire_tap.hpp>
+
+#include "../loopback_server.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::TcpSocketHandler;
+using mg400_interface::WireTap;
+using mg400_interface::WireTapReader;
+
+class TestWireTap : public ::testing::Test
+{
+protected:
+  std::string path_;
+
+  virtual void SetUp()
+  {
+    this->path_ = testing::TempDir() + "test_wire_tap.bin";
+  }
+
+  virtual void TearDown()
+  {
+    WireTap::stop();
+    std::remove(this->path_.c_str());
+  }
+
+  std::vector<WireTapReader::Record> readAll()
+  {
+    std::vector<WireTapReader::Record> records;
+    WireTapReader reader(this->path_);
+    WireTapReader::Record record;
+    while (reader.next(record)) {
+      records.push_back(record);
+    }
+    return records;
+  }
+};
+
+TEST_F(TestWireTap, CaptureSentAndReceivedFrames)
+{
+  LoopbackServer server;
+  TcpSocketHandler socket("127.0.0.1", server.port());
+  socket.connect(1s);
+  ASSERT_TRUE(server.accept(1s));
+
+  ASSERT_TRUE(WireTap::start(this->path_));
+  EXPECT_TRUE(WireTap::isEnabled());
+
+  socket.send("EnableRobot()", 13);
+  ASSERT_EQ(server.recv(1s), "EnableRobot()");
+  server.send("0,{},EnableRobot();");
+  char buf[64];
+  ASSERT_TRUE(socket.recv(buf, 19, 1s));
+  WireTap::stop();
+  EXPECT_FALSE(WireTap::isEnabled());
+
+  const auto records = this->readAll();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].direction, WireTap::Direction::SEND);
+  EXPECT_EQ(records[0].port, server.port());
+  EXPECT_EQ(records[0].payload, "EnableRobot()");
+  EXPECT_EQ(records[1].direction, WireTap::Direction::RECV);
+  EXPECT_EQ(records[1].payload, "0,{},EnableRobot();");
+  EXPECT_LE(records[0].stamp, records[1].stamp);
+  EXPECT_EQ(WireTap::getDroppedCount(), 0u);
+}
+
+TEST_F(TestWireTap, NothingRecordedWhileDisabled)
+{
+  ASSERT_TRUE(WireTap::start(this->path_));
+  WireTap::stop();
+
+  WireTap::record(WireTap::Direction::SEND, 29999, "ClearError()", 12);
+  EXPECT_TRUE(this->readAll().empty());
+}
+
+TEST_F(TestWireTap, LongFramesAreSplit)
+{
+  ASSERT_TRUE(WireTap::start(this->path_));
+  const std::string frame(WireTap::MAX_PAYLOAD + 10, 'x');
+  WireTap::record(WireTap::Direction::RECV, 30004, frame.data(), frame.size());
+  WireTap::stop();
+
+  const auto records = this->readAll();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].payload.size(), WireTap::MAX_PAYLOAD);
+  EXPECT_EQ(records[1].payload.size(), 10u);
+}
+
+TEST_F(TestWireTap, CaptureFromSeveralThreads)
+{
+  ASSERT_TRUE(WireTap::start(this->path_));
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; ++i) {
+    producers.emplace_back(
+      [i]() {
+        for (int j = 0; j < 32; ++j) {
+          const std::string frame = std::to_string(i) + ":" + std::to_string(j);
+          WireTap::record(WireTap::Direction::SEND, 30003, frame.data(), frame.size());
+        }
+      });
+  }
+  for (auto & producer : producers) {
+    producer.join();
+  }
+  WireTap::stop();
+
+  EXPECT_EQ(this->readAll().size() + WireTap::getDroppedCount(), 4u * 32u);
+}
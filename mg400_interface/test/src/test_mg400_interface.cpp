@@ -0,0 +1,185 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <mg400_interface/mg400_interface.hpp>
+
+#include "loopback_server.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+
+class TestMG400Interface : public ::testing::Test
+{
+protected:
+  // Ephemeral ports: never taken by another test or a real controller
+  LoopbackServer dashboard_;
+  LoopbackServer motion_;
+  LoopbackServer feedback_;
+  std::unique_ptr<mg400_interface::MG400Interface> interface_;
+
+  virtual void SetUp()
+  {
+    this->interface_ = std::make_unique<mg400_interface::MG400Interface>(
+      "127.0.0.1",
+      mg400_interface::MG400Interface::Ports{
+        this->dashboard_.port(), this->motion_.port(), this->feedback_.port()});
+    ASSERT_TRUE(this->interface_->configure(""));
+  }
+
+  virtual void TearDown()
+  {
+    this->interface_->deactivate();
+  }
+};
+
+TEST_F(TestMG400Interface, ActivateReturnsOnceFeedbackArrives) {
+  // The controller starts streaming a while after the connection is accepted.
+  auto & feedback = this->feedback_;
+  std::thread controller([&feedback]() {
+      if (!feedback.accept(2s)) {
+        return;
+      }
+      std::this_thread::sleep_for(300ms);
+      mg400_interface::RealTimeData data = {};
+      data.len = sizeof(data);
+      feedback.send(&data, sizeof(data));
+    });
+
+  const auto start = std::chrono::steady_clock::now();
+  const bool ret = this->interface_->activate();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  controller.join();
+
+  ASSERT_TRUE(ret);
+  EXPECT_TRUE(this->interface_->ok());
+  EXPECT_LT(elapsed, 1s);
+  EXPECT_GE(this->interface_->getTimeToReady(), 300ms);
+  EXPECT_LE(this->interface_->getTimeToReady(), elapsed);
+}
+
+TEST_F(TestMG400Interface, DeactivateIsImmediate) {
+  auto & feedback = this->feedback_;
+  std::thread controller([&feedback]() {
+      if (feedback.accept(2s)) {
+        mg400_interface::RealTimeData data = {};
+        data.len = sizeof(data);
+        feedback.send(&data, sizeof(data));
+      }
+    });
+  ASSERT_TRUE(this->interface_->activate());
+  controller.join();
+
+  // The dashboard never replies, so this request blocks until teardown.
+  auto commander = this->interface_->dashboard_commander;
+  auto pending = std::async(
+    std::launch::async, [commander]() {
+      try {
+        commander->clearError();
+      } catch (...) {
+      }
+    });
+  ASSERT_EQ(pending.wait_for(50ms), std::future_status::timeout);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(this->interface_->deactivate());
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // Used to take over 1 s: well under that on a loaded machine too
+  EXPECT_LT(elapsed, 200ms);
+  EXPECT_EQ(pending.wait_for(200ms), std::future_status::ready);
+  EXPECT_FALSE(this->interface_->ok());
+}
+
+TEST_F(TestMG400Interface, CommanderIsKeptAcrossReconnections) {
+  auto & feedback = this->feedback_;
+  const auto serve = [&feedback]() {
+      if (feedback.accept(2s)) {
+        mg400_interface::RealTimeData data = {};
+        data.len = sizeof(data);
+        feedback.send(&data, sizeof(data));
+      }
+    };
+  std::thread controller(serve);
+  ASSERT_TRUE(this->interface_->activate());
+  controller.join();
+  const auto commander = this->interface_->dashboard_commander;
+  ASSERT_NE(commander, nullptr);
+
+  // The plugins keep the commander given once
+  this->interface_->deactivate();
+  controller = std::thread(serve);
+  ASSERT_TRUE(this->interface_->activate());
+  controller.join();
+  EXPECT_EQ(this->interface_->dashboard_commander, commander);
+}
+
+TEST_F(TestMG400Interface, PreemptionFailsAtOnceWhileDisconnected) {
+  const auto preemptor = this->interface_->motion_preemptor;
+  preemptor->acquire();
+  const auto owner = preemptor->acquire();
+
+  // ResetRobot() cannot be sent: not left pending until the stop timeout
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(preemptor->waitForStop(owner));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 500ms);
+  EXPECT_EQ(preemptor->getStopLatency().errors, 1u);
+}
+
+TEST_F(TestMG400Interface, DashboardResponseSplitAcrossReads) {
+  auto & dashboard = this->dashboard_;
+  auto & feedback = this->feedback_;
+  std::thread controller([&dashboard, &feedback]() {
+      if (!feedback.accept(2s) || !dashboard.accept(2s)) {
+        return;
+      }
+      mg400_interface::RealTimeData data = {};
+      data.len = sizeof(data);
+      feedback.send(&data, sizeof(data));
+
+      if (dashboard.recv(2s).find("ClearError()") == std::string::npos) {
+        return;
+      }
+      // A stale reply, then the real one in two pieces
+      dashboard.send("0,{},EnableRobot();0,{},Clear");
+      std::this_thread::sleep_for(20ms);
+      dashboard.send("Error();");
+    });
+  ASSERT_TRUE(this->interface_->activate());
+
+  EXPECT_NO_THROW(this->interface_->dashboard_commander->clearError());
+  controller.join();
+}
+
+TEST_F(TestMG400Interface, ActivateFailsWithoutController) {
+  // Ports nobody listens on any more
+  mg400_interface::MG400Interface::Ports ports;
+  {
+    LoopbackServer dashboard, motion, feedback;
+    ports = {dashboard.port(), motion.port(), feedback.port()};
+  }
+  this->interface_ = std::make_unique<mg400_interface::MG400Interface>("127.0.0.1", ports);
+  ASSERT_TRUE(this->interface_->configure(""));
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(this->interface_->activate());
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_FALSE(this->interface_->ok());
+  EXPECT_LT(elapsed, 3s);
+}
@@ -0,0 +1,95 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <mg400_interface/mpsc_queue.hpp>
+
+using mg400_interface::MpscQueue;
+
+TEST(TestMpscQueue, Fifo)
+{
+  MpscQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+
+  int value = 0;
+  EXPECT_FALSE(queue.pop(value));
+  for (int i = 1; i <= 3; ++i) {
+    queue.push(i);
+  }
+  EXPECT_FALSE(queue.empty());
+  for (int i = 1; i <= 3; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(TestMpscQueue, ReleasesPoppedValues)
+{
+  auto shared = std::make_shared<int>(1);
+  {
+    MpscQueue<std::shared_ptr<int>> queue;
+    queue.push(shared);
+    queue.push(shared);
+    EXPECT_EQ(shared.use_count(), 3);
+
+    std::shared_ptr<int> value;
+    ASSERT_TRUE(queue.pop(value));
+    value.reset();
+    EXPECT_EQ(shared.use_count(), 2);
+  }
+  // Destroyed with one element left
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(TestMpscQueue, ConcurrentProducers)
+{
+  constexpr int PRODUCERS = 4;
+  constexpr int COUNT = 50000;
+  MpscQueue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; ++p) {
+    producers.emplace_back(
+      [&queue, p]() {
+        for (int i = 0; i < COUNT; ++i) {
+          queue.push({p, i});
+        }
+      });
+  }
+
+  // Each producer's elements come out in the order they were pushed
+  std::vector<int> next(PRODUCERS, 0);
+  int received = 0;
+  while (received < PRODUCERS * COUNT) {
+    std::pair<int, int> value;
+    if (!queue.pop(value)) {
+      continue;
+    }
+    ASSERT_EQ(value.second, next[value.first]);
+    ++next[value.first];
+    ++received;
+  }
+  for (auto & producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,105 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <mg400_interface/script_tracker.hpp>
+
+using namespace std::chrono_literals;  // NOLINT
+using mg400_interface::ScriptTracker;
+using mg400_msgs::msg::RobotMode;
+using State = ScriptTracker::State;
+
+// Feedback period of the controller
+constexpr int64_t MS8 = 8000000;
+
+TEST(TestScriptTracker, RunsToCompletion)
+{
+  ScriptTracker tracker;
+  tracker.start(0);
+  EXPECT_EQ(tracker.getProgress().state, State::STARTING);
+
+  // Still ENABLE until the controller picks the script up
+  EXPECT_FALSE(tracker.update(RobotMode::ENABLE, MS8));
+  EXPECT_TRUE(tracker.update(RobotMode::RUNNING, 2 * MS8));
+  EXPECT_FALSE(tracker.update(RobotMode::RUNNING, 3 * MS8));
+  EXPECT_TRUE(tracker.update(RobotMode::PAUSE, 4 * MS8));
+  EXPECT_FALSE(tracker.update(RobotMode::PAUSE, 6 * MS8));
+  EXPECT_TRUE(tracker.update(RobotMode::RUNNING, 7 * MS8));
+  EXPECT_FALSE(tracker.isDone());
+  EXPECT_TRUE(tracker.update(RobotMode::ENABLE, 8 * MS8));
+
+  EXPECT_TRUE(tracker.isDone());
+  const auto progress = tracker.getProgress();
+  EXPECT_EQ(progress.state, State::FINISHED);
+  EXPECT_EQ(progress.running, std::chrono::nanoseconds(3 * MS8));
+  EXPECT_EQ(progress.paused, std::chrono::nanoseconds(3 * MS8));
+  EXPECT_EQ(progress.pauses, 1u);
+
+  // Nothing changes once over
+  EXPECT_FALSE(tracker.update(RobotMode::RUNNING, 9 * MS8));
+  EXPECT_EQ(tracker.getProgress().state, State::FINISHED);
+}
+
+TEST(TestScriptTracker, IgnoresPacketsAlreadySeen)
+{
+  ScriptTracker tracker;
+  tracker.start(10 * MS8);
+  EXPECT_FALSE(tracker.update(RobotMode::RUNNING, 10 * MS8));
+  EXPECT_TRUE(tracker.update(RobotMode::RUNNING, 11 * MS8));
+  EXPECT_FALSE(tracker.update(RobotMode::ENABLE, 11 * MS8));
+  EXPECT_EQ(tracker.getProgress().state, State::RUNNING);
+}
+
+TEST(TestScriptTracker, Stopped)
+{
+  ScriptTracker tracker;
+  tracker.start(0);
+  tracker.update(RobotMode::RUNNING, MS8);
+  tracker.stop();
+  EXPECT_TRUE(tracker.update(RobotMode::ENABLE, 2 * MS8));
+  EXPECT_EQ(tracker.getProgress().state, State::STOPPED);
+
+  // Stopped before it was seen running
+  tracker.start(0);
+  tracker.stop();
+  EXPECT_TRUE(tracker.update(RobotMode::ENABLE, MS8));
+  EXPECT_EQ(tracker.getProgress().state, State::STOPPED);
+}
+
+TEST(TestScriptTracker, Failed)
+{
+  ScriptTracker tracker(100ms);
+  tracker.start(0);
+  tracker.update(RobotMode::RUNNING, MS8);
+  EXPECT_TRUE(tracker.update(RobotMode::ERROR, 2 * MS8));
+  EXPECT_EQ(tracker.getProgress().state, State::FAILED);
+
+  // Never started
+  tracker.start(0);
+  EXPECT_FALSE(tracker.update(RobotMode::ENABLE, 50000000));
+  EXPECT_TRUE(tracker.update(RobotMode::ENABLE, 101000000));
+  EXPECT_EQ(tracker.getProgress().state, State::FAILED);
+
+  tracker.start(0);
+  EXPECT_TRUE(tracker.update(RobotMode::DISABLED, MS8));
+  EXPECT_EQ(tracker.getProgress().state, State::FAILED);
+}
+
+TEST(TestScriptTracker, ToString)
+{
+  EXPECT_STREQ(ScriptTracker::toString(State::STARTING), "STARTING");
+  EXPECT_STREQ(ScriptTracker::toString(State::PAUSED), "PAUSED");
+  EXPECT_STREQ(ScriptTracker::toString(State::FAILED), "FAILED");
+}
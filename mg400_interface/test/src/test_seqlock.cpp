@@ -0,0 +1,74 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <mg400_interface/seqlock.hpp>
+
+using mg400_interface::Seqlock;
+
+TEST(TestSeqlock, LoadReturnsLastStore)
+{
+  Seqlock<std::array<double, 4>> seqlock;
+  EXPECT_EQ(seqlock.load(), (std::array<double, 4>{}));
+
+  seqlock.store({1.0, 2.0, 3.0, 4.0});
+  EXPECT_EQ(seqlock.load(), (std::array<double, 4>{1.0, 2.0, 3.0, 4.0}));
+  EXPECT_EQ(seqlock.read([](const std::array<double, 4> & value) {return value[2];}), 3.0);
+}
+
+TEST(TestSeqlock, ReadersNeverSeeTornValues)
+{
+  // Every element equals the sequence number it was written with
+  using Value = std::array<uint64_t, 32>;
+  Seqlock<Value> seqlock;
+  std::atomic<bool> done(false);
+
+  std::vector<std::thread> readers;
+  std::atomic<uint64_t> torn(0);
+  for (int i = 0; i < 3; ++i) {
+    readers.emplace_back(
+      [&]() {
+        uint64_t last = 0;
+        while (!done.load()) {
+          const Value value = seqlock.load();
+          for (const auto & element : value) {
+            if (element != value[0]) {
+              torn.fetch_add(1);
+            }
+          }
+          // The single writer only moves forward
+          EXPECT_GE(value[0], last);
+          last = value[0];
+        }
+      });
+  }
+
+  Value value;
+  for (uint64_t seq = 1; seq <= 200000; ++seq) {
+    value.fill(seq);
+    seqlock.store(value);
+  }
+  done.store(true);
+  for (auto & reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(torn.load(), 0u);
+  EXPECT_EQ(seqlock.load()[0], 200000u);
+}
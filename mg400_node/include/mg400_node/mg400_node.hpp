@@ -19,6 +19,7 @@
 #include <vector>
 #include <memory>
 
+#include <builtin_interfaces/msg/duration.hpp>
 #include <mg400_msgs/msg/robot_mode.hpp>
 #include <mg400_plugin_base/api_loader_base.hpp>
 #include <mg400_plugin_base/api_plugin_base.hpp>
@@ -61,6 +62,9 @@ private:
 
   rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr joint_state_pub_;
   rclcpp::Publisher<mg400_msgs::msg::RobotMode>::SharedPtr robot_mode_pub_;
+  rclcpp::Publisher<builtin_interfaces::msg::Duration>::SharedPtr time_to_ready_pub_;
+
+  OnSetParametersCallbackHandle::SharedPtr param_callback_handle_;
 
 public:
   MG400Node() = delete;
@@ -76,6 +80,11 @@ public:
 private:
   void runTimer();
   void cancelTimer();
+  mg400_interface::SocketProfile declareSocketProfile(
+    const std::string &, const mg400_interface::SocketProfile &);
+  void publishTimeToReady();
+  rcl_interfaces::msg::SetParametersResult onSetParameters(
+    const std::vector<rclcpp::Parameter> &);
 };
 }  // namespace mg400_node
 
@@ -33,6 +33,13 @@ MG400Node::MG400Node(const rclcpp::NodeOptions & options)
     "motion_api_plugins", this->default_motion_api_plugins_);
 
 
+  this->declare_parameter<std::string>("wire_tap.file", "mg400_wire_tap.bin");
+  if (this->declare_parameter<bool>("wire_tap.enabled", false)) {
+    mg400_interface::WireTap::start(this->get_parameter("wire_tap.file").as_string());
+  }
+  this->param_callback_handle_ = this->add_on_set_parameters_callback(
+    std::bind(&MG400Node::onSetParameters, this, std::placeholders::_1));
+
   this->interface_ =
     std::make_shared<mg400_interface::MG400Interface>(ip_address);
 
@@ -42,10 +49,29 @@ MG400Node::MG400Node(const rclcpp::NodeOptions & options)
     return;
   }
 
+  // Commands are small and latency sensitive: disable Nagle, and ACK replies
+  // immediately so the controller's own Nagle does not hold back the next one.
+  mg400_interface::SocketProfile command_profile;
+  command_profile.tcp_nodelay = true;
+  command_profile.tcp_quickack = true;
+  this->interface_->setSocketProfiles(
+    this->declareSocketProfile("dashboard", command_profile),
+    this->declareSocketProfile("motion", command_profile),
+    this->declareSocketProfile("feedback", mg400_interface::SocketProfile()));
+
+  // Feedback arrives every 8 ms: older means it stalled, ask the dashboard instead
+  this->interface_->setFeedbackMaxAge(
+    std::chrono::milliseconds(this->declare_parameter<int>("feedback_max_age_ms", 50)));
+
+  this->time_to_ready_pub_ =
+    this->create_publisher<builtin_interfaces::msg::Duration>(
+    "time_to_ready", rclcpp::QoS(1).transient_local());
+
   while (!this->interface_->activate()) {
     RCLCPP_INFO(this->get_logger(), "Try reconnecting...");
     rclcpp::sleep_for(5s);
   }
+  this->publishTimeToReady();
 
   this->dashboard_api_loader_ =
     std::make_shared<mg400_plugin_base::DashboardApiLoader>();
@@ -66,6 +92,34 @@ MG400Node::~MG400Node()
   if (this->interface_) {
     this->interface_->deactivate();
   }
+  mg400_interface::WireTap::stop();
+}
+
+rcl_interfaces::msg::SetParametersResult MG400Node::onSetParameters(
+  const std::vector<rclcpp::Parameter> & parameters)
+{
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+
+  std::string file = this->get_parameter("wire_tap.file").as_string();
+  for (const auto & param : parameters) {
+    if (param.get_name() == "wire_tap.file") {
+      file = param.as_string();
+    }
+  }
+
+  for (const auto & param : parameters) {
+    if (param.get_name() != "wire_tap.enabled") {
+      continue;
+    }
+    if (!param.as_bool()) {
+      mg400_interface::WireTap::stop();
+    } else if (!mg400_interface::WireTap::start(file)) {
+      result.successful = false;
+      result.reason = "Could not open " + file;
+    }
+  }
+  return result;
 }
 
 void MG400Node::onInit()
@@ -100,12 +154,15 @@ void MG400Node::onJointStateTimer()
 {
   if (this->interface_->ok()) {
     static std::array<double, 4> joint_states;
-    this->interface_->realtime_tcp_interface->getCurrentJointStates(joint_states);
+    rclcpp::Time stamp;
+    this->interface_->realtime_tcp_interface->getCurrentJointStates(joint_states, stamp);
 
+    // Stamped with the arrival time of the feedback packet, not the publish time
     this->joint_state_pub_->publish(
       mg400_interface::JointHandler::getJointState(
         joint_states,
-        this->interface_->realtime_tcp_interface->frame_id_prefix));
+        this->interface_->realtime_tcp_interface->frame_id_prefix,
+        stamp));
   }
 }
 
@@ -167,10 +224,52 @@ void MG400Node::onInterfaceCheckTimer()
       RCLCPP_INFO(this->get_logger(), "Try reconnecting...");
       rclcpp::sleep_for(5s);
     }
+    this->publishTimeToReady();
     this->runTimer();
   }
 }
 
+mg400_interface::SocketProfile MG400Node::declareSocketProfile(
+  const std::string & channel, const mg400_interface::SocketProfile & defaults)
+{
+  const std::string prefix = "socket." + channel + ".";
+  mg400_interface::SocketProfile profile;
+  profile.tcp_nodelay =
+    this->declare_parameter<bool>(prefix + "tcp_nodelay", defaults.tcp_nodelay);
+  profile.tcp_quickack =
+    this->declare_parameter<bool>(prefix + "tcp_quickack", defaults.tcp_quickack);
+  profile.rcvbuf =
+    this->declare_parameter<int>(prefix + "rcvbuf", defaults.rcvbuf);
+  profile.sndbuf =
+    this->declare_parameter<int>(prefix + "sndbuf", defaults.sndbuf);
+  profile.priority =
+    this->declare_parameter<int>(prefix + "priority", defaults.priority);
+  profile.busy_poll =
+    this->declare_parameter<int>(prefix + "busy_poll", defaults.busy_poll);
+  profile.keepalive =
+    this->declare_parameter<bool>(prefix + "keepalive", defaults.keepalive);
+  profile.keepalive_idle =
+    this->declare_parameter<int>(prefix + "keepalive_idle", defaults.keepalive_idle);
+  profile.keepalive_interval =
+    this->declare_parameter<int>(prefix + "keepalive_interval", defaults.keepalive_interval);
+  profile.keepalive_count =
+    this->declare_parameter<int>(prefix + "keepalive_count", defaults.keepalive_count);
+  profile.user_timeout =
+    this->declare_parameter<int>(prefix + "user_timeout", defaults.user_timeout);
+
+  RCLCPP_INFO(
+    this->get_logger(), "%s socket profile : %s",
+    channel.c_str(), profile.toString().c_str());
+  return profile;
+}
+
+void MG400Node::publishTimeToReady()
+{
+  const builtin_interfaces::msg::Duration msg =
+    rclcpp::Duration(this->interface_->getTimeToReady());
+  this->time_to_ready_pub_->publish(msg);
+}
+
 void MG400Node::runTimer()
 {
   this->joint_state_timer_ = this->create_wall_timer(
@@ -35,6 +35,6 @@ public:
 
 private:
   void onServiceCall(
-    const ServiceT::Request::SharedPtr, ServiceT::Response::SharedPtr);
+    const std::shared_ptr<rmw_request_id_t>, const ServiceT::Request::SharedPtr);
 };
 }  // mg400_plugin
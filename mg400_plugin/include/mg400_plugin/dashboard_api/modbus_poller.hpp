@@ -0,0 +1,60 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <mg400_interface/commander/modbus_poller.hpp>
+#include <mg400_plugin_base/api_plugin_base.hpp>
+#include <mg400_msgs/msg/modbus_values.hpp>
+
+namespace mg400_plugin
+{
+// Publishes changed values of the configured Modbus ranges at a fixed rate.
+// Ranges are given per table as flat [addr, count, addr, count, ...] arrays.
+class ModbusPoller final
+  : public mg400_plugin_base::DashboardApiPluginBase
+{
+public:
+  using MsgT = mg400_msgs::msg::ModbusValues;
+
+private:
+  using Table = mg400_interface::ModbusPoller::Table;
+
+  mg400_interface::ModbusPoller::UniquePtr poller_;
+  std::array<rclcpp::Publisher<MsgT>::SharedPtr, 4> pubs_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+  std::string ip_;
+  int port_;
+  int slave_id_;
+  bool is_rtu_;
+
+public:
+  ~ModbusPoller();
+
+  void configure(
+    const mg400_interface::DashboardCommander::SharedPtr,
+    const rclcpp::Node::SharedPtr,
+    const mg400_interface::MG400Interface::SharedPtr) override;
+
+private:
+  void addRanges(const Table, const std::string &);
+  void onTimer();
+  void publish(const std::vector<mg400_interface::ModbusPoller::Change> &);
+};
+}  // namespace mg400_plugin
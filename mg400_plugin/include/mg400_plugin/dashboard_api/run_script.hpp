@@ -0,0 +1,59 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <mg400_interface/script_tracker.hpp>
+#include <mg400_msgs/action/run_script.hpp>
+#include <mg400_msgs/msg/robot_mode.hpp>
+#include <mg400_plugin_base/api_plugin_base.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+
+namespace mg400_plugin
+{
+// Runs a script saved on the controller. Progress and completion follow the
+// robot mode of the realtime feedback; canceling the goal stops the script.
+class RunScript final
+  : public mg400_plugin_base::DashboardApiPluginBase
+{
+public:
+  using ActionT = mg400_msgs::action::RunScript;
+  using GoalHandle = rclcpp_action::ServerGoalHandle<ActionT>;
+
+private:
+  rclcpp_action::Server<ActionT>::SharedPtr action_server_;
+  // One script at a time: the controller runs only one
+  std::atomic<bool> is_busy_{false};
+
+public:
+  void configure(
+    const mg400_interface::DashboardCommander::SharedPtr,
+    const rclcpp::Node::SharedPtr,
+    const mg400_interface::MG400Interface::SharedPtr) override;
+
+private:
+  rclcpp_action::GoalResponse handle_goal(
+    const rclcpp_action::GoalUUID &, ActionT::Goal::ConstSharedPtr);
+  rclcpp_action::CancelResponse handle_cancel(
+    const std::shared_ptr<GoalHandle>);
+  void handle_accepted(const std::shared_ptr<GoalHandle>);
+  void execute(const std::shared_ptr<GoalHandle>);
+
+  template<typename T>
+  static void fill(const mg400_interface::ScriptTracker::Progress &, T &);
+};
+}  // namespace mg400_plugin
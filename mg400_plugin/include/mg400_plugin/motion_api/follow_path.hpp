@@ -0,0 +1,64 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <mg400_msgs/action/follow_path.hpp>
+#include <mg400_msgs/msg/robot_mode.hpp>
+#include <mg400_plugin_base/api_plugin_base.hpp>
+#include <h6x_tf_handler/pose_tf_handler.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+#include <tf2/utils.h>
+
+namespace mg400_plugin
+{
+// Streams a path of MovJ / MovL waypoints through the motion queue, blending
+// them with CP so the arm does not stop at every waypoint. At most
+// `follow_path.max_in_flight` of them are left with the controller at once.
+// Owns the arm as MovJ / MovL goals do: either preempts the other.
+class FollowPath final : public mg400_plugin_base::MotionApiPluginBase
+{
+public:
+  using ActionT = mg400_msgs::action::FollowPath;
+  using GoalHandle = rclcpp_action::ServerGoalHandle<ActionT>;
+
+private:
+  rclcpp_action::Server<ActionT>::SharedPtr action_server_;
+  std::shared_ptr<h6x_tf_handler::PoseTfHandler> tf_handler_;
+  // One path at a time: they would share the queue of the controller
+  std::atomic<bool> is_busy_{false};
+
+public:
+  void configure(
+    const mg400_interface::MotionCommander::SharedPtr,
+    const rclcpp::Node::SharedPtr,
+    const mg400_interface::MG400Interface::SharedPtr)
+  override;
+
+private:
+  rclcpp_action::GoalResponse handle_goal(
+    const rclcpp_action::GoalUUID &, ActionT::Goal::ConstSharedPtr);
+  rclcpp_action::CancelResponse handle_cancel(
+    const std::shared_ptr<GoalHandle>);
+  void handle_accepted(const std::shared_ptr<GoalHandle>);
+  void execute(
+    const std::shared_ptr<GoalHandle>, const mg400_interface::MotionPreemptor::Owner);
+
+  static bool fill(
+    const mg400_interface::MotionQueue::Record &, mg400_msgs::msg::WaypointProgress &);
+};
+}  // namespace mg400_plugin
@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include <mg400_msgs/action/mov_l.hpp>
 #include <mg400_msgs/msg/robot_mode.hpp>
 #include <mg400_plugin_base/api_plugin_base.hpp>
@@ -33,6 +37,11 @@ private:
   rclcpp_action::Server<ActionT>::SharedPtr action_server_;
   std::shared_ptr<h6x_tf_handler::PoseTfHandler> tf_handler_;
 
+  using Owner = mg400_interface::MotionPreemptor::Owner;
+  // Owner of the arm for each goal executing, to stop it on cancel
+  std::mutex owners_mutex_;
+  std::map<rclcpp_action::GoalUUID, Owner> owners_;
+
 public:
   void configure(
     const mg400_interface::MotionCommander::SharedPtr,
@@ -46,6 +55,6 @@ private:
   rclcpp_action::CancelResponse handle_cancel(
     const std::shared_ptr<GoalHandle>);
   void handle_accepted(const std::shared_ptr<GoalHandle>);
-  void execute(const std::shared_ptr<GoalHandle>);
+  void execute(const std::shared_ptr<GoalHandle>, const Owner);
 };
 }  // namespace mg400_plugin
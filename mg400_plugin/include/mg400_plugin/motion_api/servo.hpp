@@ -0,0 +1,63 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <geometry_msgs/msg/pose_stamped.hpp>
+#include <mg400_interface/commander/servo_streamer.hpp>
+#include <mg400_msgs/msg/robot_mode.hpp>
+#include <mg400_msgs/msg/servo_stats.hpp>
+#include <mg400_plugin_base/api_plugin_base.hpp>
+#include <h6x_tf_handler/pose_tf_handler.hpp>
+#include <sensor_msgs/msg/joint_state.hpp>
+#include <tf2/utils.h>
+
+namespace mg400_plugin
+{
+// Servo mode: tracks the latest setpoint on `servo/joint_setpoint` (ServoJ)
+// or `servo/pose_setpoint` (ServoP) with commands streamed every
+// `servo.period_ms`. Streaming stops once setpoints stop coming, and
+// setpoints are rejected while a MovJ, MovL or FollowPath goal owns the arm.
+class Servo final : public mg400_plugin_base::MotionApiPluginBase
+{
+public:
+  using JointMsgT = sensor_msgs::msg::JointState;
+  using PoseMsgT = geometry_msgs::msg::PoseStamped;
+  using StatsMsgT = mg400_msgs::msg::ServoStats;
+
+private:
+  mg400_interface::ServoStreamer::UniquePtr streamer_;
+  std::shared_ptr<h6x_tf_handler::PoseTfHandler> tf_handler_;
+  rclcpp::Subscription<JointMsgT>::SharedPtr joint_sub_;
+  rclcpp::Subscription<PoseMsgT>::SharedPtr pose_sub_;
+  rclcpp::Publisher<StatsMsgT>::SharedPtr stats_pub_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+public:
+  void configure(
+    const mg400_interface::MotionCommander::SharedPtr,
+    const rclcpp::Node::SharedPtr,
+    const mg400_interface::MG400Interface::SharedPtr)
+  override;
+
+private:
+  void onJointSetpoint(const JointMsgT::ConstSharedPtr);
+  void onPoseSetpoint(const PoseMsgT::ConstSharedPtr);
+  void onTimer();
+  bool isServoable();
+};
+}  // namespace mg400_plugin
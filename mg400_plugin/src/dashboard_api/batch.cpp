@@ -0,0 +1,69 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mg400_plugin/dashboard_api/batch.hpp>
+
+namespace mg400_plugin
+{
+void Batch::configure(
+  const mg400_interface::DashboardCommander::SharedPtr commander,
+  const rclcpp::Node::SharedPtr node,
+  const mg400_interface::MG400Interface::SharedPtr mg400_if)
+{
+  if (!this->configure_base(commander, node, mg400_if)) {
+    return;
+  }
+
+  using namespace std::placeholders;    // NOLINT
+  this->srv_ = node->create_service<ServiceT>(
+    "batch",
+    std::bind(&Batch::onServiceCall, this, _1, _2));
+}
+
+void Batch::onServiceCall(
+  const std::shared_ptr<rmw_request_id_t> header,
+  const ServiceT::Request::SharedPtr req)
+{
+  auto res = std::make_shared<ServiceT::Response>();
+  res->result = false;
+  if (!this->mg400_interface_->ok()) {
+    RCLCPP_ERROR(this->base_node_->get_logger(), "MG400 is not connected");
+    this->srv_->send_response(*header, *res);
+    return;
+  }
+
+  auto srv = this->srv_;
+  auto logger = this->base_node_->get_logger();
+  this->commander_->sendBatch(
+    req->commands,
+    [srv, header, res, logger, commands = req->commands](
+      std::vector<mg400_interface::DashboardCommander::BatchResult> results) {
+      res->result = true;
+      for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].ok) {
+          RCLCPP_ERROR(logger, "%s: %s", commands[i].c_str(), results[i].error.c_str());
+          res->result = false;
+        }
+        res->results.push_back(results[i].ok);
+        res->responses.push_back(results[i].response);
+      }
+      srv->send_response(*header, *res);
+    });
+}
+}  // namespace mg400_plugin
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  mg400_plugin::Batch,
+  mg400_plugin_base::DashboardApiPluginBase)
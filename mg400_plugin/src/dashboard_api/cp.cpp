@@ -33,22 +33,32 @@ void CP::configure(
 }
 
 void CP::onServiceCall(
-  const ServiceT::Request::SharedPtr req,
-  ServiceT::Response::SharedPtr res)
+  const std::shared_ptr<rmw_request_id_t> header,
+  const ServiceT::Request::SharedPtr req)
 {
+  auto res = std::make_shared<ServiceT::Response>();
   res->result = false;
-  if (this->mg400_interface_->ok()) {
-    try {
-      this->commander_->cp(req->r);
-      res->result = true;
-    } catch (const std::runtime_error & ex) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), ex.what());
-    } catch (...) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), "Interface Error");
-    }
-  } else {
+  if (!this->mg400_interface_->ok()) {
     RCLCPP_ERROR(this->base_node_->get_logger(), "MG400 is not connected");
+    this->srv_->send_response(*header, *res);
+    return;
   }
+
+  auto srv = this->srv_;
+  auto logger = this->base_node_->get_logger();
+  this->commander_->cp(
+    req->r,
+    [srv, header, res, logger](std::future<void> result) {
+      try {
+        result.get();
+        res->result = true;
+      } catch (const std::runtime_error & ex) {
+        RCLCPP_ERROR(logger, ex.what());
+      } catch (...) {
+        RCLCPP_ERROR(logger, "Interface Error");
+      }
+      srv->send_response(*header, *res);
+    });
 }
 }  // namespace mg400_plugin
 
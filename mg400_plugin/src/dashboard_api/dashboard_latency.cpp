@@ -0,0 +1,104 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_plugin/dashboard_api/dashboard_latency.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace mg400_plugin
+{
+void DashboardLatency::configure(
+  const mg400_interface::DashboardCommander::SharedPtr commander,
+  const rclcpp::Node::SharedPtr node,
+  const mg400_interface::MG400Interface::SharedPtr mg400_if)
+{
+  if (!this->configure_base(commander, node, mg400_if)) {
+    return;
+  }
+
+  using namespace std::placeholders;  // NOLINT
+  this->srv_ = node->create_service<ServiceT>(
+    "get_command_latency",
+    std::bind(&DashboardLatency::onServiceCall, this, _1, _2));
+
+  const double period = node->declare_parameter<double>("dashboard_latency.period_s", 10.0);
+  if (period <= 0.0) {
+    // Service only
+    return;
+  }
+  this->pub_ = node->create_publisher<MsgT>("dashboard_latency", rclcpp::QoS(1));
+  this->timer_ = node->create_wall_timer(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(period)),
+    std::bind(&DashboardLatency::onTimer, this));
+}
+
+void DashboardLatency::onServiceCall(
+  const std::shared_ptr<rmw_request_id_t> header,
+  const ServiceT::Request::SharedPtr req)
+{
+  // Recorded locally: answered even while disconnected
+  auto res = std::make_shared<ServiceT::Response>();
+  res->latencies = this->takeLatencies(req->functions);
+  res->result = true;
+  this->srv_->send_response(*header, *res);
+}
+
+void DashboardLatency::onTimer()
+{
+  auto msg = std::make_unique<MsgT>();
+  msg->header.stamp = this->base_node_->now();
+  msg->latencies = this->takeLatencies({});
+  if (msg->latencies.empty()) {
+    return;
+  }
+  this->pub_->publish(std::move(msg));
+}
+
+std::vector<mg400_msgs::msg::CommandLatency> DashboardLatency::takeLatencies(
+  const std::vector<std::string> & functions) const
+{
+  constexpr double TO_MS = 1e-3;
+  std::vector<mg400_msgs::msg::CommandLatency> ret;
+  for (const auto & stats : this->commander_->getLatencyStats()) {
+    if (!functions.empty() &&
+      std::find(functions.begin(), functions.end(), stats.first) == functions.end())
+    {
+      continue;
+    }
+    const auto & summary = stats.second;
+    mg400_msgs::msg::CommandLatency latency;
+    latency.function = stats.first;
+    latency.count = summary.count;
+    latency.timeouts = summary.timeouts;
+    latency.errors = summary.errors;
+    latency.mean_ms = summary.mean_us * TO_MS;
+    latency.p50_ms = static_cast<double>(summary.p50_us) * TO_MS;
+    latency.p90_ms = static_cast<double>(summary.p90_us) * TO_MS;
+    latency.p99_ms = static_cast<double>(summary.p99_us) * TO_MS;
+    latency.max_ms = static_cast<double>(summary.max_us) * TO_MS;
+    for (const auto & bucket : summary.buckets) {
+      latency.bucket_upper_ms.push_back(static_cast<double>(bucket.first) * TO_MS);
+      latency.bucket_counts.push_back(bucket.second);
+    }
+    ret.push_back(std::move(latency));
+  }
+  return ret;
+}
+}  // namespace mg400_plugin
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  mg400_plugin::DashboardLatency,
+  mg400_plugin_base::DashboardApiPluginBase)
@@ -33,26 +33,35 @@ void GetAngle::configure(
 }
 
 void GetAngle::onServiceCall(
-  const ServiceT::Request::SharedPtr,
-  ServiceT::Response::SharedPtr res)
+  const std::shared_ptr<rmw_request_id_t> header,
+  const ServiceT::Request::SharedPtr)
 {
-  if (this->mg400_interface_->ok()) {
-    try {
-      auto joints = this->commander_->getAngle();
-      res->joint1 = joints[0];
-      res->joint2 = joints[1];
-      res->joint3 = joints[2];
-      res->joint4 = joints[3];
-      res->joint5 = joints[4];
-      res->joint6 = joints[5];
-    } catch (const std::runtime_error & ex) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), ex.what());
-    } catch (...) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), "Interface Error");
-    }
-  } else {
+  auto res = std::make_shared<ServiceT::Response>();
+  if (!this->mg400_interface_->ok()) {
     RCLCPP_ERROR(this->base_node_->get_logger(), "MG400 is not connected");
+    this->srv_->send_response(*header, *res);
+    return;
   }
+
+  auto srv = this->srv_;
+  auto logger = this->base_node_->get_logger();
+  this->commander_->getAngle(
+    [srv, header, res, logger](std::future<std::vector<double>> result) {
+      try {
+        const auto joints = result.get();
+        res->joint1 = joints[0];
+        res->joint2 = joints[1];
+        res->joint3 = joints[2];
+        res->joint4 = joints[3];
+        res->joint5 = joints[4];
+        res->joint6 = joints[5];
+      } catch (const std::runtime_error & ex) {
+        RCLCPP_ERROR(logger, ex.what());
+      } catch (...) {
+        RCLCPP_ERROR(logger, "Interface Error");
+      }
+      srv->send_response(*header, *res);
+    });
 }
 }  // namespace mg400_plugin
 
@@ -33,26 +33,35 @@ void GetPose::configure(
 }
 
 void GetPose::onServiceCall(
-  const ServiceT::Request::SharedPtr,
-  ServiceT::Response::SharedPtr res)
+  const std::shared_ptr<rmw_request_id_t> header,
+  const ServiceT::Request::SharedPtr)
 {
-  if (this->mg400_interface_->ok()) {
-    try {
-      auto poses = this->commander_->getPose();
-      res->pose1 = poses[0];
-      res->pose2 = poses[1];
-      res->pose3 = poses[2];
-      res->pose4 = poses[3];
-      res->pose5 = poses[4];
-      res->pose6 = poses[5];
-    } catch (const std::runtime_error & ex) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), ex.what());
-    } catch (...) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), "Interface Error");
-    }
-  } else {
+  auto res = std::make_shared<ServiceT::Response>();
+  if (!this->mg400_interface_->ok()) {
     RCLCPP_ERROR(this->base_node_->get_logger(), "MG400 is not connected");
+    this->srv_->send_response(*header, *res);
+    return;
   }
+
+  auto srv = this->srv_;
+  auto logger = this->base_node_->get_logger();
+  this->commander_->getPose(
+    [srv, header, res, logger](std::future<std::vector<double>> result) {
+      try {
+        const auto poses = result.get();
+        res->pose1 = poses[0];
+        res->pose2 = poses[1];
+        res->pose3 = poses[2];
+        res->pose4 = poses[3];
+        res->pose5 = poses[4];
+        res->pose6 = poses[5];
+      } catch (const std::runtime_error & ex) {
+        RCLCPP_ERROR(logger, ex.what());
+      } catch (...) {
+        RCLCPP_ERROR(logger, "Interface Error");
+      }
+      srv->send_response(*header, *res);
+    });
 }
 }  // namespace mg400_plugin
 
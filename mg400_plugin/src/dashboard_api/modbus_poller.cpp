@@ -0,0 +1,146 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mg400_plugin/dashboard_api/modbus_poller.hpp>
+
+namespace mg400_plugin
+{
+ModbusPoller::~ModbusPoller()
+{
+  if (this->timer_) {
+    this->timer_->cancel();
+  }
+  // Waits for the poll in flight, then closes the Modbus connection
+  this->poller_.reset();
+}
+
+void ModbusPoller::configure(
+  const mg400_interface::DashboardCommander::SharedPtr commander,
+  const rclcpp::Node::SharedPtr node,
+  const mg400_interface::MG400Interface::SharedPtr mg400_if)
+{
+  if (!this->configure_base(commander, node, mg400_if)) {
+    return;
+  }
+
+  this->ip_ = node->declare_parameter<std::string>("modbus.ip", "");
+  this->port_ = node->declare_parameter<int>("modbus.port", 502);
+  this->slave_id_ = node->declare_parameter<int>("modbus.slave_id", 1);
+  this->is_rtu_ = node->declare_parameter<bool>("modbus.is_rtu", false);
+  const double rate = node->declare_parameter<double>("modbus.rate_hz", 10.0);
+
+  mg400_interface::ModbusPoller::Limits limits;
+  limits.max_gap = node->declare_parameter<int>("modbus.max_gap", 0);
+  limits.max_bits = node->declare_parameter<int>("modbus.max_bits", 16);
+  limits.max_registers = node->declare_parameter<int>("modbus.max_registers", 4);
+
+  if (this->ip_.empty() || rate <= 0.0) {
+    RCLCPP_ERROR(
+      node->get_logger(), "Set modbus.ip and a positive modbus.rate_hz to poll Modbus");
+    return;
+  }
+
+  try {
+    this->poller_ = std::make_unique<mg400_interface::ModbusPoller>(commander.get(), limits);
+    this->addRanges(Table::COIL, "coils");
+    this->addRanges(Table::DISCRETE_INPUT, "discrete_inputs");
+    this->addRanges(Table::INPUT_REGISTER, "input_registers");
+    this->addRanges(Table::HOLDING_REGISTER, "holding_registers");
+  } catch (const std::runtime_error & ex) {
+    RCLCPP_ERROR(node->get_logger(), "%s", ex.what());
+    this->poller_.reset();
+    return;
+  }
+
+  // Only changes are published: keep a few in case they come in bursts
+  this->pubs_[static_cast<size_t>(Table::COIL)] =
+    node->create_publisher<MsgT>("modbus/coils", rclcpp::QoS(10));
+  this->pubs_[static_cast<size_t>(Table::DISCRETE_INPUT)] =
+    node->create_publisher<MsgT>("modbus/discrete_inputs", rclcpp::QoS(10));
+  this->pubs_[static_cast<size_t>(Table::INPUT_REGISTER)] =
+    node->create_publisher<MsgT>("modbus/input_registers", rclcpp::QoS(10));
+  this->pubs_[static_cast<size_t>(Table::HOLDING_REGISTER)] =
+    node->create_publisher<MsgT>("modbus/holding_registers", rclcpp::QoS(10));
+
+  this->timer_ = node->create_wall_timer(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(1.0 / rate)),
+    std::bind(&ModbusPoller::onTimer, this));
+}
+
+void ModbusPoller::addRanges(const Table table, const std::string & name)
+{
+  const auto ranges = this->base_node_->declare_parameter<std::vector<int64_t>>(
+    "modbus." + name, std::vector<int64_t>());
+  if (ranges.size() % 2 != 0) {
+    throw std::runtime_error("modbus." + name + " must be pairs of address and count");
+  }
+  for (size_t i = 0; i < ranges.size(); i += 2) {
+    this->poller_->addRange(
+      table, static_cast<int>(ranges.at(i)), static_cast<int>(ranges.at(i + 1)));
+  }
+}
+
+void ModbusPoller::onTimer()
+{
+  const auto logger = this->base_node_->get_logger();
+  if (!this->mg400_interface_->ok()) {
+    // The Modbus index does not survive a reconnection
+    try {
+      this->poller_->close();
+    } catch (const std::runtime_error &) {
+      // Already gone with the connection
+    }
+    return;
+  }
+
+  try {
+    if (!this->poller_->isOpen()) {
+      this->poller_->open(this->ip_, this->port_, this->slave_id_, this->is_rtu_);
+      RCLCPP_INFO(
+        logger, "Polling Modbus device at %s:%d", this->ip_.c_str(), this->port_);
+    }
+    // Skipped while the previous poll is still in flight
+    this->poller_->poll(
+      [this](std::vector<mg400_interface::ModbusPoller::Change> changes) {
+        this->publish(changes);
+      });
+  } catch (const std::runtime_error & ex) {
+    RCLCPP_WARN_THROTTLE(
+      logger, *this->base_node_->get_clock(), 5000, "Modbus: %s", ex.what());
+  }
+}
+
+void ModbusPoller::publish(
+  const std::vector<mg400_interface::ModbusPoller::Change> & changes)
+{
+  if (changes.empty()) {
+    return;
+  }
+  const auto stamp = this->base_node_->now();
+  for (const auto & change : changes) {
+    auto msg = std::make_unique<MsgT>();
+    msg->header.stamp = stamp;
+    msg->table = static_cast<MsgT::_table_type>(change.table);
+    msg->addresses.assign(change.addresses.begin(), change.addresses.end());
+    msg->values.assign(change.values.begin(), change.values.end());
+    this->pubs_[static_cast<size_t>(change.table)]->publish(std::move(msg));
+  }
+}
+}  // namespace mg400_plugin
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  mg400_plugin::ModbusPoller,
+  mg400_plugin_base::DashboardApiPluginBase)
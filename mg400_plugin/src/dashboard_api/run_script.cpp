@@ -0,0 +1,197 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_plugin/dashboard_api/run_script.hpp"
+
+namespace mg400_plugin
+{
+
+void RunScript::configure(
+  const mg400_interface::DashboardCommander::SharedPtr commander,
+  const rclcpp::Node::SharedPtr node,
+  const mg400_interface::MG400Interface::SharedPtr mg400_if)
+{
+  if (!this->configure_base(commander, node, mg400_if)) {
+    return;
+  }
+
+  using namespace std::placeholders;  // NOLINT
+
+  this->action_server_ =
+    rclcpp_action::create_server<ActionT>(
+    this->base_node_.get(), "run_script",
+    std::bind(&RunScript::handle_goal, this, _1, _2),
+    std::bind(&RunScript::handle_cancel, this, _1),
+    std::bind(&RunScript::handle_accepted, this, _1));
+}
+
+rclcpp_action::GoalResponse RunScript::handle_goal(
+  const rclcpp_action::GoalUUID &, ActionT::Goal::ConstSharedPtr goal)
+{
+  if (!this->mg400_interface_->ok()) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "MG400 is not connected");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  using RobotMode = mg400_msgs::msg::RobotMode;
+  if (!this->mg400_interface_->realtime_tcp_interface->isRobotMode(RobotMode::ENABLE)) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Robot mode is not enabled");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (goal->name.empty()) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Script name is empty");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (this->is_busy_.exchange(true)) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Another script is running");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+rclcpp_action::CancelResponse RunScript::handle_cancel(
+  const std::shared_ptr<GoalHandle>)
+{
+  RCLCPP_INFO(
+    this->base_node_->get_logger(), "Received request to cancel goal");
+  // Stopped by the execution thread, which then reports it canceled
+  return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+void RunScript::handle_accepted(
+  const std::shared_ptr<GoalHandle> goal_handle)
+{
+  using namespace std::placeholders;  // NOLINT
+  std::thread{std::bind(&RunScript::execute, this, _1), goal_handle}.detach();
+}
+
+void RunScript::execute(const std::shared_ptr<GoalHandle> goal_handle)
+{
+  using namespace std::chrono_literals;  // NOLINT
+  // Feedback arrives every 8 ms
+  rclcpp::Rate control_freq(125);  // Hz
+  const auto feedback_period = 100ms;
+
+  const auto & goal = goal_handle->get_goal();
+  const auto logger = this->base_node_->get_logger();
+  const auto realtime = this->mg400_interface_->realtime_tcp_interface;
+
+  auto feedback = std::make_shared<ActionT::Feedback>();
+  auto result = std::make_shared<ActionT::Result>();
+  result->result = false;
+
+  const auto finish = [&](const mg400_interface::ScriptTracker::Progress & progress) {
+      this->fill(progress, *result);
+      this->is_busy_.store(false);
+    };
+
+  // Starts from the last packet before sending, so no transition is missed
+  mg400_interface::ScriptTracker tracker;
+  int64_t last_stamp_ns = realtime->getSnapshot().stamp_ns;
+  tracker.start(last_stamp_ns);
+  try {
+    this->commander_->runScript(goal->name);
+  } catch (const std::exception & ex) {
+    // Also TcpSocketException once disconnected
+    RCLCPP_ERROR(logger, "RunScript(%s): %s", goal->name.c_str(), ex.what());
+    auto progress = tracker.getProgress();
+    progress.state = mg400_interface::ScriptTracker::State::FAILED;
+    finish(progress);
+    goal_handle->abort(result);
+    return;
+  }
+
+  bool is_stop_sent = false;
+  auto last_feedback = std::chrono::steady_clock::now();
+  while (!tracker.isDone()) {
+    if (!this->mg400_interface_->ok()) {
+      RCLCPP_ERROR(logger, "MG400 Connection Error");
+      auto progress = tracker.getProgress();
+      progress.state = mg400_interface::ScriptTracker::State::FAILED;
+      finish(progress);
+      goal_handle->abort(result);
+      return;
+    }
+
+    if (goal_handle->is_canceling() && !is_stop_sent) {
+      try {
+        this->commander_->stopScript();
+        tracker.stop();
+        is_stop_sent = true;
+      } catch (const std::exception & ex) {
+        // Tried again on the next cycle
+        RCLCPP_ERROR(logger, "StopScript(): %s", ex.what());
+      }
+    }
+
+    const auto snapshot = realtime->getSnapshot();
+    bool is_changed = false;
+    if (snapshot.active && snapshot.stamp_ns != last_stamp_ns) {
+      last_stamp_ns = snapshot.stamp_ns;
+      is_changed = tracker.update(snapshot.robot_mode, snapshot.stamp_ns);
+    }
+
+    const auto progress = tracker.getProgress();
+    if (is_changed) {
+      RCLCPP_INFO(
+        logger, "Script %s: %s", goal->name.c_str(),
+        mg400_interface::ScriptTracker::toString(progress.state));
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (!tracker.isDone() && (is_changed || now - last_feedback >= feedback_period)) {
+      this->fill(progress, *feedback);
+      feedback->pauses = progress.pauses;
+      goal_handle->publish_feedback(feedback);
+      last_feedback = now;
+    }
+
+    if (!tracker.isDone()) {
+      control_freq.sleep();
+    }
+  }
+
+  const auto progress = tracker.getProgress();
+  finish(progress);
+  using State = mg400_interface::ScriptTracker::State;
+  if (progress.state == State::FINISHED) {
+    result->result = true;
+    goal_handle->succeed(result);
+  } else if (progress.state == State::STOPPED && goal_handle->is_canceling()) {
+    goal_handle->canceled(result);
+  } else {
+    RCLCPP_ERROR(logger, "Script %s did not finish", goal->name.c_str());
+    goal_handle->abort(result);
+  }
+}
+
+template<typename T>
+void RunScript::fill(const mg400_interface::ScriptTracker::Progress & progress, T & msg)
+{
+  msg.state = mg400_interface::ScriptTracker::toString(progress.state);
+  msg.running = rclcpp::Duration(progress.running);
+  msg.paused = rclcpp::Duration(progress.paused);
+}
+}  // namespace mg400_plugin
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  mg400_plugin::RunScript,
+  mg400_plugin_base::DashboardApiPluginBase)
@@ -0,0 +1,325 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_plugin/motion_api/follow_path.hpp"
+
+#include <vector>
+
+namespace mg400_plugin
+{
+
+void FollowPath::configure(
+  const mg400_interface::MotionCommander::SharedPtr commander,
+  const rclcpp::Node::SharedPtr node,
+  const mg400_interface::MG400Interface::SharedPtr mg400_if)
+{
+  if (!this->configure_base(commander, node, mg400_if)) {
+    return;
+  }
+
+  const int max_in_flight = node->declare_parameter<int>("follow_path.max_in_flight", 4);
+  if (max_in_flight < 1) {
+    RCLCPP_ERROR(node->get_logger(), "follow_path.max_in_flight must be positive");
+    return;
+  }
+  this->mg400_interface_->motion_queue->setDepth(static_cast<size_t>(max_in_flight));
+
+  // setup for using tf handler
+  tf_handler_ = std::make_shared<h6x_tf_handler::PoseTfHandler>(
+    node->get_node_clock_interface(), node->get_node_logging_interface());
+  tf_handler_->configure();
+  tf_handler_->setDistFrameId(
+    this->mg400_interface_->realtime_tcp_interface->frame_id_prefix + "mg400_origin_link");
+  tf_handler_->activate();
+
+  using namespace std::placeholders;  // NOLINT
+
+  this->action_server_ =
+    rclcpp_action::create_server<ActionT>(
+    this->base_node_.get(), "follow_path",
+    std::bind(&FollowPath::handle_goal, this, _1, _2),
+    std::bind(&FollowPath::handle_cancel, this, _1),
+    std::bind(&FollowPath::handle_accepted, this, _1));
+}
+
+rclcpp_action::GoalResponse FollowPath::handle_goal(
+  const rclcpp_action::GoalUUID &, ActionT::Goal::ConstSharedPtr goal)
+{
+  if (!this->mg400_interface_->ok()) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "MG400 is not connected");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  using RobotMode = mg400_msgs::msg::RobotMode;
+  if (!this->mg400_interface_->realtime_tcp_interface->isRobotMode(RobotMode::ENABLE)) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Robot mode is not enabled");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (goal->waypoints.empty()) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Path has no waypoint");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  using Waypoint = mg400_msgs::msg::Waypoint;
+  for (const auto & waypoint : goal->waypoints) {
+    if (waypoint.motion_type != Waypoint::MOV_J && waypoint.motion_type != Waypoint::MOV_L) {
+      RCLCPP_ERROR(
+        this->base_node_->get_logger(), "Invalid motion type: %u", waypoint.motion_type);
+      return rclcpp_action::GoalResponse::REJECT;
+    }
+    if (waypoint.cp > 100 || waypoint.blend_radius < 0.0) {
+      RCLCPP_ERROR(
+        this->base_node_->get_logger(), "cp must be within [0, 100] and blend_radius positive");
+      return rclcpp_action::GoalResponse::REJECT;
+    }
+  }
+
+  if (this->is_busy_.exchange(true)) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Another path is running");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+rclcpp_action::CancelResponse FollowPath::handle_cancel(
+  const std::shared_ptr<GoalHandle>)
+{
+  RCLCPP_INFO(
+    this->base_node_->get_logger(), "Received request to cancel goal");
+  // No more waypoints are sent. The ones already sent run to their end.
+  return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+void FollowPath::handle_accepted(
+  const std::shared_ptr<GoalHandle> goal_handle)
+{
+  // In the order of acceptance, before the thread starts
+  const auto owner = this->mg400_interface_->motion_preemptor->acquire();
+  using namespace std::placeholders;  // NOLINT
+  std::thread{std::bind(&FollowPath::execute, this, _1, _2), goal_handle, owner}.detach();
+}
+
+void FollowPath::execute(
+  const std::shared_ptr<GoalHandle> goal_handle,
+  const mg400_interface::MotionPreemptor::Owner owner)
+{
+  using namespace std::chrono_literals;  // NOLINT
+  // Feedback arrives every 8 ms
+  rclcpp::Rate control_freq(125);  // Hz
+  const auto feedback_period = 100ms;
+
+  using mg400_interface::MotionQueue;
+  using mg400_msgs::msg::Waypoint;
+  using mg400_msgs::msg::WaypointProgress;
+
+  const auto & goal = goal_handle->get_goal();
+  const auto logger = this->base_node_->get_logger();
+  const auto queue = this->mg400_interface_->motion_queue;
+  const auto preemptor = this->mg400_interface_->motion_preemptor;
+  const size_t size = goal->waypoints.size();
+
+  auto feedback = std::make_shared<ActionT::Feedback>();
+  auto result = std::make_shared<ActionT::Result>();
+  result->result = false;
+
+  // Hand over from the goal preempted, if any
+  if (!preemptor->waitForStop(owner)) {
+    RCLCPP_ERROR(logger, "Previous motion not stopped");
+    preemptor->release(owner);
+    this->is_busy_.store(false);
+    goal_handle->abort(result);
+    return;
+  }
+
+  // tf (from each waypoint to the origin of the arm)
+  std::vector<MotionQueue::Move> moves;
+  moves.reserve(size);
+  for (const auto & waypoint : goal->waypoints) {
+    geometry_msgs::msg::PoseStamped tf_pose;
+    tf_handler_->tfHeader2Dist(waypoint.pose, tf_pose);
+    const auto & p = tf_pose.pose.position;
+    const double r = tf2::getYaw(tf_pose.pose.orientation);
+    auto move = waypoint.motion_type == Waypoint::MOV_L ?
+      MotionQueue::movL(p.x, p.y, p.z, r) : MotionQueue::movJ(p.x, p.y, p.z, r);
+    move.cp = waypoint.cp;
+    move.blend_zone = waypoint.blend_radius;
+    moves.push_back(move);
+  }
+
+  result->waypoints.resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    result->waypoints[i].index = static_cast<uint32_t>(i);
+    result->waypoints[i].state = WaypointProgress::PENDING;
+  }
+  auto & progress = result->waypoints;
+  std::vector<uint64_t> ids(size, 0);
+
+  const auto update_pose =
+    [&](geometry_msgs::msg::PoseStamped & msg) -> void
+    {
+      msg.header.stamp = this->base_node_->get_clock()->now();
+      msg.header.frame_id =
+        this->mg400_interface_->realtime_tcp_interface->frame_id_prefix + "mg400_origin_link";
+      this->mg400_interface_->realtime_tcp_interface->getCurrentEndPose(msg.pose);
+    };
+
+  const auto is_over = [](const WaypointProgress & waypoint) {
+      return waypoint.state == WaypointProgress::DONE ||
+             waypoint.state == WaypointProgress::FAILED;
+    };
+
+  size_t next = 0;
+  uint32_t done = 0;
+  bool is_failed = false;
+  auto last_feedback = std::chrono::steady_clock::now();
+  while (true) {
+    if (!preemptor->isOwner(owner)) {
+      // The newer goal stopped the arm and dropped the queue
+      RCLCPP_WARN(logger, "Preempted by a newer goal");
+      this->is_busy_.store(false);
+      goal_handle->abort(result);
+      return;
+    }
+
+    if (!this->mg400_interface_->ok()) {
+      RCLCPP_ERROR(logger, "MG400 Connection Error");
+      preemptor->release(owner);
+      this->is_busy_.store(false);
+      goal_handle->abort(result);
+      return;
+    }
+
+    // Keep the planner fed up to the depth of the queue
+    const bool is_sending = !goal_handle->is_canceling() && !is_failed;
+    while (is_sending && next < size) {
+      uint64_t id = 0;
+      try {
+        // Not after a newer goal stopped the arm
+        const bool is_owner = preemptor->sendIfOwner(
+          owner, [&]() {id = queue->tryPush(moves[next]);});
+        if (!is_owner) {
+          break;
+        }
+      } catch (const std::exception & ex) {
+        // TcpSocketException once disconnected
+        RCLCPP_ERROR(logger, "Waypoint %zu: %s", next, ex.what());
+        is_failed = true;
+        break;
+      }
+      if (id == 0) {
+        break;
+      }
+      ids[next] = id;
+      progress[next].state = WaypointProgress::SENT;
+      feedback->waypoints.push_back(progress[next]);
+      ++next;
+    }
+
+    bool is_pending = false;
+    for (size_t i = 0; i < next; ++i) {
+      if (is_over(progress[i])) {
+        continue;
+      }
+      MotionQueue::Record record;
+      const bool is_known = queue->getRecord(ids[i], record);
+      if (!is_known) {
+        // Dropped from the history: never followed that long
+        record.state = MotionQueue::State::FAILED;
+      }
+      if (this->fill(record, progress[i])) {
+        feedback->waypoints.push_back(progress[i]);
+        if (progress[i].state == WaypointProgress::DONE) {
+          ++done;
+        } else if (progress[i].state == WaypointProgress::FAILED) {
+          RCLCPP_ERROR(logger, "Waypoint %zu failed", i);
+          is_failed = true;
+        }
+      }
+      is_pending |= !is_over(progress[i]);
+    }
+
+    const bool is_finished = !is_pending &&
+      (next == size || is_failed || goal_handle->is_canceling());
+    const auto now = std::chrono::steady_clock::now();
+    if (!is_finished && (!feedback->waypoints.empty() || now - last_feedback >= feedback_period)) {
+      feedback->done = done;
+      update_pose(feedback->current_pose);
+      goal_handle->publish_feedback(feedback);
+      feedback->waypoints.clear();
+      last_feedback = now;
+    }
+
+    if (is_finished) {
+      break;
+    }
+    control_freq.sleep();
+  }
+
+  preemptor->release(owner);
+  this->is_busy_.store(false);
+  if (is_failed) {
+    goal_handle->abort(result);
+  } else if (next < size) {
+    goal_handle->canceled(result);
+  } else {
+    result->result = true;
+    goal_handle->succeed(result);
+  }
+}
+
+bool FollowPath::fill(
+  const mg400_interface::MotionQueue::Record & record,
+  mg400_msgs::msg::WaypointProgress & msg)
+{
+  using mg400_interface::MotionQueue;
+  using mg400_msgs::msg::WaypointProgress;
+  uint8_t state = WaypointProgress::PENDING;
+  switch (record.state) {
+    case MotionQueue::State::SENT:
+      state = WaypointProgress::SENT;
+      break;
+    case MotionQueue::State::RUNNING:
+      state = WaypointProgress::RUNNING;
+      break;
+    case MotionQueue::State::DONE:
+      state = WaypointProgress::DONE;
+      break;
+    case MotionQueue::State::FAILED:
+      state = WaypointProgress::FAILED;
+      break;
+  }
+  if (state == msg.state) {
+    return false;
+  }
+  msg.state = state;
+  if (record.start_ns != 0) {
+    msg.start = rclcpp::Time(record.start_ns, RCL_SYSTEM_TIME);
+  }
+  if (record.end_ns != 0) {
+    msg.end = rclcpp::Time(record.end_ns, RCL_SYSTEM_TIME);
+  }
+  return true;
+}
+}  // namespace mg400_plugin
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  mg400_plugin::FollowPath,
+  mg400_plugin_base::MotionApiPluginBase)
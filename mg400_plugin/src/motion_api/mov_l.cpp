@@ -53,8 +53,12 @@ rclcpp_action::GoalResponse MovL::handle_goal(
     return rclcpp_action::GoalResponse::REJECT;
   }
 
+  // Running: a newer goal preempts the one moving the arm
   using RobotMode = mg400_msgs::msg::RobotMode;
-  if (!this->mg400_interface_->realtime_tcp_interface->isRobotMode(RobotMode::ENABLE)) {
+  const auto & realtime_tcp_interface = this->mg400_interface_->realtime_tcp_interface;
+  if (!realtime_tcp_interface->isRobotMode(RobotMode::ENABLE) &&
+    !realtime_tcp_interface->isRobotMode(RobotMode::RUNNING))
+  {
     RCLCPP_ERROR(
       this->base_node_->get_logger(), "Robot mode is not enabled");
     return rclcpp_action::GoalResponse::REJECT;
@@ -64,23 +68,38 @@ rclcpp_action::GoalResponse MovL::handle_goal(
 }
 
 rclcpp_action::CancelResponse MovL::handle_cancel(
-  const std::shared_ptr<GoalHandle>)
+  const std::shared_ptr<GoalHandle> goal_handle)
 {
   RCLCPP_INFO(
     this->base_node_->get_logger(), "Received request to cancel goal");
-  // TODO(anyone): Should stop movL
+  // Stopped right away, execute() waits for the feedback to confirm it
+  std::lock_guard<std::mutex> lock(this->owners_mutex_);
+  const auto it = this->owners_.find(goal_handle->get_goal_id());
+  if (it != this->owners_.end()) {
+    this->mg400_interface_->motion_preemptor->requestStop(it->second);
+  }
   return rclcpp_action::CancelResponse::ACCEPT;
 }
 
 void MovL::handle_accepted(
   const std::shared_ptr<GoalHandle> goal_handle)
 {
-  using namespace std::placeholders;  // NOLINT
-  std::thread{std::bind(&MovL::execute, this, _1), goal_handle}.detach();
+  // In the order of acceptance, before the thread starts
+  const auto owner = this->mg400_interface_->motion_preemptor->acquire();
+  {
+    std::lock_guard<std::mutex> lock(this->owners_mutex_);
+    this->owners_[goal_handle->get_goal_id()] = owner;
+  }
+  std::thread{
+    [this, goal_handle, owner]() {
+      this->execute(goal_handle, owner);
+      std::lock_guard<std::mutex> lock(this->owners_mutex_);
+      this->owners_.erase(goal_handle->get_goal_id());
+    }}.detach();
 }
 
 
-void MovL::execute(const std::shared_ptr<GoalHandle> goal_handle)
+void MovL::execute(const std::shared_ptr<GoalHandle> goal_handle, const Owner owner)
 {
   rclcpp::Rate control_freq(10);  // Hz
 
@@ -94,9 +113,33 @@ void MovL::execute(const std::shared_ptr<GoalHandle> goal_handle)
   auto result = std::make_shared<mg400_msgs::action::MovL::Result>();
   result->result = false;
 
-  this->commander_->movL(
-    tf_goal.pose.position.x, tf_goal.pose.position.y, tf_goal.pose.position.z,
-    tf2::getYaw(tf_goal.pose.orientation));
+  const auto logger = this->base_node_->get_logger();
+  const auto preemptor = this->mg400_interface_->motion_preemptor;
+
+  // Hand over from the goal preempted, if any
+  if (!preemptor->waitForStop(owner)) {
+    RCLCPP_ERROR(logger, "Previous motion not stopped");
+    preemptor->release(owner);
+    goal_handle->abort(result);
+    return;
+  }
+  if (goal_handle->is_canceling()) {
+    preemptor->release(owner);
+    goal_handle->canceled(result);
+    return;
+  }
+
+  const bool is_sent = preemptor->sendIfOwner(
+    owner, [&]() {
+      this->commander_->movL(
+        tf_goal.pose.position.x, tf_goal.pose.position.y, tf_goal.pose.position.z,
+        tf2::getYaw(tf_goal.pose.orientation));
+    });
+  if (!is_sent) {
+    RCLCPP_WARN(logger, "Preempted by a newer goal");
+    goal_handle->abort(result);
+    return;
+  }
 
   const auto is_goal_reached = [&](
     const geometry_msgs::msg::Pose & pose,
@@ -134,20 +177,39 @@ void MovL::execute(const std::shared_ptr<GoalHandle> goal_handle)
   update_pose(feedback->current_pose);
 
   while (!is_goal_reached(feedback->current_pose.pose, tf_goal.pose)) {
+    if (!preemptor->isOwner(owner)) {
+      // The newer goal stops the arm
+      RCLCPP_WARN(logger, "Preempted by a newer goal");
+      goal_handle->abort(result);
+      return;
+    }
+
+    if (goal_handle->is_canceling()) {
+      if (!preemptor->waitForStop(owner)) {
+        RCLCPP_ERROR(logger, "Motion not stopped on cancel");
+      }
+      preemptor->release(owner);
+      goal_handle->canceled(result);
+      return;
+    }
+
     if (!this->mg400_interface_->ok()) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), "MG400 Connection Error");
+      RCLCPP_ERROR(logger, "MG400 Connection Error");
+      preemptor->release(owner);
       goal_handle->abort(result);
       return;
     }
 
     if (this->mg400_interface_->realtime_tcp_interface->isRobotMode(RobotMode::ERROR)) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), "Robot Mode Error");
+      RCLCPP_ERROR(logger, "Robot Mode Error");
+      preemptor->release(owner);
       goal_handle->abort(result);
       return;
     }
 
     if (this->base_node_->get_clock()->now() - start > timeout) {
-      RCLCPP_ERROR(this->base_node_->get_logger(), "execution timeout");
+      RCLCPP_ERROR(logger, "execution timeout");
+      preemptor->release(owner);
       goal_handle->abort(result);
       return;
     }
@@ -157,6 +219,7 @@ void MovL::execute(const std::shared_ptr<GoalHandle> goal_handle)
     control_freq.sleep();
   }
 
+  preemptor->release(owner);
   result->result = true;
   goal_handle->succeed(result);
 }
@@ -0,0 +1,161 @@
+// Copyright 2022 HarvestX Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mg400_plugin/motion_api/servo.hpp"
+
+namespace mg400_plugin
+{
+void Servo::configure(
+  const mg400_interface::MotionCommander::SharedPtr commander,
+  const rclcpp::Node::SharedPtr node,
+  const mg400_interface::MG400Interface::SharedPtr mg400_if)
+{
+  if (!this->configure_base(commander, node, mg400_if)) {
+    return;
+  }
+
+  using namespace std::chrono_literals;  // NOLINT
+  mg400_interface::ServoStreamer::Config config;
+  config.period = 1ms * node->declare_parameter<int>("servo.period_ms", 8);
+  config.setpoint_timeout = 1ms * node->declare_parameter<int>("servo.setpoint_timeout_ms", 100);
+  config.max_joint_velocity = node->declare_parameter<double>("servo.max_joint_velocity", 1.0);
+  config.max_linear_velocity = node->declare_parameter<double>("servo.max_linear_velocity", 0.2);
+  config.max_angular_velocity =
+    node->declare_parameter<double>("servo.max_angular_velocity", 1.0);
+  config.priority = node->declare_parameter<int>("servo.priority", 0);
+  const double stats_period = node->declare_parameter<double>("servo.stats_period_s", 1.0);
+  if (config.period <= 0ms || config.setpoint_timeout <= 0ms || stats_period <= 0.0) {
+    RCLCPP_ERROR(node->get_logger(), "servo periods and timeout must be positive");
+    return;
+  }
+
+  const auto realtime_tcp_interface = this->mg400_interface_->realtime_tcp_interface;
+  this->streamer_ = std::make_unique<mg400_interface::ServoStreamer>(
+    commander,
+    [realtime_tcp_interface]() {return realtime_tcp_interface->getSnapshot();},
+    config);
+  // MovJ, MovL and FollowPath goals own the motion port while they run
+  const auto preemptor = this->mg400_interface_->motion_preemptor;
+  this->streamer_->setSendGuard(
+    [preemptor](const std::function<void()> & send) {
+      return preemptor->sendIfUnowned(send);
+    });
+
+  // setup for using tf handler
+  tf_handler_ = std::make_shared<h6x_tf_handler::PoseTfHandler>(
+    node->get_node_clock_interface(), node->get_node_logging_interface());
+  tf_handler_->configure();
+  tf_handler_->setDistFrameId(realtime_tcp_interface->frame_id_prefix + "mg400_origin_link");
+  tf_handler_->activate();
+
+  using namespace std::placeholders;  // NOLINT
+  this->joint_sub_ = node->create_subscription<JointMsgT>(
+    "servo/joint_setpoint", rclcpp::QoS(1),
+    std::bind(&Servo::onJointSetpoint, this, _1));
+  this->pose_sub_ = node->create_subscription<PoseMsgT>(
+    "servo/pose_setpoint", rclcpp::QoS(1),
+    std::bind(&Servo::onPoseSetpoint, this, _1));
+
+  this->stats_pub_ = node->create_publisher<StatsMsgT>("servo/stats", rclcpp::QoS(1));
+  this->timer_ = node->create_wall_timer(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(stats_period)),
+    std::bind(&Servo::onTimer, this));
+
+  this->streamer_->start();
+}
+
+void Servo::onJointSetpoint(const JointMsgT::ConstSharedPtr msg)
+{
+  if (msg->position.size() < 4) {
+    RCLCPP_ERROR(
+      this->base_node_->get_logger(), "Joint setpoint needs 4 positions: %zu given",
+      msg->position.size());
+    return;
+  }
+  if (!this->isServoable()) {
+    return;
+  }
+  const auto & p = msg->position;
+  this->streamer_->setJointSetpoint(p[0], p[1], p[2], p[3]);
+}
+
+void Servo::onPoseSetpoint(const PoseMsgT::ConstSharedPtr msg)
+{
+  if (!this->isServoable()) {
+    return;
+  }
+  // tf (from msg->header.frame_id to the origin of the arm)
+  PoseMsgT tf_pose;
+  tf_handler_->tfHeader2Dist(*msg, tf_pose);
+  const auto & p = tf_pose.pose.position;
+  this->streamer_->setPoseSetpoint(p.x, p.y, p.z, tf2::getYaw(tf_pose.pose.orientation));
+}
+
+void Servo::onTimer()
+{
+  if (!this->streamer_->isRunning() && this->mg400_interface_->ok()) {
+    RCLCPP_WARN(this->base_node_->get_logger(), "Restarting servo");
+    this->streamer_->start();
+  }
+
+  constexpr double TO_MS = 1e-3;
+  const auto stats = this->streamer_->getStats();
+  auto msg = std::make_unique<StatsMsgT>();
+  msg->header.stamp = this->base_node_->now();
+  msg->ticks = stats.ticks;
+  msg->sent = stats.sent;
+  msg->overruns = stats.overruns;
+  msg->watchdog_stops = stats.watchdog_stops;
+  msg->limited = stats.limited;
+  msg->jitter_mean_ms = stats.jitter.mean_us * TO_MS;
+  msg->jitter_p50_ms = static_cast<double>(stats.jitter.p50_us) * TO_MS;
+  msg->jitter_p99_ms = static_cast<double>(stats.jitter.p99_us) * TO_MS;
+  msg->jitter_max_ms = static_cast<double>(stats.jitter.max_us) * TO_MS;
+  this->stats_pub_->publish(std::move(msg));
+}
+
+bool Servo::isServoable()
+{
+  if (!this->mg400_interface_->ok()) {
+    RCLCPP_ERROR_THROTTLE(
+      this->base_node_->get_logger(), *this->base_node_->get_clock(), 1000,
+      "MG400 is not connected");
+    return false;
+  }
+  // Running while following the previous setpoints
+  using RobotMode = mg400_msgs::msg::RobotMode;
+  const auto & realtime_tcp_interface = this->mg400_interface_->realtime_tcp_interface;
+  if (!realtime_tcp_interface->isRobotMode(RobotMode::ENABLE) &&
+    !realtime_tcp_interface->isRobotMode(RobotMode::RUNNING))
+  {
+    RCLCPP_ERROR_THROTTLE(
+      this->base_node_->get_logger(), *this->base_node_->get_clock(), 1000,
+      "Robot mode is not enabled");
+    return false;
+  }
+  if (this->mg400_interface_->motion_preemptor->isOwned()) {
+    RCLCPP_ERROR_THROTTLE(
+      this->base_node_->get_logger(), *this->base_node_->get_clock(), 1000,
+      "A motion goal owns the arm");
+    return false;
+  }
+  return true;
+}
+}  // namespace mg400_plugin
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  mg400_plugin::Servo,
+  mg400_plugin_base::MotionApiPluginBase)